@@ -0,0 +1,364 @@
+#include "DistanceMatrix.h"
+#include "FrameArena.h"
+#include "FrameDelta.h"
+#include "Geometry.h"
+#include "MapGrid.h"
+#include "MineralLedger.h"
+#include "SquadClusterer.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sc2;
+
+// Every benchmark runs for at least BENCH_MIN_NS after BENCH_WARMUP calls
+#define BENCH_MIN_NS 200000000.0
+#define BENCH_WARMUP 16
+#define BENCH_MAP_SIZE 200
+#define BENCH_BASES 16
+#define BENCH_PATCHES 8
+#define BENCH_UNIT_TYPES 2048
+
+struct Result {
+    std::string name;
+    double nsPerOp;
+    double allocationsPerOp;
+    uint64_t iterations;
+};
+
+// Deterministic xorshift generator, so every run measures the same states
+struct Random {
+    uint32_t state = 2463534242u;
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    float uniform(float low, float high) { return low + (high - low) * (next() % 10000) / 1e4f; }
+};
+
+/**
+ * @brief Makes a unit with every field the benchmarked functions read.
+ *
+ * @param tag The tag of the unit
+ * @param type The type of the unit
+ * @param pos The position of the unit
+ * @param alliance The owner of the unit
+ * @return Unit The unit
+ */
+static Unit MakeUnit(Tag tag, UNIT_TYPEID type, const Point2D &pos, Unit::Alliance alliance) {
+    Unit unit;
+    unit.tag = tag;
+    unit.unit_type = type;
+    unit.alliance = alliance;
+    unit.display_type = Unit::DisplayType::Visible;
+    unit.pos = Point3D(pos.x, pos.y, 0.0f);
+    unit.health = unit.health_max = 100.0f;
+    unit.shield = unit.shield_max = 0.0f;
+    unit.energy = unit.energy_max = 0.0f;
+    unit.build_progress = 1.0f;
+    unit.mineral_contents = 1800;
+    unit.is_flying = false;
+    unit.is_alive = true;
+    return unit;
+}
+
+/**
+ * @brief Collects pointers to units, the form the observation hands them out in.
+ *
+ * @param units The units
+ * @return Units Pointers to every unit
+ */
+static Units Pointers(const std::vector<Unit> &units) {
+    Units pointers;
+    for(const auto &unit : units) { pointers.push_back(&unit); }
+    return pointers;
+}
+
+/**
+ * @brief Places the resources of BENCH_BASES bases spread over the map.
+ *
+ * @param random The generator to jitter positions with
+ * @return std::vector<Unit> Mineral fields and two geysers per base
+ */
+static std::vector<Unit> MakeResources(Random &random) {
+    std::vector<Unit> resources;
+    Tag tag = 1;
+    for(int base = 0; base < BENCH_BASES; ++base) {
+        const Point2D center(20.0f + (base % 4) * 50.0f, 20.0f + (base / 4) * 50.0f);
+        for(int i = 0; i < BENCH_PATCHES; ++i) {
+            const Point2D pos(center.x + random.uniform(-6.0f, 6.0f),
+                              center.y + random.uniform(-6.0f, 6.0f));
+            resources.push_back(
+              MakeUnit(tag++, UNIT_TYPEID::NEUTRAL_MINERALFIELD, pos, Unit::Alliance::Neutral));
+        }
+        for(int i = 0; i < 2; ++i) {
+            const Point2D pos(center.x + (i == 0 ? -7.0f : 7.0f), center.y + 3.0f);
+            resources.push_back(
+              MakeUnit(tag++, UNIT_TYPEID::NEUTRAL_VESPENEGEYSER, pos, Unit::Alliance::Neutral));
+        }
+    }
+    return resources;
+}
+
+/**
+ * @brief Times a function and counts its heap allocations.
+ *
+ * The iteration count doubles until the measurement lasts BENCH_MIN_NS.
+ *
+ * @param results The results to append to
+ * @param name The name of the benchmark
+ * @param kernel The function to run
+ */
+static void Measure(std::vector<Result> &results, const std::string &name,
+                    const std::function<void()> &kernel) {
+    for(int i = 0; i < BENCH_WARMUP; ++i) { kernel(); }
+    uint64_t iterations = 1;
+    while(true) {
+        const uint64_t allocations = HeapAllocations();
+        const auto start = std::chrono::steady_clock::now();
+        for(uint64_t i = 0; i < iterations; ++i) { kernel(); }
+        const auto end = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        if(ns >= BENCH_MIN_NS) {
+            const double heap = static_cast<double>(HeapAllocations() - allocations);
+            results.push_back({name, ns / iterations, heap / iterations, iterations});
+            std::printf("%-36s %12.1f ns %10.2f allocs\n", name.c_str(), ns / iterations,
+                        heap / iterations);
+            return;
+        }
+        iterations *= 2;
+    }
+}
+
+/**
+ * @brief Writes the results as JSON, for comparing runs with scripts/bench-compare.py.
+ *
+ * @param path The file to write
+ * @param results The results
+ * @return true if the file was written, false otherwise
+ */
+static bool WriteJson(const char *path, const std::vector<Result> &results) {
+    std::FILE *file = std::fopen(path, "w");
+    if(file == nullptr) { return false; }
+    std::fprintf(file, "{\n  \"benchmarks\": [\n");
+    for(std::size_t i = 0; i < results.size(); ++i) {
+        std::fprintf(file,
+                     "    {\"name\": \"%s\", \"ns_per_op\": %.1f, \"allocations_per_op\": %.2f, "
+                     "\"iterations\": %llu}%s\n",
+                     results[i].name.c_str(), results[i].nsPerOp, results[i].allocationsPerOp,
+                     static_cast<unsigned long long>(results[i].iterations),
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    std::fclose(file);
+    return true;
+}
+
+/**
+ * @brief Runs the bot's hot functions on generated unit sets.
+ *
+ * The functions take the units an observation would return, so they run
+ * without a game. Pass a file name to also write the results as JSON.
+ */
+int main(int argc, char *argv[]) {
+    std::vector<Result> results;
+    Random random;
+    volatile std::size_t sink = 0;
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    // Reset before every call that draws from it, like at the start of a step
+    FrameArena arena;
+
+    // Unit type data with a weapon for every combat unit type used below
+    UnitTypes unitData(BENCH_UNIT_TYPES);
+    const UNIT_TYPEID enemyTypes[] = {UNIT_TYPEID::TERRAN_MARINE, UNIT_TYPEID::TERRAN_MARAUDER,
+                                      UNIT_TYPEID::TERRAN_SIEGETANK, UNIT_TYPEID::TERRAN_SCV,
+                                      UNIT_TYPEID::TERRAN_MEDIVAC, UNIT_TYPEID::TERRAN_BARRACKS};
+    for(int i = 0; i < 4; ++i) {
+        Weapon weapon;
+        weapon.damage_ = 6.0f + 4.0f * i;
+        weapon.attacks = 1;
+        weapon.speed = 0.6f + 0.1f * i;
+        unitData[static_cast<uint32_t>(enemyTypes[i])].weapons.push_back(weapon);
+    }
+    const Point2D home(30.0f, 30.0f);
+    const Point2D enemyBase(170.0f, 170.0f);
+    for(const int count : {10, 100, 400, 2000}) {
+        std::vector<Unit> enemies;
+        for(int i = 0; i < count; ++i) {
+            const Point2D pos(random.uniform(10.0f, 190.0f), random.uniform(10.0f, 190.0f));
+            enemies.push_back(MakeUnit(1000 + i, enemyTypes[i % 6], pos, Unit::Alliance::Enemy));
+            enemies.back().is_flying = enemies.back().unit_type == UNIT_TYPEID::TERRAN_MEDIVAC;
+        }
+        const Units units = Pointers(enemies);
+        Measure(results, "FindMostDangerous/" + std::to_string(count), [&] {
+            const Unit *all = nullptr;
+            const Unit *ground = nullptr;
+            FindMostDangerous(
+              units, unitData,
+              [&](const Unit &unit) {
+                  return DistanceSquared2D(unit.pos, enemyBase) < DistanceSquared2D(unit.pos, home);
+              },
+              all, ground);
+            sink = sink + (all != nullptr ? all->tag : 0);
+        });
+        Measure(results, "FindMostDangerous/parallel/" + std::to_string(count), [&] {
+            arena.reset();
+            const Unit *all = nullptr;
+            const Unit *ground = nullptr;
+            FindMostDangerous(
+              units, unitData,
+              [&](const Unit &unit) {
+                  return DistanceSquared2D(unit.pos, enemyBase) < DistanceSquared2D(unit.pos, home);
+              },
+              all, ground, pool, arena);
+            sink = sink + (all != nullptr ? all->tag : 0);
+        });
+    }
+
+    const std::vector<Unit> resources = MakeResources(random);
+    const Units resourceUnits = Pointers(resources);
+    Units minerals;
+    for(const auto *unit : resourceUnits) {
+        if(unit->unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD) { minerals.push_back(unit); }
+    }
+    for(const int count : {16, 48, 80}) {
+        std::vector<Unit> drones;
+        for(int i = 0; i < count; ++i) {
+            const Point2D pos(home.x + random.uniform(-8.0f, 8.0f),
+                              home.y + random.uniform(-8.0f, 8.0f));
+            drones.push_back(
+              MakeUnit(5000 + i, UNIT_TYPEID::ZERG_DRONE, pos, Unit::Alliance::Self));
+            UnitOrder order;
+            order.ability_id = ABILITY_ID::HARVEST_GATHER;
+            order.target_unit_tag = minerals[i % BENCH_PATCHES]->tag;
+            drones.back().orders.push_back(order);
+        }
+        const Units units = Pointers(drones);
+        // One step in which every drone is woken and asks for a mineral field
+        MineralLedger ledger;
+        Measure(results, "MineralLedger/" + std::to_string(count), [&] {
+            ledger.reset(minerals, units);
+            for(const auto *drone : units) {
+                const std::size_t field = ledger.pick(drone, Point2D(20.0f, 20.0f));
+                if(field != GEOMETRY_NONE) { ledger.assign(drone, field); }
+                sink = sink + field;
+            }
+        });
+    }
+
+    Measure(results, "FindResourceClusters/" + std::to_string(BENCH_BASES), [&] {
+        sink = sink + FindResourceClusters(resourceUnits, {enemyBase}).size();
+    });
+
+    // The ordering of FindExpansionLocation, every mineral field by ground distance from the base
+    BitGrid pathing(BENCH_MAP_SIZE, BENCH_MAP_SIZE);
+    pathing.fill(true);
+    for(int y = 0; y < 150; ++y) {
+        pathing.set(95, y, false);
+        pathing.set(96, y, false);
+    }
+    const std::vector<Point2D> keyPoints = FindResourceClusters(resourceUnits);
+    const DistanceMatrix distances = DistanceMatrix::ground(keyPoints, pathing);
+    Measure(results, "SortExpansionMinerals/" + std::to_string(minerals.size()), [&] {
+        Units sorted = minerals;
+        SortExpansionMinerals(sorted, distances, home);
+        sink = sink + sorted.front()->tag;
+    });
+
+    std::vector<Unit> mixed;
+    const UNIT_TYPEID mixedTypes[] = {UNIT_TYPEID::ZERG_DRONE, UNIT_TYPEID::ZERG_HATCHERY,
+                                      UNIT_TYPEID::TERRAN_MARINE, UNIT_TYPEID::PROTOSS_PYLON,
+                                      UNIT_TYPEID::ZERG_ZERGLING};
+    for(int i = 0; i < 400; ++i) {
+        mixed.push_back(MakeUnit(9000 + i, mixedTypes[i % 5], home, Unit::Alliance::Enemy));
+    }
+    Measure(results, "IsBuilding/400", [&] {
+        for(const auto &unit : mixed) { sink = sink + IsBuilding(unit); }
+    });
+
+    // The per-step unit bookkeeping that MasterController::step and the controllers read
+    for(const int count : {50, 200, 400}) {
+        std::vector<Unit> army;
+        for(int i = 0; i < count; ++i) {
+            const Point2D pos(random.uniform(10.0f, 190.0f), random.uniform(10.0f, 190.0f));
+            army.push_back(MakeUnit(20000 + i, UNIT_TYPEID::ZERG_ZERGLING, pos,
+                                    Unit::Alliance::Self));
+        }
+        const Units units = Pointers(army);
+        FrameDelta delta;
+        uint32_t loop = 0;
+        Measure(results, "FrameDelta::update/" + std::to_string(count), [&] {
+            army[loop % count].health -= 1.0f;
+            delta.update(units, ++loop);
+            sink = sink + delta.damaged.size();
+        });
+    }
+
+    // The squad clustering MasterController::step runs on the army first, in a few fights
+    for(const int count : {50, 200, 400}) {
+        std::vector<Unit> army;
+        for(int i = 0; i < count; ++i) {
+            const Point2D center(40.0f + 40.0f * (i % 4), 40.0f + 30.0f * (i % 3));
+            const Point2D pos(center.x + random.uniform(-6.0f, 6.0f),
+                              center.y + random.uniform(-6.0f, 6.0f));
+            army.push_back(MakeUnit(30000 + i, UNIT_TYPEID::ZERG_ROACH, pos,
+                                    Unit::Alliance::Self));
+        }
+        const Units units = Pointers(army);
+        SquadClusterer squads;
+        squads.initialize(BENCH_MAP_SIZE, BENCH_MAP_SIZE);
+        Measure(results, "SquadClusterer::update/" + std::to_string(count), [&] {
+            arena.reset();
+            squads.update(units, unitData, arena);
+            sink = sink + squads.squads.size();
+        });
+    }
+
+    // The batch geometry kernels against the plain loop they replace
+    for(const int count : {10, 100, 1000}) {
+        std::vector<Point2D> points;
+        for(int i = 0; i < count; ++i) {
+            points.emplace_back(random.uniform(10.0f, 190.0f), random.uniform(10.0f, 190.0f));
+        }
+        const PointSet set(points);
+        std::vector<uint64_t> mask;
+        std::vector<std::size_t> closest;
+        const std::string size = std::to_string(count);
+        Measure(results, "Nearest/loop/" + size, [&] {
+            std::size_t best = 0;
+            float bestDistance = std::numeric_limits<float>::max();
+            for(std::size_t i = 0; i < points.size(); ++i) {
+                const float distance = DistanceSquared2D(points[i], home);
+                if(distance < bestDistance) {
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            sink = sink + best;
+        });
+        Measure(results, "Nearest/" + size, [&] { sink = sink + Nearest(set, home); });
+        Measure(results, "WithinRadius/" + size, [&] {
+            sink = sink + WithinRadius(set, home, CLUSTER_DISTANCE, mask);
+        });
+        Measure(results, "KNearest/8/" + size, [&] {
+            KNearest(set, home, 8, closest);
+            sink = sink + closest.front();
+        });
+    }
+
+    if(argc > 1 && !WriteJson(argv[1], results)) {
+        std::fprintf(stderr, "Could not write %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    return sink == 0xFFFFFFFF ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include "MapGrid.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+
+// Full-size map, the largest ladder maps are about 200x200 cells
+#define BENCH_MAP_SIZE 200
+#define BENCH_ITERATIONS 20000
+
+/**
+ * @brief Builds a packed 1-bit image with pathable blobs, like a decoded pathing grid.
+ *
+ * @param size The width and height of the image
+ * @return std::string The packed pixels, leftmost pixel in the most significant bit
+ */
+static std::string MakeImage(int size) {
+    std::string data((size * size + 7) / 8, '\0');
+    uint32_t state = 2463534242u;
+    for(int y = 0; y < size; ++y) {
+        for(int x = 0; x < size; ++x) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            const int dx = x - size / 2;
+            const int dy = y - size / 2;
+            const bool open = dx * dx + dy * dy < (size * size) / 5 || (state & 7) != 0;
+            const int i = y * size + x;
+            if(open) { data[i >> 3] = static_cast<char>(data[i >> 3] | (0x80 >> (i & 7))); }
+        }
+    }
+    return data;
+}
+
+/**
+ * @brief Times a kernel and prints its mean duration.
+ *
+ * @param name The name of the kernel
+ * @param kernel The kernel to run
+ */
+static void Measure(const char *name, const std::function<void()> &kernel) {
+    for(int i = 0; i < BENCH_ITERATIONS / 10; ++i) { kernel(); }
+    const auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < BENCH_ITERATIONS; ++i) { kernel(); }
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::printf("%-24s %10.1f ns\n", name, ns / BENCH_ITERATIONS);
+}
+
+int main() {
+    const int size = BENCH_MAP_SIZE;
+    const std::string image = MakeImage(size);
+    const std::string heights(static_cast<std::size_t>(size) * size, '\x80');
+    const BitGrid pathing = BitGrid::decode(image, size, size, 1);
+    const BitGrid creep = pathing.shifted(3, -2);
+    volatile std::size_t sink = 0;
+
+    std::printf("map %dx%d, %zu pathable cells\n", size, size, pathing.count());
+    Measure("decode 1bpp", [&] { sink = sink + BitGrid::decode(image, size, size, 1).words[0]; });
+    Measure("and", [&] {
+        BitGrid grid = pathing;
+        grid &= creep;
+        sink = sink + grid.words[0];
+    });
+    Measure("or", [&] {
+        BitGrid grid = pathing;
+        grid |= creep;
+        sink = sink + grid.words[0];
+    });
+    Measure("shift (3, -2)", [&] { sink = sink + pathing.shifted(3, -2).words[0]; });
+    Measure("dilate 1", [&] {
+        BitGrid grid = pathing;
+        sink = sink + grid.dilate(1).words[0];
+    });
+    Measure("erode 2", [&] {
+        BitGrid grid = pathing;
+        sink = sink + grid.erode(2).words[0];
+    });
+    Measure("count", [&] { sink = sink + pathing.count(); });
+    Measure("count 20x20", [&] { sink = sink + pathing.count(90, 90, 20, 20); });
+    Measure("fits 3x3 x 1000", [&] {
+        for(int i = 0; i < 1000; ++i) { sink = sink + pathing.fits(i % 190, (i * 7) % 190, 3, 3); }
+    });
+    Measure("height band", [&] {
+        const HeightMap map(heights, size, size);
+        sink = sink + map.band(0x70, 0x90).words[0];
+    });
+    return sink == 0xFFFFFFFF ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -10,9 +10,5 @@ struct AllyUnit {
     TASK unitTask = TASK::UNSET;
     UnitGroup *group = nullptr;
     sc2::UNIT_TYPEID unitType; // added due to role specific tasks being used for on death triggers
-    float priorHealth;
-    sc2::Point2D priorPos;
     AllyUnit(const sc2::Unit *unit, TASK task, UnitGroup *group);
-    bool underAttack() const;
-    bool isMoving() const;
 };
\ No newline at end of file
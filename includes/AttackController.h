@@ -1,18 +1,42 @@
 #pragma once
 
+#include "CommandBuffer.h"
+#include "FlowField.h"
+#include "SquadClusterer.h"
+#include "ThreadPool.h"
 #include "UnitController.h"
 #include "sc2-includes.h"
 
+struct UnitGroup;
+
 struct AttackController : public UnitController {
     AttackController(OnPhone &bot);
     void step(AllyUnit &unit);
     void underAttack(AllyUnit &unit);
     void onDeath(AllyUnit &unit);
-    void rally(AllyUnit &unit);
-    void attack(AllyUnit &unit);
-    void getMostDangerous();
+    void groupSquads(const UnitGroup &group);
+    void command(ThreadPool &pool);
+    std::size_t takeSent();
+    void rally(std::size_t index, unsigned worker);
+    void attack(std::size_t index, unsigned worker);
+    void getMostDangerous(ThreadPool &pool);
+    bool regroup(const Squad &squad, sc2::Point2D &target) const;
+    sc2::Point2D waypoint(const FlowField *field, const sc2::Point2D &from) const;
     const sc2::Unit *most_dangerous_all = nullptr;
     const sc2::Unit *most_dangerous_ground = nullptr;
     bool isAttacking = false;
     float approachDistance = 30.0f;
-};
\ No newline at end of file
+    SquadClusterer squads;
+    // Scratch list of the living attackers, reused every step
+    sc2::Units army;
+
+  private:
+    // Read only while the squads decide on the pool, fetched before on the game thread
+    const Squad *main = nullptr;
+    const FlowField *toEnemy = nullptr;
+    const FlowField *toCenter = nullptr;
+    // Written by the squad decisions, one lane or entry per worker or squad
+    CommandBuffer commands;
+    std::vector<uint8_t> arrived;
+    std::vector<sc2::Units> ravagers;
+};
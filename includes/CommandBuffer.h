@@ -0,0 +1,39 @@
+#pragma once
+
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <vector>
+
+// Unit commands recorded by the pool workers, one lane each, and sent from the game thread
+// in order of their keys, so the actions do not depend on which worker ran what
+struct CommandBuffer {
+    void reset(unsigned workers);
+    void command(unsigned worker, uint32_t key, const sc2::Units &units, sc2::AbilityID ability,
+                 const sc2::Point2D &target);
+    void flush(sc2::ActionInterface *actions);
+    // Commands sent since the owner last reset the count
+    std::size_t sent = 0;
+
+  private:
+    struct Command {
+        uint32_t key;
+        sc2::AbilityID ability;
+        sc2::Point2D target;
+        // The command's units are units[first, first + count) of its lane
+        std::size_t first;
+        std::size_t count;
+    };
+    struct Lane {
+        std::vector<Command> commands;
+        sc2::Units units;
+    };
+    struct Entry {
+        uint32_t key;
+        unsigned lane;
+        std::size_t command;
+    };
+    std::vector<Lane> lanes;
+    std::vector<Entry> merged;
+    sc2::Units batch;
+};
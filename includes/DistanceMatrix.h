@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Geometry.h"
+#include "MapGrid.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <vector>
+
+// Symmetric travel distances between a fixed set of points, computed once per game
+struct DistanceMatrix {
+    static DistanceMatrix air(const std::vector<sc2::Point2D> &points);
+    static DistanceMatrix ground(const std::vector<sc2::Point2D> &points, const BitGrid &pathing);
+    float operator()(std::size_t from, std::size_t to) const {
+        return distances[from * count + to];
+    }
+    std::size_t size() const { return count; }
+    std::size_t nearest(const sc2::Point2D &pos) const;
+    float between(const sc2::Point2D &from, const sc2::Point2D &to) const;
+    bool closer(const sc2::Point2D &a, const sc2::Point2D &b, const sc2::Point2D &to) const;
+    std::vector<sc2::Point2D> points;
+
+  private:
+    std::size_t count = 0;
+    // Row-major count x count distances
+    std::vector<float> distances;
+    // The points again as separate x and y arrays for the nearest fallback
+    PointSet positions;
+    // Index of the closest point by ground distance for every map cell, if computed
+    std::vector<uint8_t> labels;
+    int width = 0;
+    int height = 0;
+};
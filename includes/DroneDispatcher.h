@@ -0,0 +1,37 @@
+#pragma once
+
+#include "constants.h"
+#include "StepTask.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <vector>
+
+class OnPhone;
+struct AllyUnit;
+
+// Sends builder drones ahead so they reach the site as the bank covers the cost
+struct DroneDispatcher {
+    OnPhone &bot;
+    DroneDispatcher(OnPhone &bot);
+    bool build(sc2::ABILITY_ID ability, const sc2::Point2D &location, int minerals,
+               const sc2::Unit *target = nullptr);
+    bool location(sc2::ABILITY_ID ability, sc2::Point2D &location) const;
+    void release(sc2::ABILITY_ID ability);
+    void update();
+
+  private:
+    struct Dispatch {
+        sc2::ABILITY_ID ability;
+        sc2::Tag drone;
+        sc2::Point2D location;
+        uint32_t requested;
+    };
+    StepTask confirm(sc2::Tag drone, sc2::ABILITY_ID ability, sc2::Point2D location,
+                     sc2::Tag target, int minerals);
+    AllyUnit *closestMiner(const sc2::Point2D &location) const;
+    AllyUnit *worker(sc2::Tag drone) const;
+    uint32_t travelTime(const sc2::Point2D &from, const sc2::Point2D &to) const;
+    void release(std::size_t index);
+    std::vector<Dispatch> dispatches;
+};
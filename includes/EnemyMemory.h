@@ -0,0 +1,84 @@
+#pragma once
+
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct EnemyRecord {
+    sc2::Tag tag;
+    sc2::UNIT_TYPEID type;
+    sc2::Point2D pos;
+    uint32_t firstSeen;
+    uint32_t lastSeen;
+    std::size_t region;
+    bool structure;
+    bool alive;
+    bool flying;
+};
+
+// Running totals over the living enemy units, updated on every sighting, morph and death
+struct EnemyComposition {
+    int count(sc2::UNIT_TYPEID type) const;
+    int armyValue() const { return armyMinerals + armyVespene; }
+    // Living units per type, indexed by the unit type id
+    std::vector<int> counts;
+    // Units with supply that are neither workers nor structures
+    float armySupply = 0.0f;
+    float airSupply = 0.0f;
+    int armyMinerals = 0;
+    int armyVespene = 0;
+    int workers = 0;
+    int structures = 0;
+    // Units and structures with a weapon that hits air or ground, and detectors
+    int antiAir = 0;
+    int antiGround = 0;
+    int detectors = 0;
+};
+
+struct EnemyMemory {
+    void initialize(const sc2::GameInfo &gameInfo, const sc2::UnitTypes &unitData);
+    void update(const sc2::Units &enemies, uint32_t gameLoop);
+    void see(const sc2::Unit &unit, uint32_t gameLoop);
+    void forget(sc2::Tag tag);
+    float confidence(const EnemyRecord &record, uint32_t gameLoop) const;
+    const EnemyRecord *get(sc2::Tag tag) const;
+    const std::vector<std::size_t> &ofType(sc2::UNIT_TYPEID type) const;
+    const std::vector<std::size_t> &near(const sc2::Point2D &point) const;
+    const EnemyRecord *main() const;
+    const EnemyRecord *natural() const;
+    const EnemyRecord *anchor() const;
+    bool isArmy(const EnemyRecord &record) const;
+    // Every enemy unit and structure seen this game, dead ones are kept but flagged
+    std::vector<EnemyRecord> records;
+    EnemyComposition composition;
+
+  private:
+    struct Traits {
+        float supply;
+        int minerals;
+        int vespene;
+        bool antiAir;
+        bool antiGround;
+    };
+    void tally(const EnemyRecord &record, int sign);
+    std::size_t regionOf(const sc2::Point2D &point) const;
+    void unlink(std::vector<std::size_t> &bucket, std::size_t index);
+    void refreshBases();
+    std::unordered_map<sc2::Tag, std::size_t> indexOf;
+    std::unordered_map<uint32_t, std::vector<std::size_t>> byType;
+    std::vector<std::vector<std::size_t>> byRegion;
+    std::vector<std::size_t> townHalls;
+    std::vector<std::size_t> structures;
+    std::vector<sc2::Point2D> enemyStarts;
+    // Cost, supply and weapons per unit type, indexed by the unit type id
+    std::vector<Traits> traits;
+    sc2::Point2D origin;
+    std::size_t regionsX = 1;
+    std::size_t regionsY = 1;
+    std::size_t mainIndex = SIZE_MAX;
+    std::size_t naturalIndex = SIZE_MAX;
+    std::size_t anchorIndex = SIZE_MAX;
+};
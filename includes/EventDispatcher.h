@@ -0,0 +1,34 @@
+#pragma once
+
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct EventDispatcher {
+    enum WAKE : uint8_t {
+        CREATED = 1 << 0,
+        IDLE = 1 << 1,
+        DAMAGED = 1 << 2,
+        TASK_CHANGED = 1 << 3,
+        ENEMY_SEEN = 1 << 4,
+        UPGRADED = 1 << 5,
+        ATTACK_STARTED = 1 << 6
+    };
+    void wake(sc2::Tag tag, WAKE reason);
+    void broadcast(WAKE reason);
+    void dispatch();
+    void postpone(sc2::Tag tag);
+    uint8_t reasons(sc2::Tag tag) const;
+    // Units woken for the current step, in the order their first event arrived
+    std::vector<sc2::Tag> woken;
+
+  private:
+    // Wake-ups raised since the last dispatch, delivered on the next one
+    std::unordered_map<sc2::Tag, uint8_t> queued;
+    std::vector<sc2::Tag> queuedOrder;
+    uint8_t queuedAll = 0;
+    std::unordered_map<sc2::Tag, uint8_t> active;
+    uint8_t activeAll = 0;
+};
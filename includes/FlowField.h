@@ -0,0 +1,55 @@
+#pragma once
+
+#include "MapGrid.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <vector>
+
+// Travel distance and next step toward one destination for every cell of the pathing grid
+struct FlowField {
+    static FlowField toward(const sc2::Point2D &destination, const BitGrid &pathing);
+    static FlowField start(const sc2::Point2D &destination, const BitGrid &pathing);
+    bool build(const BitGrid &pathing, std::size_t cells);
+    bool ready() const;
+    bool reachable(const sc2::Point2D &pos) const;
+    float distance(const sc2::Point2D &pos) const;
+    sc2::Point2D waypoint(const sc2::Point2D &pos) const;
+    sc2::Point2D destination;
+
+  private:
+    int cell(const sc2::Point2D &pos) const;
+    void pointRow(const BitGrid &pathing, int cy);
+    // Cell the field was integrated from, the destination snapped onto the pathing grid
+    int goal = -1;
+    int width = 0;
+    int height = 0;
+    std::vector<float> distances;
+    // Neighbour index of the next cell downhill, FLOW_NONE at the goal and unreachable cells
+    std::vector<uint8_t> directions;
+    // Search still integrating the distances, and the next row to point downhill after it
+    DistanceSearch search;
+    int row = 0;
+};
+
+// The flow fields of the last FLOW_CACHE_SIZE destinations, recomputed only for new ones.
+// Fields for waypoints are built in time slices by build, units head straight for the
+// destination until theirs is ready
+struct FlowFields {
+    const FlowField &toward(const sc2::Point2D &destination, const BitGrid &pathing);
+    const FlowField &field(const sc2::Point2D &destination, const BitGrid &pathing);
+    sc2::Point2D waypoint(const sc2::Point2D &from, const sc2::Point2D &to, const BitGrid &pathing);
+    bool pending() const;
+    bool build(const BitGrid &pathing, std::size_t cells);
+
+  private:
+    struct Entry {
+        int cell;
+        FlowField field;
+        uint32_t used;
+    };
+    Entry &find(const sc2::Point2D &destination, const BitGrid &pathing);
+    std::vector<Entry> entries;
+    uint32_t clock = 0;
+};
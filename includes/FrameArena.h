@@ -0,0 +1,58 @@
+#pragma once
+
+#include "constants.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bump allocator for containers that only live for one game step, reset at the start of OnStep
+struct FrameArena {
+    explicit FrameArena(std::size_t capacity = ARENA_CAPACITY);
+    void *allocate(std::size_t bytes, std::size_t alignment);
+    void reset();
+    void endStep(uint64_t heapCalls);
+    std::size_t capacity() const { return size; }
+    // Counters of the current step
+    std::size_t used = 0;
+    std::size_t allocations = 0;
+    // Counters over the game
+    std::size_t peak = 0;
+    std::size_t overflows = 0;
+    uint64_t maxHeapCalls = 0;
+    uint64_t heapSteps = 0;
+    uint64_t steps = 0;
+
+  private:
+    std::unique_ptr<std::max_align_t[]> block;
+    std::size_t size;
+    // Allocations that did not fit, freed on the next reset
+    std::vector<std::unique_ptr<std::max_align_t[]>> spilled;
+};
+
+// STL allocator drawing from a FrameArena, memory is only given back when the arena is reset
+template <typename T> struct ArenaAllocator {
+    typedef T value_type;
+    FrameArena *arena;
+    explicit ArenaAllocator(FrameArena &arena) noexcept : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena) {}
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, std::size_t) noexcept {}
+    template <typename U> bool operator==(const ArenaAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+    template <typename U> bool operator!=(const ArenaAllocator<U> &other) const {
+        return arena != other.arena;
+    }
+};
+
+template <typename T> using FrameVector = std::vector<T, ArenaAllocator<T>>;
+
+// Calls to any form of the global operator new so far, 0 unless built with
+// ONPHONE_COUNT_ALLOCATIONS. This includes the unit lists the SC2 API returns, which cannot
+// be drawn from the arena
+uint64_t HeapAllocations();
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct FrameDelta {
+    enum EVENT : uint8_t {
+        DAMAGED = 1 << 0,
+        MOVED = 1 << 1,
+        BECAME_IDLE = 1 << 2,
+        ORDER_CHANGED = 1 << 3,
+        SHIELDS_LOW = 1 << 4,
+        ENERGY_READY = 1 << 5
+    };
+    void update(const sc2::Units &units, uint32_t gameLoop);
+    bool test(sc2::Tag tag, EVENT event) const;
+    uint8_t events(sc2::Tag tag) const;
+    float damageInWindow(sc2::Tag tag, uint32_t loops) const;
+    sc2::Point2D priorPos(sc2::Tag tag) const;
+    // Compact per-step event lists, rebuilt by every call to update
+    std::vector<sc2::Tag> damaged;
+    std::vector<sc2::Tag> moved;
+    std::vector<sc2::Tag> becameIdle;
+    std::vector<sc2::Tag> orderChanged;
+    std::vector<sc2::Tag> shieldsLow;
+    std::vector<sc2::Tag> energyReady;
+    uint32_t gameLoop = 0;
+
+  private:
+    std::size_t allocateSlot(sc2::Tag tag);
+    void freeSlot(std::size_t slot);
+    // Packed per-slot state, indexed by the slot assigned to each unit tag
+    std::unordered_map<sc2::Tag, std::size_t> slotOf;
+    std::vector<std::size_t> freeSlots;
+    std::vector<sc2::Tag> tags;
+    std::vector<uint32_t> seen;
+    std::vector<float> health, prevHealth;
+    std::vector<float> shield, prevShield, shieldMax;
+    std::vector<float> energy, prevEnergy;
+    std::vector<float> x, prevX;
+    std::vector<float> y, prevY;
+    std::vector<uint32_t> orderCount, prevOrderCount;
+    std::vector<uint64_t> orderKey, prevOrderKey;
+    std::vector<float> damage;
+    std::vector<uint8_t> flags;
+    // Damage taken per slot over the last DELTA_WINDOW_FRAMES updates
+    std::vector<float> windowDamage;
+    uint32_t windowLoops[DELTA_WINDOW_FRAMES] = {};
+    std::size_t windowFrame = 0;
+    uint32_t frame = 0;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "sc2-includes.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Returned by the queries below when no point qualifies
+#define GEOMETRY_NONE SIZE_MAX
+
+// Positions kept as separate x and y arrays, so the kernels below load four or eight at a time
+struct PointSet {
+    PointSet() = default;
+    explicit PointSet(const sc2::Units &units);
+    explicit PointSet(const std::vector<sc2::Point2D> &points);
+    void assign(const sc2::Units &units);
+    void push_back(const sc2::Point2D &point);
+    void set(std::size_t i, const sc2::Point2D &point);
+    void erase(std::size_t i);
+    void clear();
+    std::size_t size() const { return xs.size(); }
+    bool empty() const { return xs.empty(); }
+    sc2::Point2D operator[](std::size_t i) const { return sc2::Point2D(xs[i], ys[i]); }
+    std::vector<float> xs;
+    std::vector<float> ys;
+};
+
+void DistancesSquared(const PointSet &points, const sc2::Point2D &to, float *out);
+std::size_t Nearest(const PointSet &points, const sc2::Point2D &to);
+std::size_t Farthest(const PointSet &points, const sc2::Point2D &to);
+std::size_t FirstWithin(const PointSet &points, const sc2::Point2D &center, float radius);
+std::size_t WithinRadius(const PointSet &points, const sc2::Point2D &center, float radius,
+                         std::vector<uint64_t> &mask);
+void KNearest(const PointSet &points, const sc2::Point2D &to, std::size_t k,
+              std::vector<std::size_t> &indices);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <vector>
+
+// Mineral and gas income per game loop, modelled from harvesters and calibrated on what was mined
+struct IncomeModel {
+    struct Bank {
+        float minerals;
+        float vespene;
+    };
+    void update(const sc2::ObservationInterface *observation, const sc2::Units &units);
+    float mineralRate() const;
+    float vespeneRate() const;
+    uint32_t timeUntilAffordable(int minerals, int vespene = 0) const;
+    Bank project(uint32_t loops) const;
+    std::vector<Bank> curve(uint32_t horizon, uint32_t step) const;
+
+  private:
+    struct Sample {
+        uint32_t loop;
+        float collectedMinerals;
+        float collectedVespene;
+        float modelMinerals;
+        float modelVespene;
+    };
+    void model(const sc2::Units &units);
+    void calibrate();
+    // Ring buffer over the last INCOME_WINDOW samples
+    Sample window[INCOME_WINDOW] = {};
+    std::size_t head = 0;
+    std::size_t count = 0;
+    uint32_t nextSample = 0;
+    Bank bank = {0.0f, 0.0f};
+    float modelMinerals = 0.0f;
+    float modelVespene = 0.0f;
+    float mineralScale = 1.0f;
+    float vespeneScale = 1.0f;
+};
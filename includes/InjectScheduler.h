@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Geometry.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Pairs every queen with a hatchery and injects it on the first game loop it can
+struct InjectScheduler {
+    void addQueen(const sc2::Unit *queen, uint32_t gameLoop);
+    void addHatchery(const sc2::Unit *hatchery, uint32_t gameLoop);
+    void remove(sc2::Tag tag, uint32_t gameLoop);
+    void step(uint32_t gameLoop, sc2::ActionInterface *actions);
+    std::size_t injecting() const;
+
+  private:
+    struct Pairing {
+        const sc2::Unit *queen;
+        const sc2::Unit *hatchery;
+        uint32_t version;
+    };
+    struct Due {
+        uint32_t loop;
+        sc2::Tag queen;
+        uint32_t version;
+        bool operator>(const Due &other) const { return loop > other.loop; }
+    };
+    void pair(const sc2::Unit *queen, const sc2::Unit *hatchery, uint32_t gameLoop);
+    void schedule(const Pairing &pairing, uint32_t loop);
+    static uint32_t readyIn(float energy);
+    std::unordered_map<sc2::Tag, Pairing> pairings;
+    std::unordered_map<sc2::Tag, sc2::Tag> queenOf;
+    // Game loop the last inject into each hatchery runs out
+    std::unordered_map<sc2::Tag, uint32_t> expiry;
+    std::vector<const sc2::Unit *> freeQueens;
+    std::vector<const sc2::Unit *> freeHatcheries;
+    // Positions of the free queens or hatchery being paired, kept so its capacity is reused
+    PointSet positions;
+    // Min-heap of due injects, entries of changed pairings are skipped when they surface
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> queue;
+    uint32_t version = 0;
+};
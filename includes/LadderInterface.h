@@ -94,9 +94,16 @@ static void ParseArguments(int argc, char *argv[], ConnectionOptions &connect_op
     arg_parser.Get("OpponentId", connect_options.OpponentId);
 }
 
-static void RunBot(int argc, char *argv[], Agent *Agent, Race race) {
+static void RunBot(int argc, char *argv[], OnPhone *Agent, Race race) {
     ConnectionOptions Options;
     ParseArguments(argc, argv, Options);
+    // The opponent history is kept per opponent, games against the built-in AI are keyed by
+    // its race and difficulty
+    Agent->opponentId = Options.OpponentId;
+    if(Options.ComputerOpponent && Agent->opponentId.empty()) {
+        Agent->opponentId = "computer-" + std::to_string(static_cast<int>(Options.ComputerRace))
+                            + "-" + std::to_string(static_cast<int>(Options.ComputerDifficulty));
+    }
 
     Coordinator coordinator;
 
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// log levels, messages below ONPHONE_LOG_LEVEL are compiled out
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_RESULT 3
+
+#ifndef ONPHONE_LOG_LEVEL
+#define ONPHONE_LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// ring buffer configuration
+#define LOG_RING_SIZE 4096
+#define LOG_PAYLOAD_SIZE 40
+
+/**
+ * Logs a printf-style message from the calling thread. The arguments are copied
+ * into a lock-free ring buffer and formatted later by the logger thread, so they
+ * must be trivially copyable; strings must be string literals.
+ * maxPerSecond limits how often this call site may log, 0 means unlimited.
+ */
+#define ONPHONE_LOG(level, maxPerSecond, ...)                                                     \
+    do {                                                                                          \
+        if(level >= ONPHONE_LOG_LEVEL) {                                                          \
+            static LogSite onphone_log_site(level, maxPerSecond, __VA_ARGS__);                    \
+            Logger::instance().write(onphone_log_site, __VA_ARGS__);                              \
+        }                                                                                         \
+    } while(0)
+
+#define LOG_DEBUG(...) ONPHONE_LOG(LOG_LEVEL_DEBUG, 0, __VA_ARGS__)
+#define LOG_INFO(...) ONPHONE_LOG(LOG_LEVEL_INFO, 0, __VA_ARGS__)
+#define LOG_INFO_LIMITED(maxPerSecond, ...) ONPHONE_LOG(LOG_LEVEL_INFO, maxPerSecond, __VA_ARGS__)
+#define LOG_WARN(...) ONPHONE_LOG(LOG_LEVEL_WARN, 0, __VA_ARGS__)
+// Result lines are always printed to stdout, scripts/test.sh depends on them
+#define LOG_RESULT(...) ONPHONE_LOG(LOG_LEVEL_RESULT, 0, __VA_ARGS__)
+
+struct LogArgs;
+
+struct LogSite {
+    const int level;
+    const uint32_t maxPerSecond;
+    const char *const format;
+    std::atomic<uint32_t> id{0};
+    std::atomic<int64_t> windowStart{0};
+    std::atomic<uint32_t> windowCount{0};
+    std::atomic<uint32_t> suppressed{0};
+    template <typename... Args>
+    LogSite(int level, uint32_t maxPerSecond, const char *format, const Args &...)
+        : level(level), maxPerSecond(maxPerSecond), format(format) {}
+};
+
+struct LogRecord {
+    std::atomic<uint64_t> sequence;
+    const LogSite *site;
+    const LogArgs *args;
+    int64_t timestamp;
+    uint32_t suppressed;
+    alignas(8) char payload[LOG_PAYLOAD_SIZE];
+};
+
+// Describes how to decode the payload of one argument list
+struct LogArgs {
+    void (*format)(const char *format, const char *payload, std::string &out);
+    void (*serialize)(const char *payload, std::FILE *file);
+    const char *signature;
+};
+
+template <typename T> struct LogType {
+    static_assert(std::is_arithmetic<T>::value, "Unsupported log argument type");
+    static constexpr char code = std::is_floating_point<T>::value ? 'd'
+                                 : sizeof(T) == 8 ? (std::is_signed<T>::value ? 'l' : 'L')
+                                 : (std::is_signed<T>::value ? 'i' : 'I');
+};
+template <> struct LogType<const char *> { static constexpr char code = 's'; };
+template <> struct LogType<char *> { static constexpr char code = 's'; };
+
+// Arguments are stored the way printf varargs promote them
+template <typename T> struct LogStored {
+    using type = typename std::conditional<
+      std::is_same<T, float>::value, double,
+      typename std::conditional<std::is_integral<T>::value && (sizeof(T) < sizeof(int)), int,
+                                T>::type>::type;
+};
+
+template <typename T> inline void LogSerialize(std::FILE *file, const T &value) {
+    std::fwrite(&value, sizeof(T), 1, file);
+}
+
+inline void LogSerialize(std::FILE *file, const char *const &value) {
+    const uint32_t length = value != nullptr ? static_cast<uint32_t>(std::strlen(value)) : 0;
+    std::fwrite(&length, sizeof(length), 1, file);
+    if(length != 0) { std::fwrite(value, 1, length, file); }
+}
+
+template <typename T> using LogValue = typename LogStored<typename std::decay<const T>::type>::type;
+
+template <typename... Args> struct LogCodec {
+    using Tuple = std::tuple<LogValue<Args>...>;
+    static_assert(sizeof(Tuple) <= LOG_PAYLOAD_SIZE, "Too many log arguments");
+    static_assert(std::is_trivially_destructible<Tuple>::value, "Log arguments must be trivial");
+    static_assert(alignof(Tuple) <= 8, "Unsupported log argument alignment");
+
+    static void encode(char *payload, const Args &...args) { new(payload) Tuple(args...); }
+
+    static int print(char *buffer, std::size_t size, const char *format, const Tuple &,
+                     std::index_sequence<>) {
+        return std::snprintf(buffer, size, "%s", format);
+    }
+
+    template <std::size_t... I>
+    static int print(char *buffer, std::size_t size, const char *format, const Tuple &values,
+                     std::index_sequence<I...>) {
+        return std::snprintf(buffer, size, format, std::get<I>(values)...);
+    }
+
+    template <std::size_t... I>
+    static void store(std::FILE *file, const Tuple &values, std::index_sequence<I...>) {
+        int expand[] = {0, (LogSerialize(file, std::get<I>(values)), 0)...};
+        (void)expand;
+        (void)file;
+    }
+
+    static void format(const char *format, const char *payload, std::string &out) {
+        const Tuple &values = *reinterpret_cast<const Tuple *>(payload);
+        char buffer[512];
+        const int length
+          = print(buffer, sizeof(buffer), format, values, std::index_sequence_for<Args...>());
+        if(length > 0) {
+            out.append(buffer, std::min<std::size_t>(length, sizeof(buffer) - 1));
+        }
+    }
+
+    static void serialize(const char *payload, std::FILE *file) {
+        const Tuple &values = *reinterpret_cast<const Tuple *>(payload);
+        store(file, values, std::index_sequence_for<Args...>());
+    }
+
+    static const LogArgs *describe() {
+        static const char signature[] = {LogType<LogValue<Args>>::code..., '\0'};
+        static const LogArgs describer{&LogCodec::format, &LogCodec::serialize, signature};
+        return &describer;
+    }
+};
+
+class Logger {
+  public:
+    static Logger &instance();
+    ~Logger();
+    bool openBinary(const std::string &path);
+    void flush();
+
+    template <typename... Args> void write(LogSite &site, const char *, const Args &...args) {
+        const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+        uint32_t suppressed = 0;
+        if(site.maxPerSecond != 0 && !admit(site, now, suppressed)) { return; }
+        uint64_t position;
+        LogRecord *record = claim(position);
+        if(record == nullptr) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        record->site = &site;
+        record->args = LogCodec<Args...>::describe();
+        record->timestamp = now;
+        record->suppressed = suppressed;
+        LogCodec<Args...>::encode(record->payload, args...);
+        publish(record, position);
+    }
+
+  private:
+    Logger();
+    bool admit(LogSite &site, int64_t now, uint32_t &suppressed);
+    LogRecord *claim(uint64_t &position);
+    void publish(LogRecord *record, uint64_t position);
+    void run();
+    bool drain();
+    void writeText(const LogRecord &record);
+    void writeBinary(const LogRecord &record);
+
+    std::unique_ptr<LogRecord[]> ring;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    alignas(64) std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> running{true};
+    std::atomic<uint32_t> nextSiteId{0};
+    std::string line;
+    std::atomic<std::FILE *> binary{nullptr};
+    std::thread worker;
+};
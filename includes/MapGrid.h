@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Every bitboard row is GRID_ROW_WORDS 64-bit words, one 256-bit AVX2 register
+#define GRID_ROW_WORDS 4
+#define GRID_MAX_WIDTH (GRID_ROW_WORDS * 64)
+
+/**
+ * 1-bit grid over the map with bit x of row y at words[y * GRID_ROW_WORDS + x / 64].
+ * Bits at or beyond width are always kept clear.
+ */
+struct BitGrid {
+    int width = 0;
+    int height = 0;
+    std::vector<uint64_t> words;
+
+    BitGrid() = default;
+    BitGrid(int width, int height);
+    static BitGrid decode(const std::string &data, int width, int height, int bitsPerPixel);
+    static BitGrid decodeValue(const std::string &data, int width, int height, uint8_t value);
+    // Decodes any image with width, height, bits_per_pixel and data, e.g. sc2::ImageData
+    template <typename Image> static BitGrid fromImage(const Image &image) {
+        return decode(image.data, image.width, image.height, image.bits_per_pixel);
+    }
+
+    bool get(int x, int y) const;
+    void set(int x, int y, bool value = true);
+    void fill(bool value);
+    uint64_t *row(int y) { return &words[static_cast<std::size_t>(y) * GRID_ROW_WORDS]; }
+    const uint64_t *row(int y) const {
+        return &words[static_cast<std::size_t>(y) * GRID_ROW_WORDS];
+    }
+
+    BitGrid &operator&=(const BitGrid &other);
+    BitGrid &operator|=(const BitGrid &other);
+    BitGrid &andNot(const BitGrid &other);
+    BitGrid &invert();
+    BitGrid shifted(int dx, int dy) const;
+    BitGrid &dilate(int radius = 1);
+    BitGrid &erode(int radius = 1);
+
+    std::size_t count() const;
+    std::size_t count(int x, int y, int w, int h) const;
+    bool fits(int x, int y, int w, int h) const;
+    bool any(int x, int y, int w, int h) const;
+    bool nearest(int &x, int &y, int radius) const;
+    std::vector<float> distanceField(int x, int y) const;
+
+  private:
+    void clipRow(uint64_t *row) const;
+    bool rectMask(int x, int w, uint64_t mask[GRID_ROW_WORDS]) const;
+    uint64_t tail[GRID_ROW_WORDS] = {};
+};
+
+// Dijkstra search over the set cells of a BitGrid that can be advanced a few cells at a time
+struct DistanceSearch {
+    void start(const BitGrid &grid, int x, int y);
+    bool advance(const BitGrid &grid, std::size_t cells);
+    bool done() const { return open.empty(); }
+    std::vector<float> distances;
+
+  private:
+    typedef std::pair<float, int> Entry;
+    // Min-heap of reached cells still to expand
+    std::vector<Entry> open;
+};
+
+/**
+ * 8-bit grid viewed in place from the image data, without copying it.
+ * The image must outlive the view.
+ */
+struct HeightMap {
+    int width = 0;
+    int height = 0;
+    const uint8_t *cells = nullptr;
+
+    HeightMap() = default;
+    HeightMap(const std::string &data, int width, int height);
+    template <typename Image> static HeightMap fromImage(const Image &image) {
+        return image.bits_per_pixel == 8 ? HeightMap(image.data, image.width, image.height)
+                                         : HeightMap();
+    }
+
+    uint8_t at(int x, int y) const;
+    float terrainHeight(int x, int y) const;
+    BitGrid band(uint8_t low, uint8_t high) const;
+};
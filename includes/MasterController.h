@@ -16,5 +16,6 @@ struct MasterController {
     std::vector<UnitGroup> unitGroups;
     MasterController(OnPhone &bot);
     void addUnitGroup(UnitGroup unit);
-    void step();
+    void step(ROLE role);
+    void postpone(ROLE role);
 };
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Geometry.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Gatherers per mineral field for one step, kept up to date as drones are sent to fields
+struct MineralLedger {
+    void reset(const sc2::Units &minerals, const sc2::Units &drones);
+    std::size_t pick(const sc2::Unit *worker, const sc2::Point2D &hall);
+    void assign(const sc2::Unit *worker, std::size_t field);
+    const sc2::Units &fields() const { return minerals; }
+    int gatherers(std::size_t field) const { return counts[field]; }
+
+  private:
+    typedef std::pair<sc2::Tag, std::size_t> Entry;
+    std::size_t fieldOf(sc2::Tag mineral) const;
+    std::vector<Entry>::iterator countedOn(sc2::Tag drone);
+    sc2::Units minerals;
+    PointSet positions;
+    std::vector<int> counts;
+    std::vector<float> distances;
+    // Mineral fields by tag, sorted so no map nodes are allocated every step
+    std::vector<Entry> fieldIndex;
+    // Drones with the field they are counted on, sorted by tag
+    std::vector<Entry> counted;
+};
@@ -1,13 +1,42 @@
 #pragma once
 
 #include "AllyUnit.h"
+#include "DistanceMatrix.h"
+#include "DroneDispatcher.h"
+#include "EnemyMemory.h"
+#include "EventDispatcher.h"
+#include "FlowField.h"
+#include "FrameArena.h"
+#include "FrameDelta.h"
+#include "Geometry.h"
+#include "IncomeModel.h"
+#include "InjectScheduler.h"
+#include "Logger.h"
+#include "MapGrid.h"
 #include "MasterController.h"
+#include "OpponentStore.h"
+#include "SaturationManager.h"
+#include "StepBudget.h"
+#include "StepTask.h"
+#include "SupplyPlanner.h"
+#include "Telemetry.h"
+#include "ThreadPool.h"
 #include "UnitGroup.h"
 #include "sc2-includes.h"
 #include "utilities.h"
 
 using namespace sc2;
 
+// Build order entry, built once the supply is reached and the cost can be paid
+struct BuildStep {
+    int supply;
+    std::function<bool()> build;
+    int minerals = 0;
+    int vespene = 0;
+    // Structures send their drone ahead, so they are started before the cost is banked
+    bool walk = false;
+};
+
 class OnPhone : public Agent {
   public:
     OnPhone();
@@ -15,10 +44,45 @@ class OnPhone : public Agent {
     virtual void OnGameEnd() final;
     virtual void OnStep() override;
     virtual void OnUnitCreated(const Unit *unit) override;
+    virtual void OnUnitIdle(const Unit *unit) override;
+    virtual void OnUpgradeCompleted(UpgradeID upgrade) override;
     virtual void OnUnitDestroyed(const Unit *unit) override;
+    virtual void OnUnitEnterVision(const Unit *unit) override;
     virtual void OnBuildingConstructionComplete(const Unit *unit) override;
 
     MasterController controller;
+    EnemyMemory enemyMemory;
+    EventDispatcher events;
+    InjectScheduler injects;
+    SaturationManager saturation;
+    SupplyPlanner supply;
+    DroneDispatcher dispatcher;
+    BitGrid pathingGrid;
+    BitGrid placementGrid;
+    HeightMap heightMap;
+    // Ground distances between start locations, expansions and the map center
+    DistanceMatrix baseDistances;
+    // Army movement fields toward the enemy base, the map center and other destinations
+    FlowFields flowFields;
+    FrameDelta frameDelta;
+    // Units of the step by alliance, split from a single GetUnits call
+    Units selfUnits;
+    Units enemyUnits;
+    Units neutralUnits;
+    // Scratch memory for containers that only live during one OnStep
+    FrameArena arena;
+    // Time of one OnStep, lower priority subsystems are deferred once it runs low
+    StepBudget budget;
+    // Multi-step build and research tasks, resumed once per step
+    TaskScheduler tasks;
+    // Workers for the parallel parts of a step, started in OnGameStart
+    std::unique_ptr<ThreadPool> pool;
+    IncomeModel income;
+    Telemetry telemetry;
+    // Results per opponent and opening from earlier games, picks the opening of this one
+    OpponentStore opponents;
+    // Opponent id passed by the ladder, or the computer race and difficulty when testing
+    std::string opponentId;
     UnitGroup *Scouts;
     UnitGroup *Larva;
     UnitGroup *Attackers;
@@ -31,9 +95,22 @@ class OnPhone : public Agent {
 
   private:
     Units constructedBuildings[4]{};
-    std::deque<std::pair<int, std::function<bool()>>> buildOrder;
+    std::deque<BuildStep> buildOrder;
+    // Reactions of the build order to the enemy composition so far
+    bool adaptedToAir = false;
+    uint32_t lastAdapted = 0;
+    bool metabolicBoostQueued = false;
+    bool metabolicBoostStarted = false;
+    // This game as it will be added to the opponent history
+    OpponentRecord game;
+    // Subsystems scheduled by the step budget
+    std::size_t buildTask;
+    std::size_t armyTask;
+    std::size_t workerTask;
+    std::size_t scoutTask;
+    std::size_t analysisTask;
 
-    void AssignWorkersToExtractor(const Unit *extractor);
+    void AdaptBuildOrder();
     bool BuildDrone();
     bool BuildExtractor();
     bool BuildHatchery();
@@ -45,6 +122,9 @@ class OnPhone : public Agent {
     bool BuildSpawningPool();
     bool BuildZergling();
     void ExecuteBuildOrder();
+    void FetchUnits(const ObservationInterface *observation);
+    void QueueOpening(OPENING opening);
+    void RecordOpponent(uint32_t gameLoop);
     Point2D FindExpansionLocation();
     Point2D FindHatcheryPlacement(const Unit *mineral_field);
     Point2D FindPlacementForBuilding(ABILITY_ID ability_type);
@@ -53,6 +133,7 @@ class OnPhone : public Agent {
     Units GetIdleLarva();
     bool IsGeyser(const Unit &unit);
     void OnBuildingDestruction(const Unit *unit);
+    StepTask Research(ABILITY_ID ability, UNIT_TYPEID structure, int minerals, int vespene,
+                      bool &started);
     bool ResearchMetabolicBoost();
-    void tryInjection();
 };
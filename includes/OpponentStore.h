@@ -0,0 +1,57 @@
+#pragma once
+
+#include "constants.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+// One game against an opponent, stored as is in the opponent file
+struct OpponentRecord {
+    uint32_t magic = OPPONENT_MAGIC;
+    uint16_t version = OPPONENT_VERSION;
+    uint8_t opening = 0;
+    // 0 for a loss, 1 for a win, 2 for a tie
+    uint8_t result = 0;
+    uint64_t opponent = 0;
+    uint32_t gameLoops = 0;
+    // First game loop enemy army units were seen in our main, 0 if never
+    uint32_t firstAttack = 0;
+    // Largest enemy army seen during the game
+    float armySupply = 0.0f;
+    float airSupply = 0.0f;
+    int32_t armyValue = 0;
+    uint16_t detectors = 0;
+    uint16_t reserved = 0;
+    uint32_t padding = 0;
+    // FNV-1a of all fields before it, torn or damaged records fail it
+    uint32_t checksum = 0;
+};
+
+// Results of the games against every opponent, per opening, loaded from an append-only file
+struct OpponentStore {
+    struct Stats {
+        uint32_t games = 0;
+        float wins = 0.0f;
+        uint32_t attacks = 0;
+        uint64_t firstAttackSum = 0;
+        float armySupplySum = 0.0f;
+        uint32_t airGames = 0;
+    };
+    typedef std::array<Stats, static_cast<std::size_t>(OPENING::COUNT)> Openings;
+    static uint64_t hash(const std::string &opponent);
+    static uint32_t checksum(const OpponentRecord &record);
+    bool open(const std::string &directory);
+    const Openings &history(uint64_t opponent) const;
+    OPENING choose(uint64_t opponent) const;
+    bool append(OpponentRecord record);
+    // Records read by open, and records skipped because their checksum failed
+    std::size_t loaded = 0;
+    std::size_t damaged = 0;
+
+  private:
+    void add(const OpponentRecord &record);
+    std::string path;
+    std::unordered_map<uint64_t, Openings> opponents;
+};
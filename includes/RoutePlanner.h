@@ -0,0 +1,38 @@
+#pragma once
+
+#include "DistanceMatrix.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Splits a set of stops into one closed tour per scout, keeping the longest tour short
+struct RoutePlanner {
+    void initialize(const std::vector<sc2::Point2D> &stops, DistanceMatrix matrix);
+    bool initialized() const;
+    bool has(sc2::Tag scout) const;
+    void addScout(sc2::Tag scout, const sc2::Point2D &pos);
+    void removeScout(sc2::Tag scout);
+    bool next(sc2::Tag scout, sc2::Point2D &stop);
+    std::size_t length(sc2::Tag scout) const;
+    float longest() const;
+
+  private:
+    struct Route {
+        std::vector<std::size_t> stops;
+        std::size_t next = 0;
+        float length = 0.0f;
+    };
+    float tourLength(const std::vector<std::size_t> &tour) const;
+    float insertionCost(const std::vector<std::size_t> &tour, std::size_t stop,
+                        std::size_t &position) const;
+    float removalGain(const std::vector<std::size_t> &tour, std::size_t position) const;
+    void insert(Route &route, std::size_t stop);
+    void buildTour(Route &route, const std::vector<std::size_t> &stops) const;
+    void twoOpt(Route &route) const;
+    void rebalance(sc2::Tag scout);
+    std::vector<sc2::Point2D> stops;
+    DistanceMatrix matrix;
+    std::unordered_map<sc2::Tag, Route> routes;
+};
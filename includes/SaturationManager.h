@@ -0,0 +1,53 @@
+#pragma once
+
+#include "MineralLedger.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class OnPhone;
+
+// Keeps mineral and gas workers spread over the bases up to their ideal counts
+struct SaturationManager {
+    OnPhone &bot;
+    SaturationManager(OnPhone &bot);
+    void markDirty();
+    void update();
+    const sc2::Unit *mineralFor(const sc2::Unit *worker);
+    const sc2::Unit *extractorFor(const sc2::Unit *worker) const;
+
+  private:
+    struct Base {
+        const sc2::Unit *townHall;
+        int assigned;
+        int ideal;
+    };
+    struct Transfer {
+        sc2::Tag townHall;
+        uint32_t arrives;
+    };
+    void refreshBases();
+    void refreshMinerals();
+    void balanceGas();
+    void balanceMinerals();
+    void transfer(sc2::Tag worker, const Base &to);
+    Base *homeOf(const sc2::Unit *worker);
+    int incoming(sc2::Tag townHall) const;
+    std::vector<Base> bases;
+    // Drones on their way to another base, counted there until they arrive
+    std::unordered_map<sc2::Tag, Transfer> transfers;
+    std::unordered_map<sc2::Tag, sc2::Tag> home;
+    // Gatherers per mineral field, counted on the first mineralFor of a step
+    MineralLedger ledger;
+    // Scratch lists filtered from the units of the step, reused so their capacity is kept
+    sc2::Units minerals;
+    sc2::Units drones;
+    sc2::Units extractors;
+    uint32_t ledgerLoop = UINT32_MAX;
+    uint32_t gameLoop = 0;
+    uint32_t nextUpdate = 0;
+    bool dirty = true;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "Geometry.h"
+#include "RoutePlanner.h"
+#include "ScoutScheduler.h"
 #include "UnitController.h"
 #include "sc2-includes.h"
 
@@ -14,9 +17,14 @@ struct ScoutController : public UnitController {
     void initializeFastLocations();
     void initializeBaseLocations();
     void initializeAllLocations();
+    void release(sc2::Tag tag);
     std::vector<sc2::Point2D> fast_locations;
+    PointSet fast_positions;
     std::vector<sc2::Point2D> base_locations;
     std::vector<sc2::Point2D> all_locations;
+    ScoutScheduler scheduler;
+    RoutePlanner airRoutes;
+    RoutePlanner groundRoutes;
     sc2::Point2D foundEnemyLocation;
     std::size_t zerglingCount = 0;
 };
\ No newline at end of file
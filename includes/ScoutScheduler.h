@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MapGrid.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct ScoutScheduler {
+    // Strategic weight of a target, see SCOUT_TIER_WEIGHTS
+    enum TIER : uint8_t { WAYPOINT, BASE, ENEMY_BASE, TIER_COUNT };
+    void initialize(int width, int height);
+    void addTarget(const sc2::Point2D &pos, TIER tier);
+    void update(const sc2::ObservationInterface *observation);
+    bool assign(sc2::Tag scout, const sc2::Point2D &from, TIER minTier, sc2::Point2D &target);
+    void release(sc2::Tag scout);
+    uint32_t lastSeen(int x, int y) const;
+    bool empty() const;
+
+  private:
+    struct Target {
+        sc2::Point2D pos;
+        std::size_t cell;
+        TIER tier;
+        uint32_t seen;
+        bool visible;
+        std::size_t heapIndex;
+    };
+    uint32_t key(std::size_t target) const;
+    void push(std::size_t target);
+    void remove(std::size_t target);
+    void sift(std::size_t target);
+    bool siftUp(std::vector<std::size_t> &heap, std::size_t index);
+    void siftDown(std::vector<std::size_t> &heap, std::size_t index);
+    void place(std::vector<std::size_t> &heap, std::size_t index, std::size_t target);
+    std::vector<Target> targets;
+    // One indexed min-heap of last seen game loops per tier, so the order never changes
+    // as time passes and only targets entering or leaving vision are resifted
+    std::vector<std::size_t> heaps[TIER_COUNT];
+    std::unordered_map<sc2::Tag, std::size_t> claims;
+    std::unordered_map<std::size_t, std::size_t> targetAt;
+    // Heap positions still to visit in assign, kept so its capacity is reused
+    std::vector<std::size_t> frontier;
+    std::vector<uint32_t> seenAt;
+    BitGrid visible;
+    BitGrid targetCells;
+    uint32_t gameLoop = 0;
+    int width = 0;
+    int height = 0;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "FrameArena.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// A spatially coherent part of the army that is given its orders as one
+struct Squad {
+    // Kept across steps while most of the squad's units stay together
+    uint32_t id = 0;
+    std::vector<const sc2::Unit *> members;
+    sc2::Point2D centroid;
+    // Sum of damage per second times health and shield of the members
+    float strength = 0.0f;
+    // Root mean square distance of the members from the centroid
+    float spread = 0.0f;
+    // Task of the members stepped this step, UNSET if none was, so the squad is commanded once
+    TASK task = TASK::UNSET;
+};
+
+// Splits the army into squads every step with a grid-based DBSCAN
+struct SquadClusterer {
+    void initialize(int width, int height);
+    void update(const sc2::Units &army, const sc2::UnitTypes &unitData, FrameArena &arena);
+    Squad *of(sc2::Tag tag);
+    const Squad *strongest() const;
+    std::vector<Squad> squads;
+
+  private:
+    uint32_t root(uint32_t unit);
+    void unite(uint32_t a, uint32_t b);
+    void bucket(const sc2::Units &army);
+    template <typename Visit> void neighbors(const sc2::Units &army, uint32_t unit, Visit visit);
+    void label(const sc2::Units &army);
+    void identify(FrameArena &arena);
+    void measure(Squad &squad, const sc2::UnitTypes &unitData) const;
+    int cellsX = 0;
+    int cellsY = 0;
+    // Units sorted by grid cell, the units of cell c are cellUnits[cellStart[c], cellStart[c + 1])
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> cellUnits;
+    std::vector<uint32_t> cellOf;
+    // Union-find forest over the core units
+    std::vector<uint32_t> parent;
+    std::vector<uint8_t> core;
+    std::vector<uint32_t> squadAt;
+    // Ids of the squads of the last update, by their index then
+    std::vector<uint32_t> previous;
+    // Units with the index of their squad, sorted by tag. Squads and this index are reused
+    // every update, so they only allocate when the army grows
+    std::vector<std::pair<sc2::Tag, uint32_t>> memberOf;
+    uint32_t nextId = 0;
+};
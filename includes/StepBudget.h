@@ -0,0 +1,41 @@
+#pragma once
+
+#include "constants.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Time budget of one OnStep, work of lower priority is deferred to later steps once it runs low
+struct StepBudget {
+    enum PRIORITY : uint8_t { CRITICAL, HIGH, NORMAL, LOW };
+    struct Task {
+        const char *name;
+        PRIORITY priority;
+        // Expected cost in milliseconds, of one chunk for sliced tasks
+        float estimate;
+        // Steps deferred in a row
+        uint32_t waited;
+        uint64_t ran;
+        uint64_t deferred;
+    };
+    std::size_t add(const char *name, PRIORITY priority, float estimate);
+    void begin();
+    bool run(std::size_t task, const std::function<void()> &work);
+    bool slice(std::size_t task, const std::function<bool()> &chunk);
+    void end();
+    float elapsed() const;
+    float ceiling = STEP_BUDGET_MS;
+    std::vector<Task> tasks;
+    // Counters over the game
+    uint64_t steps = 0;
+    uint64_t overruns = 0;
+    float worst = 0.0f;
+
+  private:
+    bool admit(const Task &task) const;
+    void defer(Task &task);
+    void measure(Task &task, float cost);
+    std::chrono::steady_clock::time_point started;
+};
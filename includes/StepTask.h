@@ -0,0 +1,101 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// Coroutine running across game steps, it suspends on the awaitables of a TaskScheduler.
+// Frames come from a pool of free lists and must only be created on the game thread
+struct StepTask {
+    struct promise_type {
+        StepTask get_return_object();
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+        static void *operator new(std::size_t size);
+        static void operator delete(void *frame, std::size_t size);
+    };
+
+    StepTask() = default;
+    explicit StepTask(std::coroutine_handle<promise_type> handle);
+    StepTask(StepTask &&other) noexcept;
+    StepTask &operator=(StepTask &&other) noexcept;
+    StepTask(const StepTask &) = delete;
+    StepTask &operator=(const StepTask &) = delete;
+    ~StepTask();
+    std::coroutine_handle<promise_type> release();
+
+  private:
+    std::coroutine_handle<promise_type> handle;
+};
+
+// Runs step tasks from OnStep. Tasks waiting for a game loop sit in a min-heap and cost
+// nothing until then, tasks waiting for a condition are checked once per step
+struct TaskScheduler {
+    // Resumes the task on the first step at or after a game loop
+    struct Sleep {
+        TaskScheduler &scheduler;
+        uint32_t loop;
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> task);
+        void await_resume() const {}
+    };
+    // The condition of a waiting task, type erased so the scheduler holds a plain pointer to it
+    struct Waiting {
+        bool (*check)(void *condition);
+        void *condition;
+        uint32_t deadline;
+        bool met;
+    };
+    // Resumes the task once a condition holds or a deadline passed, yields whether it held.
+    // The condition is kept in the awaiter, which lives in the coroutine frame while it waits
+    template <typename Condition> struct Until {
+        TaskScheduler &scheduler;
+        Condition condition;
+        Waiting waiting;
+        bool await_ready() {
+            waiting.met = condition();
+            return waiting.met;
+        }
+        void await_suspend(std::coroutine_handle<> task) {
+            waiting.check
+              = [](void *condition) { return (*static_cast<Condition *>(condition))(); };
+            waiting.condition = &condition;
+            scheduler.push(scheduler.gameLoop + 1, task, &waiting);
+        }
+        bool await_resume() const { return waiting.met; }
+    };
+
+    ~TaskScheduler();
+    void spawn(StepTask task);
+    void resume(uint32_t gameLoop);
+    void clear();
+    std::size_t size() const;
+    Sleep sleep(uint32_t loops);
+    template <typename Condition>
+    Until<Condition> until(Condition condition, uint32_t timeout = UINT32_MAX) {
+        return {*this, std::move(condition), {nullptr, nullptr, after(timeout), false}};
+    }
+
+  private:
+    struct Entry {
+        uint32_t loop;
+        // Order of suspension, so tasks due on the same loop run first come first served
+        uint64_t order;
+        std::coroutine_handle<> task;
+        // The condition the task waits for, nullptr if it only waits for the loop
+        Waiting *waiting;
+        bool operator>(const Entry &other) const {
+            return loop != other.loop ? loop > other.loop : order > other.order;
+        }
+    };
+    uint32_t after(uint32_t loops) const;
+    void push(uint32_t loop, std::coroutine_handle<> task, Waiting *waiting);
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    uint32_t gameLoop = 0;
+    uint64_t suspensions = 0;
+};
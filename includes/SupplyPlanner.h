@@ -0,0 +1,29 @@
+#pragma once
+
+#include "IncomeModel.h"
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+// Orders overlords just in time from the supply projected one overlord build time ahead
+struct SupplyPlanner {
+    void ordered(uint32_t gameLoop);
+    void overlordCreated();
+    void hatcheryStarted(const sc2::Unit *hatchery, uint32_t gameLoop);
+    void hatcheryFinished(sc2::Tag hatchery);
+    int incoming(uint32_t horizon) const;
+    int projected(int foodUsed, int hatcheries, int injected, const IncomeModel &income) const;
+    int needed(uint32_t gameLoop, int foodUsed, int foodCap, int hatcheries, int injected,
+               const IncomeModel &income);
+
+  private:
+    void expire(uint32_t gameLoop);
+    // Game loops the overlord eggs hatch on, oldest first
+    std::deque<uint32_t> overlords;
+    // Game loops the hatcheries under construction finish on
+    std::unordered_map<sc2::Tag, uint32_t> hatcheries;
+    uint32_t gameLoop = 0;
+};
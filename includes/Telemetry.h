@@ -0,0 +1,39 @@
+#pragma once
+
+#include "constants.h"
+#include "sc2-includes.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Telemetry {
+    Telemetry();
+    bool due(uint32_t gameLoop) const;
+    void countActions(std::size_t actions);
+    void countSupply(uint32_t gameLoop, int foodUsed, int foodCap);
+    void sample(const sc2::ObservationInterface *observation, int bases, float mineralRate);
+    bool write(const std::string &directory, const sc2::ObservationInterface *observation,
+               const std::string &result) const;
+    std::size_t size() const;
+    // Columns, preallocated for TELEMETRY_MAX_SAMPLES samples
+    std::vector<uint32_t> loop;
+    std::vector<int32_t> minerals;
+    std::vector<int32_t> vespene;
+    std::vector<int32_t> foodUsed;
+    std::vector<int32_t> foodCap;
+    std::vector<int32_t> idleLarva;
+    std::vector<int32_t> workers;
+    std::vector<int32_t> bases;
+    std::vector<int32_t> armySupply;
+    std::vector<uint32_t> actions;
+    std::vector<float> collectedMinerals;
+    std::vector<float> mineralForecast;
+    std::vector<uint32_t> blockedLoops;
+
+  private:
+    uint32_t nextSample = 0;
+    uint32_t pendingActions = 0;
+    uint32_t pendingBlocked = 0;
+    uint32_t lastLoop = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Every worker gets this many ranges of a parallel loop on average, the rest is stolen
+#define POOL_RANGES_PER_WORKER 8
+
+// Fixed set of worker threads, each with its own queue of index ranges to run
+struct ThreadPool {
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &task);
+    // The task also gets the index of the worker running it, e.g. to pick a per-worker buffer
+    void parallelFor(std::size_t count, std::size_t grain,
+                     const std::function<void(std::size_t, unsigned)> &task);
+    unsigned size() const;
+
+  private:
+    struct Range {
+        std::size_t begin;
+        std::size_t end;
+        // Kept with the range, a worker may pick up the next loop's ranges before it sleeps
+        const std::function<void(std::size_t, unsigned)> *task;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+    void work(unsigned self);
+    bool pop(unsigned self, Range &range);
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::atomic<std::size_t> remaining{0};
+    uint64_t epoch = 0;
+    bool stopping = false;
+};
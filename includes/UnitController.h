@@ -1,13 +1,18 @@
 #pragma once
 
+#include <cstdint>
+
 class OnPhone;
 struct AllyUnit;
 
 struct UnitController {
     OnPhone &bot;
-    UnitController(OnPhone &bot);
+    // EventDispatcher::WAKE events this controller subscribes to, 0 steps every unit every step
+    uint8_t wakeMask = 0;
+    UnitController(OnPhone &bot, uint8_t wakeMask = 0);
     virtual void step(AllyUnit &unit) = 0;
     virtual void onDeath(AllyUnit &unit) = 0;
     virtual void underAttack(AllyUnit &unit);
+    virtual bool awake(const AllyUnit &unit) const;
     void base_step(AllyUnit &unit);
 };
\ No newline at end of file
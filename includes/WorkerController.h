@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ThreadPool.h"
 #include "UnitController.h"
 #include "sc2-includes.h"
 
@@ -10,7 +11,8 @@ struct WorkerController : public UnitController {
     void onDeath(AllyUnit &unit);
     void extract(AllyUnit &unit);
     void mine(AllyUnit &unit);
-    void getMostDangerous();
+    void getMostDangerous(ThreadPool &pool);
+    bool awake(const AllyUnit &unit) const;
     const sc2::Unit *most_dangerous_all = nullptr;
     const sc2::Unit *most_dangerous_ground = nullptr;
 };
\ No newline at end of file
@@ -5,7 +5,132 @@
 #define BASE_SIZE 15.0f
 #define ENEMY_EPSILON 1.0f
 #define CLUSTER_DISTANCE 20.0f
-#define MAX_EXTRACTOR_WORKERS 3
+
+// frame delta thresholds
+#define DELTA_WINDOW_FRAMES 32
+#define DELTA_SHIELD_THRESHOLD 0.5f
+#define DELTA_ENERGY_THRESHOLD 25.0f
+
+// telemetry sampling
+#define LOOPS_PER_SECOND 22.4f
+#define TELEMETRY_INTERVAL 22
+#define TELEMETRY_MAX_SAMPLES 8192
+
+// enemy memory, confidence halves every half life
+#define ENEMY_REGION_SIZE 15.0f
+#define ENEMY_UNIT_HALF_LIFE 448.0f
+#define ENEMY_STRUCTURE_HALF_LIFE 4032.0f
+
+// adaptive build order, queens are added once the enemy air army reaches ADAPT_AIR_SUPPLY and
+// roaches whenever the enemy army leads ours by ADAPT_ARMY_MARGIN, at most every ADAPT_INTERVAL
+#define ADAPT_AIR_SUPPLY 4.0f
+#define ADAPT_AIR_QUEENS 2
+#define ADAPT_ARMY_MARGIN 8.0f
+#define ADAPT_ARMY_ROACHES 4
+#define ADAPT_INTERVAL 672
+
+// opponent store, one fixed-size record per game appended to OPPONENT_FILE in the data directory
+#define OPPONENT_FILE "opponents.bin"
+#define OPPONENT_DEFAULT_DIR "data"
+#define OPPONENT_MAGIC 0x52474E4Fu
+#define OPPONENT_VERSION 1
+#define OPPONENT_EXPLORATION 1.4142f
+
+// scouting scheduler, targets are scored by staleness * weight / (1 + distance / scale)
+#define SCOUT_WAYPOINT_WEIGHT 1.0f
+#define SCOUT_BASE_WEIGHT 3.0f
+#define SCOUT_ENEMY_BASE_WEIGHT 6.0f
+#define SCOUT_DISTANCE_SCALE 40.0f
+#define SCOUT_CANDIDATES 8
+
+// scout routes, stops seen within ROUTE_REVISIT_LOOPS are skipped
+#define ROUTE_UNREACHABLE 1000000.0f
+#define ROUTE_EPSILON 0.001f
+#define ROUTE_REVISIT_LOOPS 448
+
+// ground distances, unpathable points start from a pathable cell within this radius
+#define DISTANCE_SNAP_RADIUS 8
+
+// queen injects, energy regenerates 0.7875 per second of faster game speed
+#define INJECT_ENERGY_COST 25.0f
+#define INJECT_ENERGY_PER_LOOP (0.7875f / LOOPS_PER_SECOND)
+#define INJECT_DURATION_LOOPS 650
+
+// worker saturation, rebalanced every SATURATION_INTERVAL loops or when a base changes
+#define SATURATION_INTERVAL 224
+#define SATURATION_BATCH 4
+#define DRONE_SPEED_PER_LOOP (3.94f / LOOPS_PER_SECOND)
+
+// income model, rates per harvester are calibrated against mined resources over the window
+#define INCOME_SAMPLE_INTERVAL 22
+#define INCOME_WINDOW 16
+#define INCOME_MINERALS_PER_WORKER (57.5f / 60.0f / LOOPS_PER_SECOND)
+#define INCOME_VESPENE_PER_WORKER (53.7f / 60.0f / LOOPS_PER_SECOND)
+#define INCOME_OVERSATURATED_FACTOR 0.5f
+
+// drone dispatch, builders leave up to DISPATCH_HORIZON loops before the cost is banked and
+// go back to mining when their build is not requested for DISPATCH_TIMEOUT loops. Dropped build
+// commands are sent again up to DISPATCH_RETRIES times and builds not started after
+// DISPATCH_CONFIRM_LOOPS, longer than any walk, are given up. Researches are sent again when
+// they did not start within RESEARCH_CONFIRM_LOOPS
+#define DISPATCH_HORIZON 672
+#define DISPATCH_TIMEOUT 44
+#define DISPATCH_CONFIRM_LOOPS 896
+#define DISPATCH_RETRIES 2
+#define RESEARCH_CONFIRM_LOOPS 44
+
+// supply planner, overlords are ordered once the supply projected one overlord build time plus
+// SUPPLY_LEAD_LOOPS ahead reaches the cap, eggs that do not hatch SUPPLY_PENDING_SLACK loops
+// after their build time are assumed dead. The build order waits for an overlord that is
+// affordable within SUPPLY_SAVE_LOOPS
+#define OVERLORD_BUILD_LOOPS 403
+#define HATCHERY_BUILD_LOOPS 1590
+#define OVERLORD_SUPPLY 8
+#define HATCHERY_SUPPLY 6
+#define SUPPLY_MAX 200
+#define LARVA_SPAWN_LOOPS 246
+#define LARVA_NATURAL_MAX 3
+#define INJECT_LARVA 3
+#define SUPPLY_LEAD_LOOPS 44
+#define SUPPLY_PENDING_SLACK 224
+#define SUPPLY_SAVE_LOOPS 112
+#define SUPPLY_MINERALS_PER_FOOD 50.0f
+
+// flow fields, units move FLOW_LOOKAHEAD cells down the field per command
+#define FLOW_LOOKAHEAD 6
+#define FLOW_CACHE_SIZE 4
+// Cells a flow field search settles per time slice when it is built across steps
+#define FLOW_SLICE_CELLS 4096
+
+// army squads, units with SQUAD_MIN_UNITS units (themselves included) within SQUAD_RADIUS form
+// a squad's core, squads weaker than SQUAD_MERGE_SHARE of the strongest one regroup with it
+// while it is more than SQUAD_MERGE_DISTANCE away
+#define SQUAD_RADIUS 5.0f
+#define SQUAD_MIN_UNITS 3
+#define SQUAD_MERGE_SHARE 0.5f
+#define SQUAD_MERGE_DISTANCE 12.0f
+
+// thread pool, ONPHONE_THREADS overrides the worker count, threat scans split the enemies into
+// tasks of PARALLEL_TARGET_GRAIN units
+#define PARALLEL_TARGET_GRAIN 64
+
+// step tasks, coroutine frames up to TASK_FRAME_CLASSES * TASK_FRAME_CLASS bytes are recycled
+// through one free list per TASK_FRAME_CLASS bytes of size
+#define TASK_FRAME_CLASS 64
+#define TASK_FRAME_CLASSES 16
+
+// frame arena, bytes of scratch memory per step before allocations spill to the heap
+#define ARENA_CAPACITY (1 << 20)
+
+// step budget, lower priority work only starts while its share of the ceiling is left and runs
+// anyway once it was deferred STEP_BUDGET_MAX_WAIT steps in a row, cost estimates follow a rise
+// at once and decay by STEP_BUDGET_DECAY of the difference per step, or of the estimate per
+// deferred step
+#define STEP_BUDGET_MS 20.0f
+#define STEP_BUDGET_NORMAL_SHARE 0.8f
+#define STEP_BUDGET_LOW_SHARE 0.6f
+#define STEP_BUDGET_MAX_WAIT 8
+#define STEP_BUDGET_DECAY 0.125f
 
 // resource costs
 #define DRONE_MINERAL_COST 50
@@ -34,6 +159,14 @@ enum class ROLE {
     INTERMEDIATE // Refers to groups that become material for others, so drones that become buildings
 };
 
+// Opening build orders the opponent store picks from
+enum class OPENING {
+    ROACH,       // Pool, hatchery and roach warren into a roach ravager push
+    LING_FLOOD,  // Early pool into mass zerglings with metabolic boost
+    HATCH_FIRST, // Hatchery first with two queens before the roach warren
+    COUNT
+};
+
 enum class TASK {
     UNSET, // Specifically for group task setting
     ATTACK,
@@ -43,5 +176,6 @@ enum class TASK {
     SCOUT_ALL,
     FAST_SCOUT,
     MOVE,
-    RALLY
+    RALLY,
+    BUILD // Drones walking to a build site ahead of the cost
 };
\ No newline at end of file
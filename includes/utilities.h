@@ -1,4 +1,28 @@
 #pragma once
 
+#include "DistanceMatrix.h"
+#include "FrameArena.h"
+#include "Geometry.h"
+#include "ThreadPool.h"
+#include "constants.h"
 #include "sc2-includes.h"
-bool IsBuilding(const sc2::Unit &unit);
\ No newline at end of file
+
+#include <functional>
+#include <vector>
+
+bool IsBuilding(const sc2::Unit &unit);
+bool IsTownHall(sc2::UNIT_TYPEID type);
+bool IsWorker(sc2::UNIT_TYPEID type);
+bool IsDetector(sc2::UNIT_TYPEID type);
+bool IsResource(const sc2::Unit &unit);
+std::vector<sc2::Point2D> FindResourceClusters(const sc2::Units &resources,
+                                               std::vector<sc2::Point2D> clusters = {});
+void FindMostDangerous(const sc2::Units &enemies, const sc2::UnitTypes &unitData,
+                       const std::function<bool(const sc2::Unit &)> &inRange,
+                       const sc2::Unit *&all, const sc2::Unit *&ground);
+void FindMostDangerous(const sc2::Units &enemies, const sc2::UnitTypes &unitData,
+                       const std::function<bool(const sc2::Unit &)> &inRange,
+                       const sc2::Unit *&all, const sc2::Unit *&ground, ThreadPool &pool,
+                       FrameArena &arena);
+void SortExpansionMinerals(sc2::Units &minerals, const DistanceMatrix &distances,
+                           const sc2::Point2D &from);
@@ -0,0 +1,326 @@
+#include "ForwardModel.h"
+
+#include <algorithm>
+#include <limits>
+
+/**
+ * @brief Advances the economy by SIM_TICK_LOOPS game loops.
+ *
+ * Mines with the same per-worker rates as the bot's income model, spawns
+ * larva, regenerates queen energy, injects every hatchery with a queen as
+ * soon as possible and finishes everything whose build time has passed.
+ */
+void Economy::tick() {
+    minerals += mineralRate() * SIM_TICK_LOOPS;
+    vespene += std::min(gasDrones, EXTRACTOR_WORKERS * extractors) * INCOME_VESPENE_PER_WORKER
+               * SIM_TICK_LOOPS;
+    loop += SIM_TICK_LOOPS;
+
+    for(int h = 0; h < hatcheries; ++h) {
+        if(larva[h] < LARVA_NATURAL_MAX) {
+            larvaTimer[h] += SIM_TICK_LOOPS;
+            if(larvaTimer[h] >= LARVA_SPAWN_LOOPS) {
+                ++larva[h];
+                larvaTimer[h] -= LARVA_SPAWN_LOOPS;
+            }
+        } else {
+            larvaTimer[h] = 0;
+        }
+        if(!queen[h]) { continue; }
+        if(injectEnds[h] != 0 && loop >= injectEnds[h]) {
+            larva[h] = std::min(larva[h] + INJECT_LARVA, LARVA_MAX);
+            injectEnds[h] = 0;
+        }
+        queenEnergy[h]
+          = std::min(QUEEN_MAX_ENERGY, queenEnergy[h] + INJECT_ENERGY_PER_LOOP * SIM_TICK_LOOPS);
+        if(injectEnds[h] == 0 && queenEnergy[h] >= INJECT_ENERGY_COST) {
+            queenEnergy[h] -= INJECT_ENERGY_COST;
+            injectEnds[h] = loop + INJECT_DURATION_LOOPS;
+        }
+    }
+
+    for(int i = pendingCount - 1; i >= 0; --i) {
+        if(pending[i].done > loop) { continue; }
+        finish(pending[i].item);
+        pending[i] = pending[--pendingCount];
+    }
+}
+
+/**
+ * @brief Gets the mineral income per game loop.
+ *
+ * @return float The minerals mined per game loop
+ */
+float Economy::mineralRate() const {
+    const int mineralDrones = drones - gasDrones;
+    const int ideal = 16 * hatcheries;
+    const int extra = std::max(0, std::min(mineralDrones - ideal, ideal / 2));
+    return (std::min(mineralDrones, ideal) + INCOME_OVERSATURATED_FACTOR * extra)
+           * INCOME_MINERALS_PER_WORKER;
+}
+
+/**
+ * @brief Checks if an overlord is due, with the same projection as the bot's SupplyPlanner.
+ *
+ * @return true if the supply used one overlord build time ahead reaches the cap
+ */
+bool Economy::needsOverlord() const {
+    const uint32_t horizon = OVERLORD_BUILD_LOOPS + SUPPLY_LEAD_LOOPS;
+    int cap = supplyCap;
+    for(int i = 0; i < pendingCount; ++i) {
+        if(pending[i].item == ITEM::OVERLORD) { cap += OVERLORD_SUPPLY; }
+        if(pending[i].item == ITEM::HATCHERY && pending[i].done <= loop + horizon) {
+            cap += HATCHERY_SUPPLY;
+        }
+    }
+    if(cap >= SUPPLY_MAX) { return false; }
+    const float mineralFood = (minerals + mineralRate() * horizon) / SUPPLY_MINERALS_PER_FOOD;
+    const int injected = static_cast<int>(std::count(queen, queen + hatcheries, true));
+    const float larvaFood = hatcheries * (LARVA_NATURAL_MAX + static_cast<float>(horizon)
+                                                                / LARVA_SPAWN_LOOPS)
+                            + injected * INJECT_LARVA * static_cast<float>(horizon)
+                                / INJECT_DURATION_LOOPS;
+    return supply + static_cast<int>(std::min(mineralFood, larvaFood)) >= cap;
+}
+
+/**
+ * @brief Starts building an item, like the matching Build* function of the bot.
+ *
+ * @param item The item to build
+ * @return true if the item was started, false if it is not possible yet
+ */
+bool Economy::start(ITEM item) {
+    if(pendingCount == SIM_MAX_PENDING) { return false; }
+    const bool hasLarva
+      = std::any_of(larva, larva + hatcheries, [](int count) { return count > 0; });
+    const bool hasDrone = drones - gasDrones > 0;
+    switch(item) {
+    case ITEM::DRONE:
+        if(!hasLarva || !pay(DRONE_MINERAL_COST, 0, DRONE_FOOD_COST)) { return false; }
+        takeLarva();
+        queue(item, DRONE_BUILD_LOOPS);
+        return true;
+    case ITEM::OVERLORD:
+        if(!hasLarva || !pay(OVERLORD_MINERAL_COST, 0, 0)) { return false; }
+        takeLarva();
+        queue(item, OVERLORD_BUILD_LOOPS);
+        return true;
+    case ITEM::ZERGLING:
+        if(!pool || !hasLarva || !pay(ZERGLING_MINERAL_COST, 0, ZERGLING_FOOD_COST)) {
+            return false;
+        }
+        takeLarva();
+        queue(item, ZERGLING_BUILD_LOOPS);
+        return true;
+    case ITEM::ROACH:
+        if(!warren || !hasLarva || !pay(ROACH_MINERAL_COST, ROACH_VESPENE_COST, ROACH_FOOD_COST)) {
+            return false;
+        }
+        takeLarva();
+        queue(item, ROACH_BUILD_LOOPS);
+        return true;
+    case ITEM::RAVAGER:
+        // A ravager takes one supply more than the roach it morphs from
+        if(!warren || army.roaches == 0 || !pay(RAVAGER_MINERAL_COST, RAVAGER_VESPENE_COST, 1)) {
+            return false;
+        }
+        --army.roaches;
+        queue(item, RAVAGER_BUILD_LOOPS);
+        return true;
+    case ITEM::QUEEN:
+        if(!pool || queensQueued >= hatcheries || !pay(QUEEN_MINERAL_COST, 0, QUEEN_FOOD_COST)) {
+            return false;
+        }
+        ++queensQueued;
+        queue(item, QUEEN_BUILD_LOOPS);
+        return true;
+    case ITEM::SPAWNINGPOOL:
+        if(!hasDrone || !pay(SPAWNINGPOOL_COST, 0, 0)) { return false; }
+        takeDrone();
+        queue(item, SPAWNINGPOOL_BUILD_LOOPS);
+        return true;
+    case ITEM::EXTRACTOR:
+        if(!hasDrone || !pay(EXTRACTOR_COST, 0, 0)) { return false; }
+        takeDrone();
+        queue(item, EXTRACTOR_BUILD_LOOPS);
+        return true;
+    case ITEM::HATCHERY:
+        if(!hasDrone || !pay(HATCHERY_COST, 0, 0)) { return false; }
+        takeDrone();
+        queue(item, HATCHERY_BUILD_LOOPS);
+        return true;
+    case ITEM::ROACHWARREN:
+        if(!pool || !hasDrone || !pay(ROACHWARREN_COST, 0, 0)) { return false; }
+        takeDrone();
+        queue(item, ROACHWARREN_BUILD_LOOPS);
+        return true;
+    case ITEM::METABOLICBOOST:
+        if(!pool || !pay(METABOLIC_BOOST_COST, METABOLIC_BOOST_COST, 0)) { return false; }
+        queue(item, METABOLIC_BOOST_BUILD_LOOPS);
+        return true;
+    default: return false;
+    }
+}
+
+/**
+ * @brief Checks if the finished army covers a target composition.
+ *
+ * @param target The target army
+ * @return true if every unit type reached its target count, false otherwise
+ */
+bool Economy::has(const Army &target) const {
+    return army.zerglings >= target.zerglings && army.roaches >= target.roaches
+           && army.ravagers >= target.ravagers && army.queens >= target.queens;
+}
+
+/**
+ * @brief Gets the share of the target army supply that is still missing.
+ *
+ * @param target The target army
+ * @return float The missing supply over the target supply, 0 if the target is reached
+ */
+float Economy::missing(const Army &target) const {
+    const float total = target.zerglings * 0.5f + target.roaches * 2.0f + target.ravagers * 3.0f
+                        + target.queens * 2.0f;
+    if(total <= 0.0f) { return 0.0f; }
+    const float lacking = std::max(0, target.zerglings - army.zerglings) * 0.5f
+                          + std::max(0, target.roaches - army.roaches) * 2.0f
+                          + std::max(0, target.ravagers - army.ravagers) * 3.0f
+                          + std::max(0, target.queens - army.queens) * 2.0f;
+    return lacking / total;
+}
+
+/**
+ * @brief Pays for an item if the bank and supply allow it.
+ *
+ * @param mineralCost The mineral cost
+ * @param vespeneCost The vespene cost
+ * @param food The supply the item takes
+ * @return true if the item was paid for, false otherwise
+ */
+bool Economy::pay(int mineralCost, int vespeneCost, int food) {
+    if(minerals < mineralCost || vespene < vespeneCost || supply + food > supplyCap) {
+        return false;
+    }
+    minerals -= mineralCost;
+    vespene -= vespeneCost;
+    supply += food;
+    return true;
+}
+
+/**
+ * @brief Takes a larva from the hatchery with the most larva.
+ *
+ * @return true if a larva was taken, false if there is none
+ */
+bool Economy::takeLarva() {
+    int *most = std::max_element(larva, larva + hatcheries);
+    if(*most == 0) { return false; }
+    --*most;
+    return true;
+}
+
+/**
+ * @brief Turns a mineral drone into a building.
+ *
+ * @return true if a drone was taken, false if no drone is mining minerals
+ */
+bool Economy::takeDrone() {
+    if(drones - gasDrones <= 0) { return false; }
+    --drones;
+    --supply;
+    return true;
+}
+
+/**
+ * @brief Adds an item to the items in production.
+ *
+ * @param item The item that was started
+ * @param loops The build time of the item
+ */
+void Economy::queue(ITEM item, uint32_t loops) { pending[pendingCount++] = {loop + loops, item}; }
+
+/**
+ * @brief Applies a finished item.
+ *
+ * New drones and extractors fill the extractors first, like the saturation manager.
+ *
+ * @param item The item that finished
+ */
+void Economy::finish(ITEM item) {
+    switch(item) {
+    case ITEM::DRONE:
+        ++drones;
+        if(gasDrones < EXTRACTOR_WORKERS * extractors) { ++gasDrones; }
+        break;
+    case ITEM::OVERLORD:
+        ++overlords;
+        supplyCap = std::min(SUPPLY_MAX, supplyCap + OVERLORD_SUPPLY);
+        break;
+    case ITEM::ZERGLING: army.zerglings += 2; break;
+    case ITEM::ROACH: ++army.roaches; break;
+    case ITEM::RAVAGER: ++army.ravagers; break;
+    case ITEM::QUEEN:
+        ++army.queens;
+        for(int h = 0; h < hatcheries; ++h) {
+            if(!queen[h]) {
+                queen[h] = true;
+                queenEnergy[h] = INJECT_ENERGY_COST;
+                break;
+            }
+        }
+        break;
+    case ITEM::SPAWNINGPOOL: pool = true; break;
+    case ITEM::EXTRACTOR:
+        ++extractors;
+        gasDrones += std::min(EXTRACTOR_WORKERS, drones - gasDrones);
+        break;
+    case ITEM::HATCHERY:
+        if(hatcheries < SIM_MAX_HATCHERIES) {
+            larva[hatcheries] = 1;
+            ++hatcheries;
+        }
+        supplyCap = std::min(SUPPLY_MAX, supplyCap + HATCHERY_SUPPLY);
+        break;
+    case ITEM::ROACHWARREN: warren = true; break;
+    case ITEM::METABOLICBOOST: boost = true; break;
+    default: break;
+    }
+}
+
+/**
+ * @brief Plays a build order the way OnPhone::ExecuteBuildOrder does.
+ *
+ * Overlords are ordered first whenever the supply planner would order one.
+ * The next item is started once supply reaches its trigger, drones are built
+ * while supply is below it, and nothing is built once the order is done.
+ *
+ * @param order The build order
+ * @param target The army to build
+ * @param limit The game loop to give up at
+ * @return SimResult When the target was reached and the economy at that point,
+ * scored so that lower is better
+ */
+SimResult Simulate(const std::vector<BuildItem> &order, const Army &target, uint32_t limit) {
+    Economy economy;
+    std::size_t next = 0;
+    uint32_t reached = std::numeric_limits<uint32_t>::max();
+    while(economy.loop < limit) {
+        if(economy.needsOverlord()) { economy.start(ITEM::OVERLORD); }
+        for(int action = 0; action < SIM_ACTIONS_PER_TICK && next < order.size(); ++action) {
+            const bool due = economy.supply >= order[next].supply;
+            if(!economy.start(due ? order[next].item : ITEM::DRONE)) { break; }
+            if(due) { ++next; }
+        }
+        economy.tick();
+        if(economy.has(target)) {
+            reached = economy.loop;
+            break;
+        }
+    }
+    // Reaching the army sooner wins, more drones at that point break ties
+    const float time = reached != std::numeric_limits<uint32_t>::max()
+                         ? static_cast<float>(reached)
+                         : limit * (1.0f + economy.missing(target));
+    return {reached, economy.army, economy.drones, time - 0.25f * economy.drones};
+}
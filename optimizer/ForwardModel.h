@@ -0,0 +1,113 @@
+#pragma once
+
+#include "constants.h"
+
+#include <cstdint>
+#include <vector>
+
+// Build times in game loops at faster speed, overlords and hatcheries are in constants.h
+#define DRONE_BUILD_LOOPS 269
+#define ZERGLING_BUILD_LOOPS 381
+#define QUEEN_BUILD_LOOPS 806
+#define ROACH_BUILD_LOOPS 426
+#define RAVAGER_BUILD_LOOPS 192
+#define SPAWNINGPOOL_BUILD_LOOPS 1030
+#define EXTRACTOR_BUILD_LOOPS 470
+#define ROACHWARREN_BUILD_LOOPS 874
+#define METABOLIC_BOOST_BUILD_LOOPS 1770
+
+// Larva and supply rules, beyond the ones the supply planner shares
+#define LARVA_MAX 19
+#define QUEEN_MAX_ENERGY 200.0f
+#define EXTRACTOR_WORKERS 3
+
+// Simulation resolution, the bot acts on every step but the economy changes slowly
+#define SIM_TICK_LOOPS 8
+#define SIM_MAX_HATCHERIES 8
+#define SIM_MAX_PENDING 64
+#define SIM_ACTIONS_PER_TICK 4
+
+enum class ITEM : uint8_t {
+    DRONE,
+    OVERLORD,
+    EXTRACTOR,
+    SPAWNINGPOOL,
+    HATCHERY,
+    ZERGLING,
+    QUEEN,
+    ROACHWARREN,
+    METABOLICBOOST,
+    ROACH,
+    RAVAGER,
+    COUNT
+};
+
+// A build order entry as the bot runs it, started once supply reaches the trigger
+struct BuildItem {
+    int supply;
+    ITEM item;
+    bool operator==(const BuildItem &other) const {
+        return supply == other.supply && item == other.item;
+    }
+};
+
+struct Army {
+    int zerglings = 0;
+    int roaches = 0;
+    int ravagers = 0;
+    int queens = 0;
+};
+
+struct SimResult {
+    // Game loop the target army was complete on, UINT32_MAX if it never was
+    uint32_t reached;
+    Army army;
+    int drones;
+    float score;
+};
+
+// Deterministic Zerg economy and production, advanced SIM_TICK_LOOPS at a time
+struct Economy {
+    void tick();
+    bool start(ITEM item);
+    bool has(const Army &target) const;
+    float missing(const Army &target) const;
+    float mineralRate() const;
+    bool needsOverlord() const;
+    uint32_t loop = 0;
+    float minerals = 50.0f;
+    float vespene = 0.0f;
+    int drones = 12;
+    int gasDrones = 0;
+    int supply = 12;
+    int supplyCap = HATCHERY_SUPPLY + OVERLORD_SUPPLY;
+    int hatcheries = 1;
+    int extractors = 0;
+    int overlords = 1;
+    bool pool = false;
+    bool warren = false;
+    bool boost = false;
+    Army army;
+
+  private:
+    struct Pending {
+        uint32_t done;
+        ITEM item;
+    };
+    bool pay(int mineralCost, int vespeneCost, int food);
+    bool takeLarva();
+    bool takeDrone();
+    void queue(ITEM item, uint32_t loops);
+    void finish(ITEM item);
+    int larva[SIM_MAX_HATCHERIES] = {3};
+    uint32_t larvaTimer[SIM_MAX_HATCHERIES] = {};
+    uint32_t injectEnds[SIM_MAX_HATCHERIES] = {};
+    float queenEnergy[SIM_MAX_HATCHERIES] = {};
+    bool queen[SIM_MAX_HATCHERIES] = {};
+    Pending pending[SIM_MAX_PENDING];
+    int pendingCount = 0;
+    int queensQueued = 0;
+    int roachesMorphing = 0;
+};
+
+SimResult Simulate(const std::vector<BuildItem> &order, const Army &target, uint32_t limit);
@@ -0,0 +1,286 @@
+#include "ForwardModel.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Beam search defaults, every generation mutates each kept order SEARCH_CHILDREN times
+#define SEARCH_BEAM 32
+#define SEARCH_CHILDREN 64
+#define SEARCH_GENERATIONS 300
+#define SEARCH_MAX_ITEMS 48
+#define SEARCH_MIN_SUPPLY 12
+#define SEARCH_SECONDS 360
+#define SEARCH_ARMY "zergling=16,roach=4,ravager=1"
+
+struct Candidate {
+    std::vector<BuildItem> order;
+    SimResult result;
+};
+
+// Small deterministic generator, seeded per child so results do not depend on the thread count
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed) {}
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    int below(int n) { return n <= 0 ? 0 : static_cast<int>(next() % static_cast<uint64_t>(n)); }
+};
+
+static const char *ITEM_FUNCTIONS[]
+  = {"BuildDrone",    "BuildOverlord", "BuildExtractor",   "BuildSpawningPool",
+     "BuildHatchery", "BuildZergling", "BuildQueen",       "BuildRoachWarren",
+     "ResearchMetabolicBoost", "BuildRoach", "BuildRavager"};
+static const char *ITEM_COSTS[] = {"DRONE_MINERAL_COST",
+                                   "OVERLORD_MINERAL_COST",
+                                   "EXTRACTOR_COST, 0, true",
+                                   "SPAWNINGPOOL_COST, 0, true",
+                                   "HATCHERY_COST, 0, true",
+                                   "ZERGLING_MINERAL_COST",
+                                   "QUEEN_MINERAL_COST",
+                                   "ROACHWARREN_COST, 0, true",
+                                   "METABOLIC_BOOST_COST, METABOLIC_BOOST_COST",
+                                   "ROACH_MINERAL_COST, ROACH_VESPENE_COST",
+                                   "RAVAGER_MINERAL_COST, RAVAGER_VESPENE_COST"};
+
+/**
+ * @brief Gets the build order the bot currently plays, from OnPhone::OnGameStart.
+ *
+ * @return std::vector<BuildItem> The hand tuned build order
+ */
+static std::vector<BuildItem> CurrentOrder() {
+    std::vector<BuildItem> order
+      = {{16, ITEM::EXTRACTOR}, {16, ITEM::SPAWNINGPOOL}, {17, ITEM::HATCHERY}};
+    for(int i = 0; i < 3; ++i) { order.push_back({16, ITEM::ZERGLING}); }
+    order.push_back({19, ITEM::QUEEN});
+    order.push_back({21, ITEM::ROACHWARREN});
+    order.push_back({21, ITEM::METABOLICBOOST});
+    for(int i = 0; i < 4; ++i) { order.push_back({21, ITEM::ROACH}); }
+    for(int i = 0; i < 5; ++i) { order.push_back({29, ITEM::ZERGLING}); }
+    order.push_back({34, ITEM::RAVAGER});
+    for(int i = 0; i < 5; ++i) { order.push_back({29, ITEM::ZERGLING}); }
+    order.push_back({19, ITEM::QUEEN});
+    return order;
+}
+
+/**
+ * @brief Makes a variant of a build order with one to three random edits.
+ *
+ * Edits shift a supply trigger, swap or move items, or insert, duplicate or
+ * remove an item. Drones are never inserted, the bot builds them between items.
+ *
+ * @param parent The build order to vary
+ * @param random The generator to draw the edits from
+ * @return std::vector<BuildItem> The varied build order
+ */
+static std::vector<BuildItem> Mutate(const std::vector<BuildItem> &parent, Random &random) {
+    std::vector<BuildItem> order = parent;
+    const int edits = 1 + random.below(3);
+    for(int edit = 0; edit < edits; ++edit) {
+        const int size = static_cast<int>(order.size());
+        const int i = random.below(size);
+        switch(random.below(6)) {
+        case 0:
+            if(size > 0) {
+                order[i].supply
+                  = std::max(SEARCH_MIN_SUPPLY, order[i].supply + random.below(7) - 3);
+            }
+            break;
+        case 1:
+            if(size > 1) { std::swap(order[i], order[(i + 1) % size]); }
+            break;
+        case 2:
+            if(size < SEARCH_MAX_ITEMS) {
+                const ITEM item
+                  = static_cast<ITEM>(1 + random.below(static_cast<int>(ITEM::COUNT) - 1));
+                const int supply = size > 0 ? order[i].supply : SEARCH_MIN_SUPPLY;
+                order.insert(order.begin() + i, {supply, item});
+            }
+            break;
+        case 3:
+            if(size > 1) { order.erase(order.begin() + i); }
+            break;
+        case 4:
+            if(size > 0 && size < SEARCH_MAX_ITEMS) {
+                order.insert(order.begin() + i, order[i]);
+            }
+            break;
+        default:
+            if(size > 1) {
+                const BuildItem moved = order[i];
+                order.erase(order.begin() + i);
+                order.insert(order.begin() + random.below(size), moved);
+            }
+            break;
+        }
+    }
+    return order;
+}
+
+/**
+ * @brief Parses an army composition like "zergling=16,roach=4".
+ *
+ * @param text The composition
+ * @param army The parsed army
+ * @return true if every entry named a known unit, false otherwise
+ */
+static bool ParseArmy(const std::string &text, Army &army) {
+    army = Army();
+    std::size_t start = 0;
+    while(start < text.size()) {
+        std::size_t end = text.find(',', start);
+        if(end == std::string::npos) { end = text.size(); }
+        const std::string entry = text.substr(start, end - start);
+        const std::size_t equals = entry.find('=');
+        if(equals == std::string::npos) { return false; }
+        const std::string name = entry.substr(0, equals);
+        const int count = std::atoi(entry.c_str() + equals + 1);
+        if(name == "zergling") {
+            army.zerglings = count;
+        } else if(name == "roach") {
+            army.roaches = count;
+        } else if(name == "ravager") {
+            army.ravagers = count;
+        } else if(name == "queen") {
+            army.queens = count;
+        } else {
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+/**
+ * @brief Prints a build order as the lines to paste into OnPhone::OnGameStart.
+ *
+ * @param order The build order
+ */
+static void PrintOrder(const std::vector<BuildItem> &order) {
+    for(const auto &step : order) {
+        const int item = static_cast<int>(step.item);
+        std::printf("    buildOrder.push_back({%d, std::bind(&OnPhone::%s, this), %s});\n",
+                    step.supply, ITEM_FUNCTIONS[item], ITEM_COSTS[item]);
+    }
+}
+
+/**
+ * @brief Prints the outcome of a build order.
+ *
+ * @param label The name of the build order
+ * @param candidate The build order and its simulated result
+ */
+static void PrintResult(const char *label, const Candidate &candidate) {
+    const SimResult &result = candidate.result;
+    if(result.reached == UINT32_MAX) {
+        std::printf("%-9s target not reached", label);
+    } else {
+        std::printf("%-9s target reached at %.0fs", label, result.reached / LOOPS_PER_SECOND);
+    }
+    std::printf(" (%d zerglings, %d roaches, %d ravagers, %d queens, %d drones, %zu items)\n",
+                result.army.zerglings, result.army.roaches, result.army.ravagers,
+                result.army.queens, result.drones, candidate.order.size());
+}
+
+/**
+ * @brief Searches for the build order that reaches a target army soonest.
+ *
+ * Runs a beam search seeded with the bot's current build order. Each
+ * generation mutates every kept order, plays all variants in the forward
+ * model across the thread pool and keeps the best distinct orders.
+ */
+int main(int argc, char *argv[]) {
+    std::string armyText = SEARCH_ARMY;
+    int seconds = SEARCH_SECONDS;
+    int generations = SEARCH_GENERATIONS;
+    int beamWidth = SEARCH_BEAM;
+    int children = SEARCH_CHILDREN;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        const char *value = argv[i + 1];
+        if(option == "--army") {
+            armyText = value;
+        } else if(option == "--time") {
+            seconds = std::atoi(value);
+        } else if(option == "--generations") {
+            generations = std::atoi(value);
+        } else if(option == "--beam") {
+            beamWidth = std::max(1, std::atoi(value));
+        } else if(option == "--children") {
+            children = std::max(1, std::atoi(value));
+        } else if(option == "--threads") {
+            threads = static_cast<unsigned>(std::max(1, std::atoi(value)));
+        } else if(option == "--seed") {
+            seed = std::strtoull(value, nullptr, 10);
+        } else {
+            std::fprintf(stderr, "Unknown option %s\n", option.c_str());
+            return 1;
+        }
+    }
+    Army army;
+    if(!ParseArmy(armyText, army)) {
+        std::fprintf(stderr, "Usage: %s [--army zergling=16,roach=4,ravager=1] [--time seconds]\n"
+                             "       [--generations n] [--beam n] [--children n] [--threads n]"
+                             " [--seed n]\n", argv[0]);
+        return 1;
+    }
+    const uint32_t limit = static_cast<uint32_t>(seconds * LOOPS_PER_SECOND);
+
+    ThreadPool pool(threads);
+    Candidate current = {CurrentOrder(), SimResult()};
+    current.result = Simulate(current.order, army, limit);
+    std::vector<Candidate> beam = {current};
+    std::vector<Candidate> next;
+    uint64_t simulations = 1;
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int generation = 0; generation < generations; ++generation) {
+        next.assign(beam.size() * children, Candidate());
+        pool.parallelFor(next.size(), [&](std::size_t i) {
+            Random random(seed * 0x2545F4914F6CDD1Dull + generation * 0x100000001B3ull + i);
+            next[i].order = Mutate(beam[i % beam.size()].order, random);
+            next[i].result = Simulate(next[i].order, army, limit);
+        });
+        simulations += next.size();
+        next.insert(next.end(), beam.begin(), beam.end());
+        std::stable_sort(next.begin(), next.end(), [](const Candidate &a, const Candidate &b) {
+            if(a.result.score != b.result.score) { return a.result.score < b.result.score; }
+            return a.order.size() < b.order.size();
+        });
+        beam.clear();
+        for(const auto &candidate : next) {
+            if(static_cast<int>(beam.size()) == beamWidth) { break; }
+            const bool duplicate
+              = std::any_of(beam.begin(), beam.end(),
+                            [&](const Candidate &kept) { return kept.order == candidate.order; });
+            if(!duplicate) { beam.push_back(candidate); }
+        }
+        if((generation + 1) % 25 == 0 || generation + 1 == generations) {
+            const double elapsed
+              = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::fprintf(stderr, "generation %4d  best %7.1fs  %.2fM games/min\n", generation + 1,
+                         beam.front().result.score / LOOPS_PER_SECOND,
+                         simulations / elapsed * 60.0 / 1e6);
+        }
+    }
+
+    std::printf("Target army: %s by %ds, %u threads, %llu games simulated\n", armyText.c_str(),
+                seconds, pool.size(), static_cast<unsigned long long>(simulations));
+    PrintResult("Current:", current);
+    PrintResult("Best:", beam.front());
+    std::printf("\n");
+    PrintOrder(beam.front().order);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+"""Compares two bot-bench JSON results and flags regressions."""
+
+import json
+import sys
+
+THRESHOLD = 0.10
+
+
+def load(path):
+    with open(path) as file:
+        return {entry['name']: entry for entry in json.load(file)['benchmarks']}
+
+
+def main(before_path, after_path, threshold=THRESHOLD):
+    before = load(before_path)
+    after = load(after_path)
+    regressions = 0
+    print('%-36s %12s %12s %8s %10s' % ('benchmark', 'before ns', 'after ns', 'change', 'allocs'))
+    for name, entry in after.items():
+        if name not in before:
+            print('%-36s %12s %12.1f %8s %10.2f' % (name, '-', entry['ns_per_op'], 'new',
+                                                    entry['allocations_per_op']))
+            continue
+        old = before[name]
+        change = entry['ns_per_op'] / old['ns_per_op'] - 1.0 if old['ns_per_op'] > 0 else 0.0
+        slower = change > threshold
+        allocates = entry['allocations_per_op'] > old['allocations_per_op'] + 0.01
+        flag = '  <-- regression' if slower or allocates else ''
+        regressions += 1 if flag else 0
+        print('%-36s %12.1f %12.1f %+7.1f%% %10.2f%s' % (name, old['ns_per_op'], entry['ns_per_op'],
+                                                        100.0 * change,
+                                                        entry['allocations_per_op'], flag))
+    if regressions:
+        sys.exit('%d benchmark(s) regressed' % regressions)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) not in (3, 4):
+        sys.exit('usage: bench-compare.py BEFORE.json AFTER.json [THRESHOLD]')
+    main(sys.argv[1], sys.argv[2], float(sys.argv[3]) if len(sys.argv) == 4 else THRESHOLD)
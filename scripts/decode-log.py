@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""Converts a binary OnPhone log (ONPHONE_LOG_BINARY) back into text."""
+
+import re
+import struct
+import sys
+
+SIZES = {'i': '<i', 'I': '<I', 'l': '<q', 'L': '<Q', 'd': '<d'}
+LENGTH = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(?:hh|h|ll|l|z|j|t)?([diouxXeEfgGcs%])')
+
+
+def read(data, offset, fmt):
+    value = struct.unpack_from(fmt, data, offset)[0]
+    return value, offset + struct.calcsize(fmt)
+
+
+def read_string(data, offset):
+    length, offset = read(data, offset, '<I')
+    return data[offset:offset + length].decode('utf-8', 'replace'), offset + length
+
+
+def main(path):
+    data = open(path, 'rb').read()
+    if data[:8] != b'ONPHLOG1':
+        sys.exit('not an OnPhone binary log: ' + path)
+    offset = 8
+    sites = {}
+    while offset < len(data):
+        site, offset = read(data, offset, '<I')
+        if site == 0xFFFFFFFF:
+            site, offset = read(data, offset, '<I')
+            _, offset = read(data, offset, '<i')
+            fmt, offset = read_string(data, offset)
+            signature, offset = read_string(data, offset)
+            sites[site] = (LENGTH.sub(r'%\1\2', fmt), signature)
+            continue
+        fmt, signature = sites[site]
+        timestamp, offset = read(data, offset, '<q')
+        suppressed, offset = read(data, offset, '<I')
+        args = []
+        for code in signature:
+            if code == 's':
+                value, offset = read_string(data, offset)
+            else:
+                value, offset = read(data, offset, SIZES[code])
+            args.append(value)
+        line = fmt % tuple(args)
+        if suppressed:
+            line += ' (%d similar messages suppressed)' % suppressed
+        print('%.6f %s' % (timestamp / 1e9, line))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 2:
+        sys.exit('usage: decode-log.py <binary log>')
+    main(sys.argv[1])
@@ -0,0 +1,79 @@
+#!/bin/bash
+
+# Summarise the per-game telemetry CSV files written by the bot when
+# ONPHONE_TELEMETRY_DIR is set (scripts/test.sh does this for every run).
+
+if [ $# -ne 1 ] || [ ! -d "$1" ]; then
+    echo "Usage: $0 <telemetry directory>"
+    exit 1
+fi
+
+shopt -s nullglob
+files=("$1"/*.csv)
+if [ ${#files[@]} -eq 0 ]; then
+    echo "No telemetry files found in $1"
+    exit 1
+fi
+
+awk -F, '
+    FNR == 1 {
+        # header comment: # map=<map> race=<race> result=<result> loops=<loops>
+        game++
+        split($0, fields, " ")
+        for(i in fields) {
+            split(fields[i], kv, "=")
+            info[kv[1]] = kv[2]
+        }
+        map[game] = info["map"]; race[game] = info["race"]; result[game] = info["result"]
+        length_s[game] = info["loops"] / 22.4
+        next
+    }
+    FNR == 2 { prev_loop = 0; prev_collected = -1; next }
+    {
+        samples[game]++
+        # minerals the forecast of the previous sample predicted for this interval vs mined
+        if(NF >= 14 && prev_collected >= 0 && $13 >= prev_collected) {
+            forecast[game] += prev_forecast * ($1 - prev_loop) / 22.4 / 60
+            mined[game] += $13 - prev_collected
+        }
+        prev_loop = $1; prev_collected = $13; prev_forecast = $14
+        # supply blocked share, from the per-step loop count when the file has it
+        if(NF >= 15) {
+            blocked_loops[game] += $15
+            span[game] = $1
+        } else if($4 >= $5 && $5 < 200) {
+            blocked[game]++
+        }
+        bank[game] += $2
+        larva[game] += $6
+        if($7 > workers[game]) { workers[game] = $7 }
+        per_base[game] += $9
+        apm[game] += $12
+    }
+    END {
+        printf "%-24s %-8s %-6s %8s %9s %8s %7s %8s %8s %6s %7s\n", "Map", "Race", "Result", \
+               "Length", "Blocked%", "AvgBank", "AvgLarv", "MaxDrone", "Drn/Base", "APM", "Fcst%"
+        for(g = 1; g <= game; g++) {
+            n = samples[g] > 0 ? samples[g] : 1
+            b = span[g] > 0 ? 100 * blocked_loops[g] / span[g] : 100 * blocked[g] / n
+            total_blocked_loops += blocked_loops[g]
+            f = mined[g] > 0 ? 100 * (forecast[g] - mined[g]) / mined[g] : 0
+            printf "%-24s %-8s %-6s %7.0fs %8.1f%% %8.0f %7.1f %8d %8.1f %6.0f %+6.1f%%\n", map[g], \
+                   race[g], result[g], length_s[g], b, bank[g] / n, larva[g] / n, workers[g], \
+                   per_base[g] / n, apm[g] / n, f
+            total_forecast += f < 0 ? -f : f
+            total_blocked += b; total_bank += bank[g] / n; total_larva += larva[g] / n
+            total_workers += workers[g]; total_apm += apm[g] / n; total_length += length_s[g]
+            if(result[g] == "Won") { wins++ }
+        }
+        printf "\nGames: %d  Wins: %d\n", game, wins
+        printf "Average length: %.0fs\n", total_length / game
+        printf "Average supply blocked: %.1f%%\n", total_blocked / game
+        printf "Supply blocked game loops: %d\n", total_blocked_loops
+        printf "Average banked minerals: %.0f\n", total_bank / game
+        printf "Average idle larva: %.1f\n", total_larva / game
+        printf "Average peak drones: %.1f\n", total_workers / game
+        printf "Average APM: %.0f\n", total_apm / game
+        printf "Average income forecast error: %.1f%%\n", total_forecast / game
+    }
+' "${files[@]}"
@@ -18,6 +18,8 @@ for /f "tokens=*" %%G in ('dir /b test-results-*.txt') do (
 )
 set /a file_number+=1
 set output_file=test-results-%file_number%.txt
+set ONPHONE_TELEMETRY_DIR=test-results-%file_number%-telemetry
+if not exist %ONPHONE_TELEMETRY_DIR% mkdir %ONPHONE_TELEMETRY_DIR%
 echo Bot Test Results > %output_file%
 echo ================== >> %output_file%
 echo %date% %time% >> %output_file%
@@ -13,6 +13,8 @@ cd build && make && cd ..
 # Output file for statistics
 timestamp=$(date +"%H%M")
 output_file="test-results-${timestamp}.txt"
+telemetry_dir="test-results-${timestamp}-telemetry"
+mkdir -p $telemetry_dir
 echo "Bot Test Results" > $output_file
 echo "==================" >> $output_file
 date >> $output_file
@@ -41,7 +43,7 @@ for race in "${races[@]}"; do
                 echo "Testing: OnPhone vs $race : $difficulty on $map (Run $i/5)" | tee -a $output_file
 
                 # Run the game and capture output
-                game_output=$(timeout 500s ./build/bin/OnPhone -c -a "$race" -d "$difficulty" -m "$map.SC2Map")
+                game_output=$(ONPHONE_TELEMETRY_DIR="$telemetry_dir" timeout 500s ./build/bin/OnPhone -c -a "$race" -d "$difficulty" -m "$map.SC2Map")
 
                 # Extract result from game output
                 result=$(echo "$game_output" | grep "Result:")
@@ -127,4 +129,8 @@ echo "CactusValleyLE: $win_rate_cactus%" >> $output_file
 echo "BelShirVestigeLE: $win_rate_belshir%" >> $output_file
 echo "ProximaStationLE: $win_rate_proxima%" >> $output_file
 
+echo -e "\nEconomy Telemetry:" >> $output_file
+echo "==================" >> $output_file
+scripts/telemetry-summary.sh $telemetry_dir >> $output_file
+
 echo "Testing complete! Results saved to $output_file"
\ No newline at end of file
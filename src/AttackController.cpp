@@ -5,23 +5,22 @@ AttackController::AttackController(OnPhone &bot) : UnitController(bot) {};
 /**
  * @brief Steps the given ally attack unit.
  *
- * This function steps the attack unit by executing the appropriate action
- * based on the unit's current task.
+ * The unit hands its task to its squad, every squad that got a task is then
+ * commanded once by command.
  *
  * @param unit The attack unit to step
  */
 void AttackController::step(AllyUnit &unit) {
-    switch(unit.unitTask) {
-    case TASK::ATTACK: attack(unit); break;
-    case TASK::RALLY: rally(unit); break;
-    default: break;
-    }
+    if(unit.unit == nullptr) { return; }
+    Squad *squad = squads.of(unit.unit->tag);
+    if(squad != nullptr) { squad->task = unit.unitTask; }
 };
 
 /**
  * @brief Handles the attack unit being under attack.
  *
- * This function handles the attack unit being under attack
+ * Zerglings hit on the way in push the rally point back. The unit's squad is
+ * still commanded as usual.
  *
  * @param unit The attack unit under attack
  */
@@ -29,6 +28,7 @@ void AttackController::underAttack(AllyUnit &unit) {
     if(unit.unit != nullptr && unit.unit->unit_type == UNIT_TYPEID::ZERG_ZERGLING) {
         approachDistance = fmax(approachDistance + 1, Distance2D(unit.unit->pos, bot.enemyLoc) + 1);
     }
+    step(unit);
 };
 
 /**
@@ -41,43 +41,169 @@ void AttackController::underAttack(AllyUnit &unit) {
 void AttackController::onDeath(AllyUnit &unit) {};
 
 /**
- * Rallies a unit to attack the enemy base or move to map center.
- * @param unit The unit to rally
+ * @brief Splits the living attackers into squads for this step.
+ *
+ * @param group The attack group
  */
-void AttackController::rally(AllyUnit &unit) {
-    if(unit.unit != nullptr) {
-        if(bot.enemyLoc.x != 0 && bot.enemyLoc.y != 0) {
-            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::ATTACK_ATTACK, bot.enemyLoc);
-            if(DistanceSquared2D(unit.unit->pos, bot.enemyLoc)
-               < approachDistance * approachDistance) {
-                bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, bot.mapCenter);
-                if(unit.unit->unit_type.ToType() == UNIT_TYPEID::ZERG_RAVAGER) {
-                    isAttacking = true;
-                }
-            }
+void AttackController::groupSquads(const UnitGroup &group) {
+    army.clear();
+    for(const auto &unit : group.units) {
+        if(unit.unit != nullptr && unit.unit->is_alive && unit.unit->health > 0) {
+            army.push_back(unit.unit);
+        }
+    }
+    squads.update(army, bot.Observation()->GetUnitTypeData(), bot.arena);
+}
+
+/**
+ * @brief Decides the orders of every squad that was stepped, in parallel.
+ *
+ * Everything the decisions read is fixed first on the game thread: the
+ * squads, the targets, the strongest squad and the flow fields toward the
+ * enemy base and the map center. Each squad writes its commands into the lane
+ * of the worker deciding it, and the lanes are sent in squad order, so the
+ * actions are the same for any number of workers. Shared effects, such as
+ * starting the attack, are applied after all squads decided.
+ *
+ * @param pool The pool to decide on
+ */
+void AttackController::command(ThreadPool &pool) {
+    main = squads.strongest();
+    toCenter = &bot.flowFields.field(bot.mapCenter, bot.pathingGrid);
+    toEnemy = bot.enemyLoc.x != 0 && bot.enemyLoc.y != 0
+                ? &bot.flowFields.field(bot.enemyLoc, bot.pathingGrid)
+                : nullptr;
+    commands.reset(pool.size());
+    arrived.assign(squads.squads.size(), 0);
+    ravagers.resize(pool.size());
+    pool.parallelFor(squads.squads.size(), 1, [this](std::size_t index, unsigned worker) {
+        switch(squads.squads[index].task) {
+        case TASK::ATTACK: attack(index, worker); break;
+        case TASK::RALLY: rally(index, worker); break;
+        default: break;
+        }
+    });
+    commands.flush(bot.Actions());
+    const bool ravagerArrived = std::find(arrived.begin(), arrived.end(), 1) != arrived.end();
+    if(ravagerArrived && !isAttacking) {
+        isAttacking = true;
+        bot.events.broadcast(EventDispatcher::ATTACK_STARTED);
+    }
+}
+
+/**
+ * @brief Returns the number of squad commands sent since the last call and resets it.
+ *
+ * @return The number of commands sent
+ */
+std::size_t AttackController::takeSent() {
+    const std::size_t sent = commands.sent;
+    commands.sent = 0;
+    return sent;
+}
+
+/**
+ * @brief Checks if a squad should join the strongest squad before going on.
+ *
+ * Squads weaker than SQUAD_MERGE_SHARE of the strongest squad, such as
+ * reinforcements coming from the hatcheries, would otherwise reach the enemy
+ * one by one.
+ *
+ * @param squad The squad to check
+ * @param target The centroid of the strongest squad
+ * @return true if the squad should move to the strongest squad, false otherwise
+ */
+bool AttackController::regroup(const Squad &squad, Point2D &target) const {
+    if(main == nullptr || main == &squad || squad.strength >= SQUAD_MERGE_SHARE * main->strength
+       || DistanceSquared2D(squad.centroid, main->centroid)
+            <= SQUAD_MERGE_DISTANCE * SQUAD_MERGE_DISTANCE) {
+        return false;
+    }
+    target = main->centroid;
+    return true;
+}
+
+/**
+ * @brief Gets the next point on the way to a destination from its flow field.
+ *
+ * Every squad heading to the same destination reads the same field, so moving
+ * the army costs one field computation instead of a path query per unit.
+ * Until the field is built the squad heads straight for the destination.
+ *
+ * @param field The field toward the destination
+ * @param from The position to move from, e.g. a squad centroid
+ * @return Point2D The waypoint to command the squad to
+ */
+Point2D AttackController::waypoint(const FlowField *field, const Point2D &from) const {
+    return field->ready() ? field->waypoint(from) : field->destination;
+}
+
+/**
+ * Rallies a squad to the enemy base or the map center, following the flow fields.
+ * Squads that are too weak alone regroup with the strongest squad first. The squad stops at
+ * approachDistance from the enemy base and the first ravager to get there starts the attack.
+ * Runs on the pool, so it only reads shared state and records its commands.
+ * @param index The index of the squad
+ * @param worker The worker deciding the squad
+ */
+void AttackController::rally(std::size_t index, unsigned worker) {
+    const Squad &squad = squads.squads[index];
+    const uint32_t key = static_cast<uint32_t>(index);
+    Point2D target;
+    if(regroup(squad, target)) {
+        // The strongest squad moves, so its centroid is not worth a flow field
+        commands.command(worker, key, squad.members, ABILITY_ID::SMART, target);
+    } else if(toEnemy != nullptr) {
+        if(DistanceSquared2D(squad.centroid, bot.enemyLoc) < approachDistance * approachDistance) {
+            commands.command(worker, key, squad.members, ABILITY_ID::SMART,
+                             waypoint(toCenter, squad.centroid));
+            arrived[index] = std::any_of(
+              squad.members.begin(), squad.members.end(), [](const Unit *member) {
+                  return member->unit_type.ToType() == UNIT_TYPEID::ZERG_RAVAGER;
+              });
         } else {
-            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, bot.mapCenter);
+            commands.command(worker, key, squad.members, ABILITY_ID::ATTACK_ATTACK,
+                             waypoint(toEnemy, squad.centroid));
         }
+    } else {
+        commands.command(worker, key, squad.members, ABILITY_ID::SMART,
+                         waypoint(toCenter, squad.centroid));
     }
 };
 
 /**
- * Commands a unit to attack the most dangerous enemy ground unit or enemy base.
- * @param unit The unit to command
+ * Commands a squad to attack the most dangerous enemy ground unit or enemy base.
+ * Nearby targets are attacked directly, the enemy base is reached through its flow field, and
+ * squads that are too weak alone attack-move to the strongest squad first.
+ * Runs on the pool, so it only reads shared state and records its commands.
+ * @param index The index of the squad
+ * @param worker The worker deciding the squad
  */
-void AttackController::attack(AllyUnit &unit) {
-    if(unit.unit != nullptr) {
-        if(most_dangerous_ground != nullptr) {
-            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::ATTACK_ATTACK,
-                                       most_dangerous_ground->pos);
-            if(unit.unit->unit_type.ToType() == UNIT_TYPEID::ZERG_RAVAGER
-               && most_dangerous_all != nullptr) {
-                bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::EFFECT_CORROSIVEBILE,
-                                           most_dangerous_all->pos);
+void AttackController::attack(std::size_t index, unsigned worker) {
+    const Squad &squad = squads.squads[index];
+    const uint32_t key = static_cast<uint32_t>(index);
+    Point2D target;
+    if(regroup(squad, target)) {
+        commands.command(worker, key, squad.members, ABILITY_ID::ATTACK_ATTACK, target);
+    } else if(most_dangerous_ground != nullptr) {
+        commands.command(worker, key, squad.members, ABILITY_ID::ATTACK_ATTACK,
+                         most_dangerous_ground->pos);
+        if(most_dangerous_all != nullptr) {
+            Units &biles = ravagers[worker];
+            biles.clear();
+            for(const auto *member : squad.members) {
+                if(member->unit_type.ToType() == UNIT_TYPEID::ZERG_RAVAGER) {
+                    biles.push_back(member);
+                }
+            }
+            if(!biles.empty()) {
+                commands.command(worker, key, biles, ABILITY_ID::EFFECT_CORROSIVEBILE,
+                                 most_dangerous_all->pos);
             }
-        } else {
-            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::ATTACK_ATTACK, bot.enemyLoc);
         }
+    } else if(toEnemy != nullptr) {
+        commands.command(worker, key, squad.members, ABILITY_ID::ATTACK_ATTACK,
+                         waypoint(toEnemy, squad.centroid));
     }
 }
 
@@ -90,43 +216,16 @@ void AttackController::attack(AllyUnit &unit) {
  * health+shield, while ground units target the ground enemy with the lowest health+shield. The
  * attack is only initiated if there are no pending build orders.
  *
+ * @param pool The pool the enemies are scanned on
  * @return true if at least one enemy unit was targeted for attack, false otherwise
  */
-void AttackController::getMostDangerous() {
-    most_dangerous_all = nullptr;
-    most_dangerous_ground = nullptr;
-    // currently attacks weakest enemy unit
-    Units enemy_units = bot.Observation()->GetUnits(Unit::Alliance::Enemy, [](const Unit &unit) {
-        return unit.unit_type.ToType() != UNIT_TYPEID::INVALID &&  // Valid unit
-               (unit.display_type == Unit::DisplayType::Visible || // Visible or
-                unit.display_type == Unit::DisplayType::Snapshot);
-    });
-    const UnitTypes unit_data = bot.Observation()->GetUnitTypeData();
-    float max_danger_all = std::numeric_limits<float>::lowest();
-    float max_danger_ground = std::numeric_limits<float>::lowest();
-    for(const auto &unit : enemy_units) {
-        UnitTypeData current_unit_data
-          = unit_data.at(static_cast<uint32_t>(unit->unit_type.ToType()));
-        float unit_health = unit->health + unit->shield;
-        float unit_DPS;
-        if(current_unit_data.weapons.data() != nullptr) {
-            unit_DPS = current_unit_data.weapons.data()->damage_
-                       * current_unit_data.weapons.data()->attacks
-                       * current_unit_data.weapons.data()->speed;
-        } else {
-            unit_DPS = 0;
-        }
-        float unit_danger = unit_DPS / (unit_health); // prevent division by 0
-        if(DistanceSquared2D(unit->pos, bot.enemyLoc)
-           < DistanceSquared2D(unit->pos, bot.Observation()->GetStartLocation())) {
-            if(unit_danger > max_danger_all) {
-                max_danger_all = unit_danger;
-                most_dangerous_all = unit;
-            }
-            if(!unit->is_flying && unit_danger > max_danger_ground) {
-                max_danger_ground = unit_danger;
-                most_dangerous_ground = unit;
-            }
-        }
-    }
+void AttackController::getMostDangerous(ThreadPool &pool) {
+    // Enemies closer to their base than to ours
+    FindMostDangerous(bot.enemyUnits,
+                      bot.Observation()->GetUnitTypeData(),
+                      [this](const Unit &unit) {
+                          return DistanceSquared2D(unit.pos, bot.enemyLoc)
+                                 < DistanceSquared2D(unit.pos, bot.startLoc);
+                      },
+                      most_dangerous_all, most_dangerous_ground, pool, bot.arena);
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "CommandBuffer.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+/**
+ * @brief Empties the buffer and gives it one lane per worker.
+ *
+ * @param workers The number of pool workers that record commands
+ */
+void CommandBuffer::reset(unsigned workers) {
+    lanes.resize(workers);
+    for(auto &lane : lanes) {
+        lane.commands.clear();
+        lane.units.clear();
+    }
+}
+
+/**
+ * @brief Records a command for a group of units.
+ *
+ * Only the worker owning a lane writes to it, so no locking is needed.
+ * Commands with the same key must come from the same task, they are then sent
+ * in the order they were recorded.
+ *
+ * @param worker The index of the recording worker
+ * @param key The position of the command among all commands, e.g. a squad index
+ * @param units The units to command
+ * @param ability The ability to use
+ * @param target The point to use it on
+ */
+void CommandBuffer::command(unsigned worker, uint32_t key, const Units &units, AbilityID ability,
+                            const Point2D &target) {
+    Lane &lane = lanes[worker];
+    lane.commands.push_back({key, ability, target, lane.units.size(), units.size()});
+    lane.units.insert(lane.units.end(), units.begin(), units.end());
+}
+
+/**
+ * @brief Sends the recorded commands ordered by key, adds them to sent and empties the buffer.
+ *
+ * @param actions The action interface of the game thread
+ */
+void CommandBuffer::flush(ActionInterface *actions) {
+    merged.clear();
+    for(unsigned lane = 0; lane < lanes.size(); ++lane) {
+        for(std::size_t i = 0; i < lanes[lane].commands.size(); ++i) {
+            merged.push_back({lanes[lane].commands[i].key, lane, i});
+        }
+    }
+    std::sort(merged.begin(), merged.end(), [](const Entry &a, const Entry &b) {
+        if(a.key != b.key) { return a.key < b.key; }
+        return a.lane != b.lane ? a.lane < b.lane : a.command < b.command;
+    });
+    for(const auto &entry : merged) {
+        const Lane &lane = lanes[entry.lane];
+        const Command &command = lane.commands[entry.command];
+        batch.assign(lane.units.begin() + command.first,
+                     lane.units.begin() + command.first + command.count);
+        actions->UnitCommand(batch, command.ability, command.target);
+    }
+    sent += merged.size();
+    reset(static_cast<unsigned>(lanes.size()));
+}
@@ -0,0 +1,147 @@
+#include "DistanceMatrix.h"
+#include "constants.h"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+using namespace sc2;
+
+static const uint8_t UNLABELLED = 255;
+
+/**
+ * @brief Computes straight-line distances, as flown by overlords.
+ *
+ * @param points The points to connect
+ * @return DistanceMatrix The distances between every pair of points
+ */
+DistanceMatrix DistanceMatrix::air(const std::vector<Point2D> &points) {
+    DistanceMatrix matrix;
+    matrix.points = points;
+    matrix.positions = PointSet(points);
+    matrix.count = points.size();
+    matrix.distances.assign(matrix.count * matrix.count, 0.0f);
+    for(std::size_t i = 0; i < matrix.count; ++i) {
+        for(std::size_t j = i + 1; j < matrix.count; ++j) {
+            const float distance = Distance2D(points[i], points[j]);
+            matrix.distances[i * matrix.count + j] = distance;
+            matrix.distances[j * matrix.count + i] = distance;
+        }
+    }
+    return matrix;
+}
+
+/**
+ * @brief Computes ground distances locally on the pathing grid.
+ *
+ * Runs one Dijkstra search per point, so no server round trip is needed.
+ * Points inside unpathable cells, such as a town hall, start from the closest
+ * pathable cell. Every map cell is also labelled with its closest point by
+ * ground distance, which makes nearest a constant time lookup.
+ *
+ * @param points The points to connect
+ * @param pathing The pathing grid of the map
+ * @return DistanceMatrix The distances between every pair of points
+ */
+DistanceMatrix DistanceMatrix::ground(const std::vector<Point2D> &points, const BitGrid &pathing) {
+    DistanceMatrix matrix;
+    matrix.points = points;
+    matrix.positions = PointSet(points);
+    matrix.count = points.size();
+    matrix.distances.assign(matrix.count * matrix.count, ROUTE_UNREACHABLE);
+    if(points.size() >= UNLABELLED) { return matrix; }
+    matrix.width = pathing.width;
+    matrix.height = pathing.height;
+    const std::size_t cells = static_cast<std::size_t>(pathing.width) * pathing.height;
+    matrix.labels.assign(cells, UNLABELLED);
+    std::vector<float> closest(cells, std::numeric_limits<float>::infinity());
+    std::vector<std::pair<int, int>> sources(matrix.count, std::make_pair(-1, -1));
+    for(std::size_t i = 0; i < matrix.count; ++i) {
+        int x = static_cast<int>(points[i].x);
+        int y = static_cast<int>(points[i].y);
+        if(pathing.nearest(x, y, DISTANCE_SNAP_RADIUS)) { sources[i] = std::make_pair(x, y); }
+    }
+
+    for(std::size_t i = 0; i < matrix.count; ++i) {
+        matrix.distances[i * matrix.count + i] = 0.0f;
+        if(sources[i].first < 0) { continue; }
+        const std::vector<float> field = pathing.distanceField(sources[i].first, sources[i].second);
+        for(std::size_t j = 0; j < matrix.count; ++j) {
+            if(j == i || sources[j].first < 0) { continue; }
+            const std::size_t cell
+              = static_cast<std::size_t>(sources[j].second) * pathing.width + sources[j].first;
+            const float distance = field[cell];
+            if(std::isfinite(distance)) { matrix.distances[i * matrix.count + j] = distance; }
+        }
+        for(std::size_t cell = 0; cell < cells; ++cell) {
+            if(field[cell] < closest[cell]) {
+                closest[cell] = field[cell];
+                matrix.labels[cell] = static_cast<uint8_t>(i);
+            }
+        }
+    }
+    // Dijkstra on the grid is symmetric up to rounding, keep the matrix exactly symmetric
+    for(std::size_t i = 0; i < matrix.count; ++i) {
+        for(std::size_t j = i + 1; j < matrix.count; ++j) {
+            const float distance = std::fmin(matrix.distances[i * matrix.count + j],
+                                             matrix.distances[j * matrix.count + i]);
+            matrix.distances[i * matrix.count + j] = distance;
+            matrix.distances[j * matrix.count + i] = distance;
+        }
+    }
+    return matrix;
+}
+
+/**
+ * @brief Gets the index of the point closest to a position.
+ *
+ * Uses the ground distance labels when they were computed and the position
+ * is reachable, otherwise the straight-line distance, e.g. for mineral fields.
+ *
+ * @param pos The position to look up
+ * @return std::size_t The index of the closest point
+ */
+std::size_t DistanceMatrix::nearest(const Point2D &pos) const {
+    const int x = static_cast<int>(pos.x);
+    const int y = static_cast<int>(pos.y);
+    if(!labels.empty() && x >= 0 && y >= 0 && x < width && y < height) {
+        const uint8_t label = labels[static_cast<std::size_t>(y) * width + x];
+        if(label != UNLABELLED) { return label; }
+    }
+    const std::size_t best = Nearest(positions, pos);
+    return best == GEOMETRY_NONE ? 0 : best;
+}
+
+/**
+ * @brief Gets the distance between the points closest to two positions.
+ *
+ * @param from The position to start from
+ * @param to The position to travel to
+ * @return float The distance between the closest points of both positions
+ */
+float DistanceMatrix::between(const Point2D &from, const Point2D &to) const {
+    if(count == 0) { return Distance2D(from, to); }
+    return (*this)(nearest(from), nearest(to));
+}
+
+/**
+ * @brief Checks if one position is closer to a destination than another.
+ *
+ * Compares the distances between the closest points first, so positions in
+ * different bases are ordered by travel distance, and falls back to the
+ * straight-line distance for positions around the same point.
+ *
+ * @param a The first position
+ * @param b The second position
+ * @param to The destination
+ * @return true if a is closer to the destination than b, false otherwise
+ */
+bool DistanceMatrix::closer(const Point2D &a, const Point2D &b, const Point2D &to) const {
+    if(count != 0) {
+        const std::size_t destination = nearest(to);
+        const float da = (*this)(nearest(a), destination);
+        const float db = (*this)(nearest(b), destination);
+        if(da != db) { return da < db; }
+    }
+    return DistanceSquared2D(a, to) < DistanceSquared2D(b, to);
+}
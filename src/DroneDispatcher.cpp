@@ -0,0 +1,228 @@
+#include "DroneDispatcher.h"
+#include "OnPhone.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+DroneDispatcher::DroneDispatcher(OnPhone &bot) : bot(bot) {};
+
+/**
+ * @brief Builds a structure, sending the builder drone ahead of the cost.
+ *
+ * Called every step while the structure is wanted. The mining drone closest
+ * to the site by ground distance leaves once the forecast income covers the
+ * cost by the time it arrives, and the build command is issued as soon as
+ * the minerals are in the bank.
+ *
+ * @param ability The build ability
+ * @param location The build site
+ * @param minerals The mineral cost of the structure
+ * @param target The unit to build on, e.g. a vespene geyser, or nullptr to build at the site
+ * @return true if the build command was issued, false otherwise
+ */
+bool DroneDispatcher::build(ABILITY_ID ability, const Point2D &location, int minerals,
+                            const Unit *target) {
+    auto it = std::find_if(
+      dispatches.begin(), dispatches.end(),
+      [ability](const Dispatch &dispatch) { return dispatch.ability == ability; });
+    AllyUnit *drone = it == dispatches.end() ? nullptr : worker(it->drone);
+    if(it != dispatches.end() && drone == nullptr) {
+        dispatches.erase(it);
+        it = dispatches.end();
+    }
+
+    if(drone == nullptr) {
+        drone = closestMiner(location);
+        if(drone == nullptr) { return false; }
+        const uint32_t travel = travelTime(drone->unit->pos, location);
+        const uint32_t wait = bot.income.timeUntilAffordable(minerals);
+        if(wait > travel) { return false; }
+        drone->unitTask = TASK::BUILD;
+        dispatches.push_back({ability, drone->unit->tag, location, 0});
+        it = dispatches.end() - 1;
+        if(wait > 0) {
+            bot.Actions()->UnitCommand(drone->unit, ABILITY_ID::MOVE_MOVE, location);
+            LOG_INFO("Command Sent: Drone leaves %u loops before the cost is banked",
+                     travel - wait);
+        }
+    } else if(it->location.x != location.x || it->location.y != location.y) {
+        bot.Actions()->UnitCommand(drone->unit, ABILITY_ID::MOVE_MOVE, location);
+    }
+    it->location = location;
+    it->requested = bot.Observation()->GetGameLoop();
+
+    if(bot.Observation()->GetMinerals() < minerals) { return false; }
+    if(target != nullptr) {
+        bot.Actions()->UnitCommand(drone->unit, ability, target);
+    } else {
+        bot.Actions()->UnitCommand(drone->unit, ability, location);
+    }
+    drone->unitTask = TASK::UNSET;
+    bot.tasks.spawn(confirm(drone->unit->tag, ability, location,
+                            target == nullptr ? NullTag : target->tag, minerals));
+    dispatches.erase(it);
+    return true;
+}
+
+/**
+ * @brief Watches a build command until the drone starts the structure.
+ *
+ * The drone is gone once the structure is started. A command that was
+ * dropped, e.g. because the site was blocked when the drone arrived, is sent
+ * again once the cost is banked, up to DISPATCH_RETRIES times, before the
+ * drone goes back to mining.
+ *
+ * @param drone The tag of the builder drone
+ * @param ability The build ability
+ * @param location The build site
+ * @param target The tag of the unit to build on, NullTag to build at the site
+ * @param minerals The mineral cost of the structure
+ * @return StepTask The task, to be spawned on the task scheduler
+ */
+StepTask DroneDispatcher::confirm(Tag drone, ABILITY_ID ability, Point2D location, Tag target,
+                                  int minerals) {
+    const ObservationInterface *observation = bot.Observation();
+    auto started = [observation, drone] {
+        const Unit *unit = observation->GetUnit(drone);
+        return unit == nullptr || !unit->is_alive || unit->unit_type != UNIT_TYPEID::ZERG_DRONE;
+    };
+    auto dropped = [observation, drone, ability] {
+        const Unit *unit = observation->GetUnit(drone);
+        if(unit == nullptr) { return false; }
+        for(const auto &order : unit->orders) {
+            if(order.ability_id == ability) { return false; }
+        }
+        return true;
+    };
+    for(int retry = 0;; ++retry) {
+        co_await bot.tasks.until([&] { return started() || dropped(); }, DISPATCH_CONFIRM_LOOPS);
+        if(started()) { co_return; }
+        if(retry == DISPATCH_RETRIES || !dropped()) { break; }
+        LOG_WARN("Build command dropped, sending it again");
+        if(AllyUnit *builder = worker(drone)) { builder->unitTask = TASK::BUILD; }
+        const bool banked = co_await bot.tasks.until(
+          [observation, minerals] { return observation->GetMinerals() >= minerals; },
+          DISPATCH_HORIZON);
+        AllyUnit *builder = worker(drone);
+        if(!banked || builder == nullptr) { break; }
+        const Unit *on = target == NullTag ? nullptr : observation->GetUnit(target);
+        if(on != nullptr) {
+            bot.Actions()->UnitCommand(builder->unit, ability, on);
+        } else {
+            bot.Actions()->UnitCommand(builder->unit, ability, location);
+        }
+        builder->unitTask = TASK::UNSET;
+        // The order only shows on the next observation
+        co_await bot.tasks.sleep(1);
+    }
+    LOG_WARN("Build did not start, the drone goes back to mining");
+    AllyUnit *builder = worker(drone);
+    if(builder != nullptr && builder->unitTask != TASK::MINE) {
+        builder->unitTask = TASK::MINE;
+        bot.events.wake(drone, EventDispatcher::TASK_CHANGED);
+    }
+}
+
+/**
+ * @brief Gets the site a drone was already sent to for a build.
+ *
+ * @param ability The build ability
+ * @param location The build site
+ * @return true if a drone is on its way for the build, false otherwise
+ */
+bool DroneDispatcher::location(ABILITY_ID ability, Point2D &location) const {
+    for(const auto &dispatch : dispatches) {
+        if(dispatch.ability == ability) {
+            location = dispatch.location;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Sends the drone of a build that is no longer wanted back to mining.
+ *
+ * @param ability The build ability
+ */
+void DroneDispatcher::release(ABILITY_ID ability) {
+    for(std::size_t i = 0; i < dispatches.size(); ++i) {
+        if(dispatches[i].ability == ability) {
+            release(i);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Releases the drones of builds that were not requested for DISPATCH_TIMEOUT loops.
+ *
+ * A build stops being requested when the build order changes, e.g. when a
+ * destroyed building is queued in front of it.
+ */
+void DroneDispatcher::update() {
+    const uint32_t gameLoop = bot.Observation()->GetGameLoop();
+    for(std::size_t i = dispatches.size(); i-- > 0;) {
+        if(gameLoop - dispatches[i].requested > DISPATCH_TIMEOUT) { release(i); }
+    }
+}
+
+/**
+ * @brief Finds the mining drone closest to a build site.
+ *
+ * @param location The build site
+ * @return AllyUnit* The closest drone by ground distance, nullptr if no drone is mining
+ */
+AllyUnit *DroneDispatcher::closestMiner(const Point2D &location) const {
+    AllyUnit *closest = nullptr;
+    for(auto &worker : bot.Workers->units) {
+        if(worker.unitTask != TASK::MINE || worker.unit == nullptr) { continue; }
+        if(closest == nullptr
+           || bot.baseDistances.closer(worker.unit->pos, closest->unit->pos, location)) {
+            closest = &worker;
+        }
+    }
+    return closest;
+}
+
+/**
+ * @brief Finds the worker of a dispatched drone.
+ *
+ * @param drone The tag of the drone
+ * @return AllyUnit* The worker, nullptr if the drone died or is no longer a worker
+ */
+AllyUnit *DroneDispatcher::worker(Tag drone) const {
+    for(auto &worker : bot.Workers->units) {
+        if(worker.unit != nullptr && worker.unit->tag == drone && worker.unit->is_alive) {
+            return &worker;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Estimates the time a drone needs to walk between two positions.
+ *
+ * @param from The position of the drone
+ * @param to The build site
+ * @return uint32_t The walking time in game loops
+ */
+uint32_t DroneDispatcher::travelTime(const Point2D &from, const Point2D &to) const {
+    const float distance = std::max(bot.baseDistances.between(from, to), Distance2D(from, to));
+    return static_cast<uint32_t>(distance / DRONE_SPEED_PER_LOOP);
+}
+
+/**
+ * @brief Sends the drone of a dispatch back to mining and drops the dispatch.
+ *
+ * @param index The index of the dispatch
+ */
+void DroneDispatcher::release(std::size_t index) {
+    AllyUnit *drone = worker(dispatches[index].drone);
+    if(drone != nullptr && drone->unitTask == TASK::BUILD) {
+        drone->unitTask = TASK::MINE;
+        bot.events.wake(drone->unit->tag, EventDispatcher::TASK_CHANGED);
+    }
+    dispatches.erase(dispatches.begin() + index);
+}
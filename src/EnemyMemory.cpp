@@ -0,0 +1,357 @@
+#include "EnemyMemory.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace sc2;
+
+/**
+ * @brief Gets the number of living enemy units of a type.
+ *
+ * @param type The unit type
+ * @return int The number of units, without a scan of the units
+ */
+int EnemyComposition::count(UNIT_TYPEID type) const {
+    const uint32_t id = static_cast<uint32_t>(type);
+    return id < counts.size() ? counts[id] : 0;
+}
+
+/**
+ * @brief Sets up the region grid, the possible enemy start locations and the unit traits.
+ *
+ * @param gameInfo The game info of the current map
+ * @param unitData The unit type data of the game, read once for the composition totals
+ */
+void EnemyMemory::initialize(const GameInfo &gameInfo, const UnitTypes &unitData) {
+    origin = gameInfo.playable_min;
+    regionsX = static_cast<std::size_t>(
+                 std::ceil((gameInfo.playable_max.x - origin.x) / ENEMY_REGION_SIZE))
+               + 1;
+    regionsY = static_cast<std::size_t>(
+                 std::ceil((gameInfo.playable_max.y - origin.y) / ENEMY_REGION_SIZE))
+               + 1;
+    byRegion.assign(regionsX * regionsY, {});
+    enemyStarts = gameInfo.enemy_start_locations;
+    traits.assign(unitData.size(), {0.0f, 0, 0, false, false});
+    for(std::size_t i = 0; i < unitData.size(); ++i) {
+        Traits &entry = traits[i];
+        entry.supply = unitData[i].food_required;
+        entry.minerals = unitData[i].mineral_cost;
+        entry.vespene = unitData[i].vespene_cost;
+        for(const auto &weapon : unitData[i].weapons) {
+            entry.antiAir |= weapon.type != Weapon::TargetType::Ground;
+            entry.antiGround |= weapon.type != Weapon::TargetType::Air;
+        }
+    }
+    composition.counts.assign(unitData.size(), 0);
+}
+
+/**
+ * @brief Refreshes the memory from all currently visible enemy units.
+ *
+ * Snapshots of structures in the fog of war are skipped, their last known
+ * state is already remembered.
+ *
+ * @param enemies The enemy units of this step
+ * @param gameLoop The current game loop
+ */
+void EnemyMemory::update(const Units &enemies, uint32_t gameLoop) {
+    for(const auto *unit : enemies) {
+        if(unit->display_type == Unit::DisplayType::Visible) { see(*unit, gameLoop); }
+    }
+}
+
+/**
+ * @brief Records a sighting of an enemy unit.
+ *
+ * New units are added to the type and region indices and the composition,
+ * known units have their position, type and last seen game loop updated. A
+ * tag is only counted once, morphs and units lifting off or landing move it
+ * between the composition totals. A drone that morphs into a structure joins
+ * the structure and town hall indices.
+ *
+ * @param unit The enemy unit that was seen
+ * @param gameLoop The game loop of the sighting
+ */
+void EnemyMemory::see(const Unit &unit, uint32_t gameLoop) {
+    if(unit.alliance != Unit::Alliance::Enemy
+       || unit.unit_type.ToType() == UNIT_TYPEID::INVALID) {
+        return;
+    }
+    const UNIT_TYPEID type = unit.unit_type.ToType();
+    const std::size_t region = regionOf(unit.pos);
+    auto it = indexOf.find(unit.tag);
+    if(it == indexOf.end()) {
+        const std::size_t index = records.size();
+        const bool structure = IsBuilding(unit) || IsTownHall(type);
+        records.push_back(
+          {unit.tag, type, unit.pos, gameLoop, gameLoop, region, structure, true, unit.is_flying});
+        indexOf[unit.tag] = index;
+        tally(records.back(), 1);
+        byType[static_cast<uint32_t>(type)].push_back(index);
+        byRegion[region].push_back(index);
+        if(structure) {
+            structures.push_back(index);
+            if(IsTownHall(type)) { townHalls.push_back(index); }
+            refreshBases();
+        }
+        return;
+    }
+
+    EnemyRecord &record = records[it->second];
+    record.lastSeen = gameLoop;
+    record.pos = unit.pos;
+    if(record.region != region) {
+        unlink(byRegion[record.region], it->second);
+        byRegion[region].push_back(it->second);
+        record.region = region;
+    }
+    const bool changed = record.type != type || record.flying != unit.is_flying;
+    if(changed) { tally(record, -1); }
+    record.flying = unit.is_flying;
+    if(record.type != type) {
+        // Morphs such as hatchery to lair, zergling to baneling or drone to hatchery keep their tag
+        unlink(byType[static_cast<uint32_t>(record.type)], it->second);
+        byType[static_cast<uint32_t>(type)].push_back(it->second);
+        const bool wasTownHall = IsTownHall(record.type);
+        const bool wasStructure = record.structure;
+        record.type = type;
+        record.structure = IsBuilding(unit) || IsTownHall(type);
+        if(wasStructure != record.structure) {
+            if(wasStructure) {
+                unlink(structures, it->second);
+            } else {
+                structures.push_back(it->second);
+            }
+        }
+        if(wasTownHall != IsTownHall(type)) {
+            if(wasTownHall) {
+                unlink(townHalls, it->second);
+            } else {
+                townHalls.push_back(it->second);
+            }
+        }
+        if(wasStructure != record.structure || wasTownHall != IsTownHall(type)) {
+            refreshBases();
+        }
+    }
+    if(changed) { tally(record, 1); }
+}
+
+/**
+ * @brief Forgets an enemy unit that was destroyed.
+ *
+ * The record is kept for history, but removed from every index and the composition.
+ *
+ * @param tag The tag of the destroyed unit
+ */
+void EnemyMemory::forget(Tag tag) {
+    auto it = indexOf.find(tag);
+    if(it == indexOf.end()) { return; }
+    const std::size_t index = it->second;
+    EnemyRecord &record = records[index];
+    tally(record, -1);
+    record.alive = false;
+    indexOf.erase(it);
+    unlink(byType[static_cast<uint32_t>(record.type)], index);
+    unlink(byRegion[record.region], index);
+    // Unlinked whatever the type says, so a stale entry never outlives the unit
+    unlink(structures, index);
+    unlink(townHalls, index);
+    if(record.structure || IsTownHall(record.type)) { refreshBases(); }
+}
+
+/**
+ * @brief Estimates how likely a remembered unit still is where it was last seen.
+ *
+ * The confidence halves every ENEMY_UNIT_HALF_LIFE game loops for units and every
+ * ENEMY_STRUCTURE_HALF_LIFE game loops for structures.
+ *
+ * @param record The remembered unit
+ * @param gameLoop The current game loop
+ * @return float A confidence between 0 and 1
+ */
+float EnemyMemory::confidence(const EnemyRecord &record, uint32_t gameLoop) const {
+    if(!record.alive) { return 0.0f; }
+    const float age = static_cast<float>(gameLoop - record.lastSeen);
+    const float halfLife = record.structure ? ENEMY_STRUCTURE_HALF_LIFE : ENEMY_UNIT_HALF_LIFE;
+    return std::exp2(-age / halfLife);
+}
+
+/**
+ * @brief Gets the remembered state of an enemy unit.
+ *
+ * @param tag The tag of the enemy unit
+ * @return const EnemyRecord* The record, or nullptr if the unit is unknown or dead
+ */
+const EnemyRecord *EnemyMemory::get(Tag tag) const {
+    auto it = indexOf.find(tag);
+    return it == indexOf.end() ? nullptr : &records[it->second];
+}
+
+/**
+ * @brief Gets all living enemy units of a type.
+ *
+ * @param type The unit type
+ * @return const std::vector<std::size_t>& Indices into records
+ */
+const std::vector<std::size_t> &EnemyMemory::ofType(UNIT_TYPEID type) const {
+    static const std::vector<std::size_t> none;
+    auto it = byType.find(static_cast<uint32_t>(type));
+    return it == byType.end() ? none : it->second;
+}
+
+/**
+ * @brief Gets all living enemy units last seen in the region of a point.
+ *
+ * @param point The point to look around
+ * @return const std::vector<std::size_t>& Indices into records
+ */
+const std::vector<std::size_t> &EnemyMemory::near(const Point2D &point) const {
+    static const std::vector<std::size_t> none;
+    if(byRegion.empty()) { return none; }
+    return byRegion[regionOf(point)];
+}
+
+/**
+ * @brief Gets the town hall of the enemy main base.
+ *
+ * @return const EnemyRecord* The town hall, or nullptr if none was seen
+ */
+const EnemyRecord *EnemyMemory::main() const {
+    return mainIndex == SIZE_MAX ? nullptr : &records[mainIndex];
+}
+
+/**
+ * @brief Gets the town hall of the enemy natural expansion.
+ *
+ * @return const EnemyRecord* The town hall, or nullptr if none was seen
+ */
+const EnemyRecord *EnemyMemory::natural() const {
+    return naturalIndex == SIZE_MAX ? nullptr : &records[naturalIndex];
+}
+
+/**
+ * @brief Gets a stable structure to treat as the enemy location.
+ *
+ * This is the enemy main if it is known, otherwise the earliest seen structure
+ * that is still alive, so it only changes when structures are found or destroyed.
+ *
+ * @return const EnemyRecord* The structure, or nullptr if none was seen
+ */
+const EnemyRecord *EnemyMemory::anchor() const {
+    return anchorIndex == SIZE_MAX ? nullptr : &records[anchorIndex];
+}
+
+/**
+ * @brief Checks if a remembered unit counts towards the enemy army.
+ *
+ * @param record The remembered unit
+ * @return true if it has supply and is neither a worker nor a structure, false otherwise
+ */
+bool EnemyMemory::isArmy(const EnemyRecord &record) const {
+    const uint32_t id = static_cast<uint32_t>(record.type);
+    return !record.structure && !IsWorker(record.type) && id < traits.size()
+           && traits[id].supply > 0.0f;
+}
+
+/**
+ * @brief Adds a living unit to the composition totals or removes it.
+ *
+ * @param record The unit
+ * @param sign 1 to add the unit, -1 to remove it
+ */
+void EnemyMemory::tally(const EnemyRecord &record, int sign) {
+    const uint32_t id = static_cast<uint32_t>(record.type);
+    if(id >= composition.counts.size()) { composition.counts.resize(id + 1, 0); }
+    composition.counts[id] += sign;
+    const Traits none = {0.0f, 0, 0, false, false};
+    const Traits &unit = id < traits.size() ? traits[id] : none;
+    if(record.structure) {
+        composition.structures += sign;
+    } else if(IsWorker(record.type)) {
+        composition.workers += sign;
+    } else if(isArmy(record)) {
+        composition.armySupply += sign * unit.supply;
+        composition.armyMinerals += sign * unit.minerals;
+        composition.armyVespene += sign * unit.vespene;
+        if(record.flying) { composition.airSupply += sign * unit.supply; }
+    }
+    if(unit.antiAir) { composition.antiAir += sign; }
+    if(unit.antiGround) { composition.antiGround += sign; }
+    if(IsDetector(record.type)) { composition.detectors += sign; }
+}
+
+/**
+ * @brief Gets the region cell containing a point.
+ *
+ * @param point The point to locate
+ * @return std::size_t The index of the region in byRegion
+ */
+std::size_t EnemyMemory::regionOf(const Point2D &point) const {
+    const float fx = std::fmax(0.0f, (point.x - origin.x) / ENEMY_REGION_SIZE);
+    const float fy = std::fmax(0.0f, (point.y - origin.y) / ENEMY_REGION_SIZE);
+    const std::size_t rx = std::min(static_cast<std::size_t>(fx), regionsX - 1);
+    const std::size_t ry = std::min(static_cast<std::size_t>(fy), regionsY - 1);
+    return ry * regionsX + rx;
+}
+
+/**
+ * @brief Removes a record index from an index bucket.
+ *
+ * @param bucket The bucket to remove from
+ * @param index The record index to remove
+ */
+void EnemyMemory::unlink(std::vector<std::size_t> &bucket, std::size_t index) {
+    for(std::size_t i = 0; i < bucket.size(); ++i) {
+        if(bucket[i] == index) {
+            bucket[i] = bucket.back();
+            bucket.pop_back();
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Recomputes the enemy main, natural and anchor structure.
+ *
+ * Only called when a structure is found, morphs or dies. The main is the town hall
+ * closest to an enemy start location, the natural is the town hall closest to the main.
+ */
+void EnemyMemory::refreshBases() {
+    mainIndex = SIZE_MAX;
+    naturalIndex = SIZE_MAX;
+    float best = std::numeric_limits<float>::max();
+    for(const auto index : townHalls) {
+        for(const auto &start : enemyStarts) {
+            const float distance = DistanceSquared2D(records[index].pos, start);
+            if(distance < best) {
+                best = distance;
+                mainIndex = index;
+            }
+        }
+    }
+    if(mainIndex == SIZE_MAX && !townHalls.empty()) { mainIndex = townHalls.front(); }
+    if(mainIndex != SIZE_MAX) {
+        best = std::numeric_limits<float>::max();
+        for(const auto index : townHalls) {
+            const float distance = DistanceSquared2D(records[index].pos, records[mainIndex].pos);
+            if(index != mainIndex && distance < best) {
+                best = distance;
+                naturalIndex = index;
+            }
+        }
+    }
+
+    anchorIndex = mainIndex;
+    if(anchorIndex == SIZE_MAX) {
+        for(const auto index : structures) {
+            if(anchorIndex == SIZE_MAX
+               || records[index].firstSeen < records[anchorIndex].firstSeen) {
+                anchorIndex = index;
+            }
+        }
+    }
+}
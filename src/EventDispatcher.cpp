@@ -0,0 +1,70 @@
+#include "EventDispatcher.h"
+
+using namespace sc2;
+
+/**
+ * @brief Queues a wake-up for a single unit.
+ *
+ * Wake-ups are delivered on the next call to dispatch, so events raised by the
+ * Agent callbacks or by controllers during a step are handled on the next step.
+ * Several events for the same unit are merged into one wake-up.
+ *
+ * @param tag The tag of the unit to wake
+ * @param reason The event that woke the unit
+ */
+void EventDispatcher::wake(Tag tag, WAKE reason) {
+    uint8_t &mask = queued[tag];
+    if(mask == 0) { queuedOrder.push_back(tag); }
+    mask |= reason;
+}
+
+/**
+ * @brief Queues a wake-up for every unit.
+ *
+ * Used for events that concern all subscribed units, such as an upgrade
+ * finishing or the army starting its attack.
+ *
+ * @param reason The event that woke the units
+ */
+void EventDispatcher::broadcast(WAKE reason) { queuedAll |= reason; }
+
+/**
+ * @brief Delivers all queued wake-ups for the current step.
+ *
+ * Called once at the start of every step, before the controllers run.
+ */
+void EventDispatcher::dispatch() {
+    active.swap(queued);
+    queued.clear();
+    woken.swap(queuedOrder);
+    queuedOrder.clear();
+    activeAll = queuedAll;
+    queuedAll = 0;
+}
+
+/**
+ * @brief Delivers the wake-up of a unit again on the next dispatch.
+ *
+ * Used when the controller of the unit was deferred this step, so the events
+ * that woke it are handled late instead of being lost.
+ *
+ * @param tag The tag of the unit
+ */
+void EventDispatcher::postpone(Tag tag) {
+    const uint8_t mask = reasons(tag);
+    if(mask == 0) { return; }
+    uint8_t &queuedMask = queued[tag];
+    if(queuedMask == 0) { queuedOrder.push_back(tag); }
+    queuedMask |= mask;
+}
+
+/**
+ * @brief Gets the events that woke a unit for the current step.
+ *
+ * @param tag The tag of the unit to check
+ * @return uint8_t A bitmask of EventDispatcher::WAKE values, 0 if the unit sleeps
+ */
+uint8_t EventDispatcher::reasons(Tag tag) const {
+    auto it = active.find(tag);
+    return activeAll | (it == active.end() ? 0 : it->second);
+}
@@ -0,0 +1,275 @@
+#include "FlowField.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace sc2;
+
+static const uint8_t FLOW_NONE = 8;
+static const int DXS[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int DYS[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+/**
+ * @brief Integrates the travel distance to a destination over the pathing grid.
+ *
+ * One Dijkstra search from the destination gives the distance of every cell,
+ * then every cell points at its neighbour with the smallest distance, using
+ * the same moves as the search. A destination inside an unpathable cell, such
+ * as a town hall, starts from the closest pathable cell.
+ *
+ * @param destination The position every unit using the field heads to
+ * @param pathing The pathing grid of the map
+ * @return FlowField The field, with no reachable cells if the destination is off the grid
+ */
+FlowField FlowField::toward(const Point2D &destination, const BitGrid &pathing) {
+    FlowField field = start(destination, pathing);
+    while(!field.build(pathing, std::numeric_limits<std::size_t>::max())) {}
+    return field;
+}
+
+/**
+ * @brief Starts a field toward a destination that is built by later calls to build.
+ *
+ * @param destination The position every unit using the field heads to
+ * @param pathing The pathing grid of the map
+ * @return FlowField The field, ready at once if the destination is off the grid
+ */
+FlowField FlowField::start(const Point2D &destination, const BitGrid &pathing) {
+    FlowField field;
+    field.destination = destination;
+    field.width = pathing.width;
+    field.height = pathing.height;
+    const std::size_t cells = static_cast<std::size_t>(pathing.width) * pathing.height;
+    field.directions.assign(cells, FLOW_NONE);
+    int x = static_cast<int>(destination.x);
+    int y = static_cast<int>(destination.y);
+    if(!pathing.nearest(x, y, DISTANCE_SNAP_RADIUS)) {
+        field.distances.assign(cells, std::numeric_limits<float>::infinity());
+        field.row = field.height;
+        return field;
+    }
+    field.goal = y * pathing.width + x;
+    field.search.start(pathing, x, y);
+    return field;
+}
+
+/**
+ * @brief Continues building the field for a bounded amount of work.
+ *
+ * Each call either expands up to the given number of cells of the search, or
+ * points rows downhill, a row counting as its width in cells. Distances are
+ * only published once the search is done and the rows are pointed after it,
+ * so a partial field sends every unit straight to the destination.
+ *
+ * @param pathing The pathing grid the field was started on
+ * @param cells The amount of work to do at most
+ * @return true if the field is ready, false if work is left
+ */
+bool FlowField::build(const BitGrid &pathing, std::size_t cells) {
+    if(ready()) { return true; }
+    if(distances.empty()) {
+        if(search.advance(pathing, cells)) {
+            distances = std::move(search.distances);
+            search = DistanceSearch();
+        }
+        return false;
+    }
+    for(std::size_t work = 0; row < height && work < cells; work += width) {
+        pointRow(pathing, row++);
+    }
+    return ready();
+}
+
+/**
+ * @brief Checks if the field is fully built.
+ *
+ * @return true if every cell points downhill, false otherwise
+ */
+bool FlowField::ready() const { return row >= height; }
+
+/**
+ * @brief Points every cell of a row at its neighbour closest to the destination.
+ *
+ * @param pathing The pathing grid of the map
+ * @param cy The row to point
+ */
+void FlowField::pointRow(const BitGrid &pathing, int cy) {
+    for(int cx = 0; cx < width; ++cx) {
+        const int here = cy * width + cx;
+        float best = distances[here];
+        if(!std::isfinite(best)) { continue; }
+        for(int k = 0; k < 8; ++k) {
+            const int nx = cx + DXS[k];
+            const int ny = cy + DYS[k];
+            if(!pathing.get(nx, ny)) { continue; }
+            if(k >= 4 && (!pathing.get(nx, cy) || !pathing.get(cx, ny))) { continue; }
+            const float next = distances[ny * width + nx];
+            if(next < best) {
+                best = next;
+                directions[here] = static_cast<uint8_t>(k);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Checks if a position can walk to the destination.
+ *
+ * @param pos The position to check
+ * @return true if the cell of the position has a finite distance, false otherwise
+ */
+bool FlowField::reachable(const Point2D &pos) const { return std::isfinite(distance(pos)); }
+
+/**
+ * @brief Gets the travel distance from a position to the destination.
+ *
+ * @param pos The position to look up
+ * @return float The distance, infinity if the position is off the grid or cannot reach it
+ */
+float FlowField::distance(const Point2D &pos) const {
+    const int index = cell(pos);
+    return index < 0 ? std::numeric_limits<float>::infinity() : distances[index];
+}
+
+/**
+ * @brief Gets the point a unit at a position should move to next.
+ *
+ * Follows the field for at most FLOW_LOOKAHEAD cells, so the lookup costs the
+ * same whatever the distance. Units that cannot use the field, and units close
+ * to the destination, are sent to the destination itself.
+ *
+ * @param pos The position of the unit
+ * @return Point2D The center of the cell FLOW_LOOKAHEAD steps downhill
+ */
+Point2D FlowField::waypoint(const Point2D &pos) const {
+    int index = cell(pos);
+    if(index < 0 || directions[index] == FLOW_NONE) { return destination; }
+    for(int step = 0; step < FLOW_LOOKAHEAD && directions[index] != FLOW_NONE; ++step) {
+        const uint8_t k = directions[index];
+        index += DYS[k] * width + DXS[k];
+    }
+    if(index == goal) { return destination; }
+    return Point2D(index % width + 0.5f, index / width + 0.5f);
+}
+
+/**
+ * @brief Gets the index of the cell under a position.
+ *
+ * @param pos The position to look up
+ * @return int The row-major cell index, -1 if the position is off the grid
+ */
+int FlowField::cell(const Point2D &pos) const {
+    const int x = static_cast<int>(pos.x);
+    const int y = static_cast<int>(pos.y);
+    if(x < 0 || y < 0 || x >= width || y >= height || distances.empty()) { return -1; }
+    return y * width + x;
+}
+
+/**
+ * @brief Gets the flow field toward a destination, computing it on first use.
+ *
+ * A field that is still being built in time slices is finished at once.
+ *
+ * @param destination The position to head to
+ * @param pathing The pathing grid of the map
+ * @return const FlowField& The field, valid until the next call
+ */
+const FlowField &FlowFields::toward(const Point2D &destination, const BitGrid &pathing) {
+    FlowField &field = find(destination, pathing).field;
+    while(!field.build(pathing, std::numeric_limits<std::size_t>::max())) {}
+    return field;
+}
+
+/**
+ * @brief Gets the flow field toward a destination without finishing it.
+ *
+ * A new destination only starts its field, like waypoint. The reference stays
+ * valid while fewer than FLOW_CACHE_SIZE other destinations are looked up, so
+ * the fields of a step can be read from the pool workers once fetched.
+ *
+ * @param destination The position to head to
+ * @param pathing The pathing grid of the map
+ * @return const FlowField& The field, it may not be ready yet
+ */
+const FlowField &FlowFields::field(const Point2D &destination, const BitGrid &pathing) {
+    return find(destination, pathing).field;
+}
+
+/**
+ * @brief Gets the point a unit should move to next on its way to a destination.
+ *
+ * A new destination only starts its field, which build finishes over the next
+ * steps. Until then the unit is sent to the destination itself.
+ *
+ * @param from The position of the unit
+ * @param to The destination
+ * @param pathing The pathing grid of the map
+ * @return Point2D The next waypoint, the destination itself once it is close
+ */
+Point2D FlowFields::waypoint(const Point2D &from, const Point2D &to, const BitGrid &pathing) {
+    const FlowField &field = find(to, pathing).field;
+    return field.ready() ? field.waypoint(from) : to;
+}
+
+/**
+ * @brief Checks if any cached field is still being built.
+ *
+ * @return true if a field needs more calls to build, false otherwise
+ */
+bool FlowFields::pending() const {
+    for(const auto &entry : entries) {
+        if(!entry.field.ready()) { return true; }
+    }
+    return false;
+}
+
+/**
+ * @brief Continues building the most recently used field that is not ready.
+ *
+ * @param pathing The pathing grid of the map
+ * @param cells The amount of work to do at most, see FlowField::build
+ * @return true if no field is left to build, false otherwise
+ */
+bool FlowFields::build(const BitGrid &pathing, std::size_t cells) {
+    Entry *newest = nullptr;
+    for(auto &entry : entries) {
+        if(!entry.field.ready() && (newest == nullptr || entry.used > newest->used)) {
+            newest = &entry;
+        }
+    }
+    if(newest != nullptr) { newest->field.build(pathing, cells); }
+    return !pending();
+}
+
+/**
+ * @brief Finds the cache entry of a destination, starting a field on first use.
+ *
+ * Destinations are matched by the cell they snap to, so small moves of a
+ * destination within a cell reuse its field. Once FLOW_CACHE_SIZE fields are
+ * kept, the least recently used one is replaced.
+ *
+ * @param destination The position to head to
+ * @param pathing The pathing grid of the map
+ * @return Entry& The entry, its field may not be ready yet
+ */
+FlowFields::Entry &FlowFields::find(const Point2D &destination, const BitGrid &pathing) {
+    ++clock;
+    const int cell = static_cast<int>(destination.y) * pathing.width
+                     + static_cast<int>(destination.x);
+    Entry *oldest = nullptr;
+    for(auto &entry : entries) {
+        if(entry.cell == cell) {
+            entry.used = clock;
+            return entry;
+        }
+        if(oldest == nullptr || entry.used < oldest->used) { oldest = &entry; }
+    }
+    if(entries.size() < FLOW_CACHE_SIZE) {
+        // Reserved up front, so adding a field never moves the others
+        entries.reserve(FLOW_CACHE_SIZE);
+        entries.push_back({cell, FlowField::start(destination, pathing), clock});
+        return entries.back();
+    }
+    *oldest = {cell, FlowField::start(destination, pathing), clock};
+    return *oldest;
+}
@@ -0,0 +1,161 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @brief Allocates the arena block once, up front.
+ *
+ * @param capacity The number of bytes the arena hands out per step before spilling
+ */
+FrameArena::FrameArena(std::size_t capacity)
+    : block(new std::max_align_t[(capacity + sizeof(std::max_align_t) - 1)
+                                 / sizeof(std::max_align_t)]),
+      size(capacity) {}
+
+/**
+ * @brief Hands out memory for the current step.
+ *
+ * Requests that do not fit in the block are served from the heap and counted
+ * as overflows, a sign ARENA_CAPACITY is too small.
+ *
+ * @param bytes The number of bytes
+ * @param alignment The alignment, at most that of std::max_align_t
+ * @return void* The memory, valid until the next reset
+ */
+void *FrameArena::allocate(std::size_t bytes, std::size_t alignment) {
+    ++allocations;
+    const std::size_t start = (used + alignment - 1) & ~(alignment - 1);
+    if(start + bytes > size) {
+        ++overflows;
+        const std::size_t count = (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        spilled.emplace_back(new std::max_align_t[count]);
+        return spilled.back().get();
+    }
+    used = start + bytes;
+    peak = std::max(peak, used);
+    return reinterpret_cast<unsigned char *>(block.get()) + start;
+}
+
+/**
+ * @brief Releases everything allocated during the last step.
+ */
+void FrameArena::reset() {
+    used = 0;
+    allocations = 0;
+    spilled.clear();
+}
+
+/**
+ * @brief Records the heap allocations a step made, for the end of game report.
+ *
+ * @param heapCalls The calls to the global operator new during the step
+ */
+void FrameArena::endStep(uint64_t heapCalls) {
+    ++steps;
+    if(heapCalls > 0) { ++heapSteps; }
+    maxHeapCalls = std::max(maxHeapCalls, heapCalls);
+}
+
+#if ONPHONE_COUNT_ALLOCATIONS
+static std::atomic<uint64_t> heapAllocations{0};
+
+/**
+ * @brief Allocates and counts memory for every replaced form of operator new.
+ *
+ * Over-aligned memory keeps the pointer malloc returned right before the
+ * block, so it is freed without an aligned allocator, which MSVC lacks.
+ *
+ * @param size The number of bytes
+ * @param alignment The alignment, 0 for the default alignment of malloc
+ * @return void* The memory, nullptr if it could not be allocated
+ */
+static void *CountedAllocate(std::size_t size, std::size_t alignment) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if(size == 0) { size = 1; }
+    if(alignment == 0) { return std::malloc(size); }
+    void *raw = std::malloc(size + alignment + sizeof(void *));
+    if(raw == nullptr) { return nullptr; }
+    const uintptr_t start
+      = (reinterpret_cast<uintptr_t>(raw) + sizeof(void *) + alignment - 1) & ~(alignment - 1);
+    reinterpret_cast<void **>(start)[-1] = raw;
+    return reinterpret_cast<void *>(start);
+}
+
+/**
+ * @brief Frees over-aligned memory from CountedAllocate.
+ *
+ * @param memory The memory, may be nullptr
+ */
+static void AlignedFree(void *memory) {
+    if(memory != nullptr) { std::free(static_cast<void **>(memory)[-1]); }
+}
+
+void *operator new(std::size_t size) {
+    if(void *memory = CountedAllocate(size, 0)) { return memory; }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if(void *memory = CountedAllocate(size, static_cast<std::size_t>(alignment))) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return CountedAllocate(size, 0);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return CountedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+    return operator new(size, tag);
+}
+void *operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &tag) noexcept {
+    return operator new(size, alignment, tag);
+}
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete[](void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void *memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void *memory, const std::nothrow_t &) noexcept { std::free(memory); }
+void operator delete[](void *memory, const std::nothrow_t &) noexcept { std::free(memory); }
+void operator delete(void *memory, std::align_val_t) noexcept { AlignedFree(memory); }
+void operator delete[](void *memory, std::align_val_t) noexcept { AlignedFree(memory); }
+void operator delete(void *memory, std::size_t, std::align_val_t) noexcept {
+    AlignedFree(memory);
+}
+void operator delete[](void *memory, std::size_t, std::align_val_t) noexcept {
+    AlignedFree(memory);
+}
+void operator delete(void *memory, std::align_val_t, const std::nothrow_t &) noexcept {
+    AlignedFree(memory);
+}
+void operator delete[](void *memory, std::align_val_t, const std::nothrow_t &) noexcept {
+    AlignedFree(memory);
+}
+
+/**
+ * @brief Gets the number of calls to the global operator new so far.
+ *
+ * @return uint64_t The number of heap allocations by any thread
+ */
+uint64_t HeapAllocations() { return heapAllocations.load(std::memory_order_relaxed); }
+#else
+/**
+ * @brief Gets the number of calls to the global operator new so far.
+ *
+ * @return uint64_t Always 0, heap allocations are only counted with ONPHONE_COUNT_ALLOCATIONS
+ */
+uint64_t HeapAllocations() { return 0; }
+#endif
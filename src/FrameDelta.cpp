@@ -0,0 +1,229 @@
+#include "FrameDelta.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+/**
+ * @brief Packs the first order of a unit into a single comparable key.
+ *
+ * @param unit The unit whose current order should be packed
+ * @return uint64_t 0 if the unit has no orders, otherwise a key combining the
+ * ability and its target
+ */
+static uint64_t OrderKey(const Unit &unit) {
+    if(unit.orders.empty()) { return 0; }
+    const UnitOrder &order = unit.orders.front();
+    uint64_t key = static_cast<uint64_t>(static_cast<uint32_t>(order.ability_id)) << 40;
+    key ^= order.target_unit_tag;
+    key ^= static_cast<uint64_t>(static_cast<uint32_t>(order.target_pos.x * 4.0f)) << 20;
+    key ^= static_cast<uint64_t>(static_cast<uint32_t>(order.target_pos.y * 4.0f));
+    return key | 1;
+}
+
+/**
+ * @brief Compares the current observation of our units with the previous one.
+ *
+ * The units are first scattered into packed per-slot arrays, then a single
+ * branch-free pass over all slots computes the change flags for every unit.
+ * The flagged units are finally compacted into the per-event tag lists, and
+ * slots of units that are no longer observed are recycled.
+ *
+ * @param units All of our units in the current observation
+ * @param gameLoop The current game loop
+ */
+void FrameDelta::update(const Units &units, uint32_t gameLoop) {
+    this->gameLoop = gameLoop;
+    ++frame;
+
+    for(const auto *unit : units) {
+        auto it = slotOf.find(unit->tag);
+        const bool isNew = it == slotOf.end();
+        const std::size_t slot = isNew ? allocateSlot(unit->tag) : it->second;
+        seen[slot] = frame;
+        health[slot] = unit->health;
+        shield[slot] = unit->shield;
+        shieldMax[slot] = unit->shield_max;
+        energy[slot] = unit->energy;
+        x[slot] = unit->pos.x;
+        y[slot] = unit->pos.y;
+        orderCount[slot] = static_cast<uint32_t>(unit->orders.size());
+        orderKey[slot] = OrderKey(*unit);
+        if(isNew) {
+            // A unit without history produces no events on its first frame
+            prevHealth[slot] = health[slot];
+            prevShield[slot] = shield[slot];
+            prevEnergy[slot] = energy[slot];
+            prevX[slot] = x[slot];
+            prevY[slot] = y[slot];
+            prevOrderCount[slot] = orderCount[slot];
+            prevOrderKey[slot] = orderKey[slot];
+        }
+    }
+
+    const std::size_t count = tags.size();
+    const uint32_t current = frame;
+    for(std::size_t i = 0; i < count; ++i) {
+        const float before = prevHealth[i] + prevShield[i];
+        const float after = health[i] + shield[i];
+        const float lost = before - after;
+        const float dx = x[i] - prevX[i];
+        const float dy = y[i] - prevY[i];
+        const float shieldLimit = shieldMax[i] * DELTA_SHIELD_THRESHOLD;
+        uint8_t f = 0;
+        f |= (lost > 0.0f) ? DAMAGED : 0;
+        f |= (dx > EPSILON || dx < -EPSILON || dy > EPSILON || dy < -EPSILON) ? MOVED : 0;
+        f |= (prevOrderCount[i] != 0 && orderCount[i] == 0) ? BECAME_IDLE : 0;
+        f |= (prevOrderKey[i] != orderKey[i]) ? ORDER_CHANGED : 0;
+        f |= (prevShield[i] >= shieldLimit && shield[i] < shieldLimit) ? SHIELDS_LOW : 0;
+        f |= (prevEnergy[i] < DELTA_ENERGY_THRESHOLD && energy[i] >= DELTA_ENERGY_THRESHOLD)
+               ? ENERGY_READY
+               : 0;
+        const bool alive = seen[i] == current;
+        flags[i] = alive ? f : 0;
+        damage[i] = (alive && lost > 0.0f) ? lost : 0.0f;
+    }
+
+    windowFrame = (windowFrame + 1) % DELTA_WINDOW_FRAMES;
+    windowLoops[windowFrame] = gameLoop;
+
+    damaged.clear();
+    moved.clear();
+    becameIdle.clear();
+    orderChanged.clear();
+    shieldsLow.clear();
+    energyReady.clear();
+    for(std::size_t i = 0; i < count; ++i) {
+        if(seen[i] != current) {
+            if(tags[i] != NullTag) { freeSlot(i); }
+            continue;
+        }
+        windowDamage[i * DELTA_WINDOW_FRAMES + windowFrame] = damage[i];
+        const uint8_t f = flags[i];
+        if(f == 0) { continue; }
+        if(f & DAMAGED) { damaged.push_back(tags[i]); }
+        if(f & MOVED) { moved.push_back(tags[i]); }
+        if(f & BECAME_IDLE) { becameIdle.push_back(tags[i]); }
+        if(f & ORDER_CHANGED) { orderChanged.push_back(tags[i]); }
+        if(f & SHIELDS_LOW) { shieldsLow.push_back(tags[i]); }
+        if(f & ENERGY_READY) { energyReady.push_back(tags[i]); }
+    }
+
+    health.swap(prevHealth);
+    shield.swap(prevShield);
+    energy.swap(prevEnergy);
+    x.swap(prevX);
+    y.swap(prevY);
+    orderCount.swap(prevOrderCount);
+    orderKey.swap(prevOrderKey);
+}
+
+/**
+ * @brief Checks whether a unit raised the given event in the last update.
+ *
+ * @param tag The tag of the unit to check
+ * @param event The event to check for
+ * @return true if the unit raised the event, false otherwise
+ */
+bool FrameDelta::test(Tag tag, EVENT event) const { return (events(tag) & event) != 0; }
+
+/**
+ * @brief Gets all events raised by a unit in the last update.
+ *
+ * @param tag The tag of the unit to check
+ * @return uint8_t A bitmask of FrameDelta::EVENT values
+ */
+uint8_t FrameDelta::events(Tag tag) const {
+    auto it = slotOf.find(tag);
+    if(it == slotOf.end()) { return 0; }
+    return flags[it->second];
+}
+
+/**
+ * @brief Sums the damage a unit took over a window of recent game loops.
+ *
+ * The window is limited to the last DELTA_WINDOW_FRAMES updates.
+ *
+ * @param tag The tag of the unit to check
+ * @param loops The length of the window in game loops
+ * @return float The health and shields lost within the window
+ */
+float FrameDelta::damageInWindow(Tag tag, uint32_t loops) const {
+    auto it = slotOf.find(tag);
+    if(it == slotOf.end()) { return 0.0f; }
+    const float *history = &windowDamage[it->second * DELTA_WINDOW_FRAMES];
+    const std::size_t frames = std::min<std::size_t>(frame, DELTA_WINDOW_FRAMES);
+    float total = 0.0f;
+    for(std::size_t i = 0; i < frames; ++i) {
+        const std::size_t f = (windowFrame + DELTA_WINDOW_FRAMES - i) % DELTA_WINDOW_FRAMES;
+        if(gameLoop - windowLoops[f] >= loops) { break; }
+        total += history[f];
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the position of a unit before the last update.
+ *
+ * @param tag The tag of the unit to check
+ * @return Point2D The prior position, or (0, 0) if the unit is not tracked
+ */
+Point2D FrameDelta::priorPos(Tag tag) const {
+    auto it = slotOf.find(tag);
+    if(it == slotOf.end()) { return Point2D(0, 0); }
+    // The arrays were swapped at the end of update, so the previous frame lives in x/y
+    return Point2D(x[it->second], y[it->second]);
+}
+
+/**
+ * @brief Assigns a packed slot to a newly observed unit.
+ *
+ * @param tag The tag of the unit
+ * @return std::size_t The slot assigned to the unit
+ */
+std::size_t FrameDelta::allocateSlot(Tag tag) {
+    std::size_t slot;
+    if(!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = tags.size();
+        const std::size_t size = slot + 1;
+        tags.resize(size);
+        seen.resize(size);
+        health.resize(size);
+        prevHealth.resize(size);
+        shield.resize(size);
+        prevShield.resize(size);
+        shieldMax.resize(size);
+        energy.resize(size);
+        prevEnergy.resize(size);
+        x.resize(size);
+        prevX.resize(size);
+        y.resize(size);
+        prevY.resize(size);
+        orderCount.resize(size);
+        prevOrderCount.resize(size);
+        orderKey.resize(size);
+        prevOrderKey.resize(size);
+        damage.resize(size);
+        flags.resize(size);
+        windowDamage.resize(size * DELTA_WINDOW_FRAMES);
+    }
+    tags[slot] = tag;
+    std::fill_n(windowDamage.begin() + slot * DELTA_WINDOW_FRAMES, DELTA_WINDOW_FRAMES, 0.0f);
+    slotOf[tag] = slot;
+    return slot;
+}
+
+/**
+ * @brief Releases the slot of a unit that is no longer observed.
+ *
+ * @param slot The slot to release
+ */
+void FrameDelta::freeSlot(std::size_t slot) {
+    slotOf.erase(tags[slot]);
+    tags[slot] = NullTag;
+    flags[slot] = 0;
+    freeSlots.push_back(slot);
+}
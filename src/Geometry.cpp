@@ -0,0 +1,385 @@
+#include "Geometry.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__)
+#define GEOMETRY_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GEOMETRY_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace sc2;
+
+/**
+ * @brief Gets the index of the lowest set bit of a non-zero mask.
+ *
+ * @param mask The mask to scan
+ * @return int The index of the lowest set bit
+ */
+static inline int LowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/**
+ * @brief Counts the set bits of a mask word.
+ *
+ * @param word The word to count
+ * @return std::size_t The number of set bits
+ */
+static inline std::size_t PopCount(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<std::size_t>(__popcnt64(word));
+#elif defined(_MSC_VER)
+    return __popcnt(static_cast<uint32_t>(word)) + __popcnt(static_cast<uint32_t>(word >> 32));
+#else
+    return static_cast<std::size_t>(__builtin_popcountll(word));
+#endif
+}
+
+/**
+ * @brief Finds the extreme distance of a point set, the first one on ties.
+ *
+ * Every lane keeps its own best distance and the index it was found at, the
+ * lanes are merged at the end and the points left over are checked one by one.
+ *
+ * @param points The points to search
+ * @param to The point to measure from
+ * @param farthest true to find the largest distance, false for the smallest
+ * @return std::size_t The index of the point, GEOMETRY_NONE if the set is empty
+ */
+static std::size_t Extreme(const PointSet &points, const Point2D &to, bool farthest) {
+    const std::size_t n = points.size();
+    const float *xs = points.xs.data();
+    const float *ys = points.ys.data();
+    float best = farthest ? -1.0f : std::numeric_limits<float>::infinity();
+    std::size_t bestIndex = GEOMETRY_NONE;
+    std::size_t i = 0;
+#if defined(GEOMETRY_AVX2)
+    if(n >= 8) {
+        const __m256 px = _mm256_set1_ps(to.x);
+        const __m256 py = _mm256_set1_ps(to.y);
+        __m256 lane = _mm256_set1_ps(best);
+        __m256i laneIndex = _mm256_set1_epi32(-1);
+        __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m256i step = _mm256_set1_epi32(8);
+        for(; i + 8 <= n; i += 8) {
+            const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px);
+            const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+            const __m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            const __m256 better = farthest ? _mm256_cmp_ps(d, lane, _CMP_GT_OQ)
+                                           : _mm256_cmp_ps(d, lane, _CMP_LT_OQ);
+            lane = _mm256_blendv_ps(lane, d, better);
+            laneIndex = _mm256_castps_si256(_mm256_blendv_ps(
+              _mm256_castsi256_ps(laneIndex), _mm256_castsi256_ps(index), better));
+            index = _mm256_add_epi32(index, step);
+        }
+        float values[8];
+        int32_t indices[8];
+        _mm256_storeu_ps(values, lane);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(indices), laneIndex);
+        for(int k = 0; k < 8; ++k) {
+            if(indices[k] < 0) { continue; }
+            const std::size_t at = static_cast<std::size_t>(indices[k]);
+            const bool better = farthest ? values[k] > best : values[k] < best;
+            if(better || (values[k] == best && at < bestIndex)) {
+                best = values[k];
+                bestIndex = at;
+            }
+        }
+    }
+#elif defined(GEOMETRY_SSE2)
+    if(n >= 4) {
+        const __m128 px = _mm_set1_ps(to.x);
+        const __m128 py = _mm_set1_ps(to.y);
+        __m128 lane = _mm_set1_ps(best);
+        __m128i laneIndex = _mm_set1_epi32(-1);
+        __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+        const __m128i step = _mm_set1_epi32(4);
+        for(; i + 4 <= n; i += 4) {
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+            const __m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            const __m128 better = farthest ? _mm_cmpgt_ps(d, lane) : _mm_cmplt_ps(d, lane);
+            lane = _mm_or_ps(_mm_and_ps(better, d), _mm_andnot_ps(better, lane));
+            const __m128i take = _mm_castps_si128(better);
+            laneIndex = _mm_or_si128(_mm_and_si128(take, index), _mm_andnot_si128(take, laneIndex));
+            index = _mm_add_epi32(index, step);
+        }
+        float values[4];
+        int32_t indices[4];
+        _mm_storeu_ps(values, lane);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(indices), laneIndex);
+        for(int k = 0; k < 4; ++k) {
+            if(indices[k] < 0) { continue; }
+            const std::size_t at = static_cast<std::size_t>(indices[k]);
+            const bool better = farthest ? values[k] > best : values[k] < best;
+            if(better || (values[k] == best && at < bestIndex)) {
+                best = values[k];
+                bestIndex = at;
+            }
+        }
+    }
+#endif
+    for(; i < n; ++i) {
+        const float dx = xs[i] - to.x;
+        const float dy = ys[i] - to.y;
+        const float d = dx * dx + dy * dy;
+        if(farthest ? d > best : d < best) {
+            best = d;
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+/**
+ * @brief Compares a block of points against a radius.
+ *
+ * @param points The points
+ * @param i The first point of the block, a multiple of the block size
+ * @param center The center of the circle
+ * @param radiusSquared The squared radius of the circle
+ * @param width The number of points in the block, set to the points compared
+ * @return uint32_t Bit k is set if point i + k is within the radius
+ */
+static inline uint32_t WithinBlock(const PointSet &points, std::size_t i, const Point2D &center,
+                                   float radiusSquared, std::size_t &width) {
+    const std::size_t n = points.size();
+    const float *xs = points.xs.data();
+    const float *ys = points.ys.data();
+#if defined(GEOMETRY_AVX2)
+    if(i + 8 <= n) {
+        width = 8;
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), _mm256_set1_ps(center.x));
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), _mm256_set1_ps(center.y));
+        const __m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        return static_cast<uint32_t>(
+          _mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_set1_ps(radiusSquared), _CMP_LE_OQ)));
+    }
+#elif defined(GEOMETRY_SSE2)
+    if(i + 4 <= n) {
+        width = 4;
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), _mm_set1_ps(center.x));
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), _mm_set1_ps(center.y));
+        const __m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(d, _mm_set1_ps(radiusSquared))));
+    }
+#endif
+    width = 1;
+    const float dx = xs[i] - center.x;
+    const float dy = ys[i] - center.y;
+    return dx * dx + dy * dy <= radiusSquared ? 1u : 0u;
+}
+
+/**
+ * @brief Copies the positions of units.
+ *
+ * @param units The units
+ */
+PointSet::PointSet(const Units &units) { assign(units); }
+
+/**
+ * @brief Copies points.
+ *
+ * @param points The points
+ */
+PointSet::PointSet(const std::vector<Point2D> &points) {
+    xs.reserve(points.size());
+    ys.reserve(points.size());
+    for(const auto &point : points) { push_back(point); }
+}
+
+/**
+ * @brief Replaces the points with the positions of units, keeping the capacity.
+ *
+ * @param units The units
+ */
+void PointSet::assign(const Units &units) {
+    clear();
+    xs.reserve(units.size());
+    ys.reserve(units.size());
+    for(const auto *unit : units) { push_back(unit->pos); }
+}
+
+/**
+ * @brief Adds a point at the end.
+ *
+ * @param point The point
+ */
+void PointSet::push_back(const Point2D &point) {
+    xs.push_back(point.x);
+    ys.push_back(point.y);
+}
+
+/**
+ * @brief Moves a point.
+ *
+ * @param i The index of the point
+ * @param point The new position
+ */
+void PointSet::set(std::size_t i, const Point2D &point) {
+    xs[i] = point.x;
+    ys[i] = point.y;
+}
+
+/**
+ * @brief Removes a point by moving the last point into its place.
+ *
+ * @param i The index of the point
+ */
+void PointSet::erase(std::size_t i) {
+    xs[i] = xs.back();
+    ys[i] = ys.back();
+    xs.pop_back();
+    ys.pop_back();
+}
+
+/**
+ * @brief Removes all points.
+ */
+void PointSet::clear() {
+    xs.clear();
+    ys.clear();
+}
+
+/**
+ * @brief Computes the squared distance of every point to a point.
+ *
+ * @param points The points
+ * @param to The point to measure from
+ * @param out The squared distances, one per point
+ */
+void DistancesSquared(const PointSet &points, const Point2D &to, float *out) {
+    const std::size_t n = points.size();
+    const float *xs = points.xs.data();
+    const float *ys = points.ys.data();
+    std::size_t i = 0;
+#if defined(GEOMETRY_AVX2)
+    const __m256 px = _mm256_set1_ps(to.x);
+    const __m256 py = _mm256_set1_ps(to.y);
+    for(; i + 8 <= n; i += 8) {
+        const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), px);
+        const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), py);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+    }
+#elif defined(GEOMETRY_SSE2)
+    const __m128 px = _mm_set1_ps(to.x);
+    const __m128 py = _mm_set1_ps(to.y);
+    for(; i + 4 <= n; i += 4) {
+        const __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+        const __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    }
+#endif
+    for(; i < n; ++i) {
+        const float dx = xs[i] - to.x;
+        const float dy = ys[i] - to.y;
+        out[i] = dx * dx + dy * dy;
+    }
+}
+
+/**
+ * @brief Finds the point closest to a point.
+ *
+ * @param points The points to search
+ * @param to The point to measure from
+ * @return std::size_t The index of the first closest point, GEOMETRY_NONE if the set is empty
+ */
+std::size_t Nearest(const PointSet &points, const Point2D &to) {
+    return Extreme(points, to, false);
+}
+
+/**
+ * @brief Finds the point farthest from a point.
+ *
+ * @param points The points to search
+ * @param to The point to measure from
+ * @return std::size_t The index of the first farthest point, GEOMETRY_NONE if the set is empty
+ */
+std::size_t Farthest(const PointSet &points, const Point2D &to) {
+    return Extreme(points, to, true);
+}
+
+/**
+ * @brief Finds the first point within a radius.
+ *
+ * @param points The points to search
+ * @param center The center of the circle
+ * @param radius The radius of the circle, points on it count as inside
+ * @return std::size_t The index of the first point inside, GEOMETRY_NONE if there is none
+ */
+std::size_t FirstWithin(const PointSet &points, const Point2D &center, float radius) {
+    const float radiusSquared = radius * radius;
+    std::size_t width;
+    for(std::size_t i = 0; i < points.size(); i += width) {
+        const uint32_t bits = WithinBlock(points, i, center, radiusSquared, width);
+        if(bits != 0) { return i + LowestBit(bits); }
+    }
+    return GEOMETRY_NONE;
+}
+
+/**
+ * @brief Marks every point within a radius.
+ *
+ * @param points The points to check
+ * @param center The center of the circle
+ * @param radius The radius of the circle, points on it count as inside
+ * @param mask Bit i % 64 of word i / 64 is set if point i is inside
+ * @return std::size_t The number of points inside
+ */
+std::size_t WithinRadius(const PointSet &points, const Point2D &center, float radius,
+                         std::vector<uint64_t> &mask) {
+    mask.assign((points.size() + 63) / 64, 0);
+    const float radiusSquared = radius * radius;
+    std::size_t width;
+    for(std::size_t i = 0; i < points.size(); i += width) {
+        // Blocks start at multiples of their width, so they never straddle two words
+        const uint64_t bits = WithinBlock(points, i, center, radiusSquared, width);
+        mask[i / 64] |= bits << (i % 64);
+    }
+    std::size_t count = 0;
+    for(const auto word : mask) { count += PopCount(word); }
+    return count;
+}
+
+/**
+ * @brief Finds the k points closest to a point, closest first.
+ *
+ * The distances are computed in one batch, then only the k smallest are
+ * sorted. Points at the same distance are ordered by index.
+ *
+ * @param points The points to search
+ * @param to The point to measure from
+ * @param k The number of points to find, all points if there are fewer
+ * @param indices The indices of the closest points in order
+ */
+void KNearest(const PointSet &points, const Point2D &to, std::size_t k,
+              std::vector<std::size_t> &indices) {
+    const std::size_t n = points.size();
+    std::vector<float> distances(n);
+    DistancesSquared(points, to, distances.data());
+    indices.resize(n);
+    for(std::size_t i = 0; i < n; ++i) { indices[i] = i; }
+    k = std::min(k, n);
+    auto closer = [&distances](std::size_t a, std::size_t b) {
+        return distances[a] < distances[b] || (distances[a] == distances[b] && a < b);
+    };
+    if(k < n) {
+        std::nth_element(indices.begin(), indices.begin() + k, indices.end(), closer);
+        indices.resize(k);
+    }
+    std::sort(indices.begin(), indices.end(), closer);
+}
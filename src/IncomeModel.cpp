@@ -0,0 +1,145 @@
+#include "IncomeModel.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace sc2;
+
+/**
+ * @brief Updates the bank and, every INCOME_SAMPLE_INTERVAL game loops, the rates.
+ *
+ * @param observation The current observation
+ * @param units Our units of this step
+ */
+void IncomeModel::update(const ObservationInterface *observation, const Units &units) {
+    bank = {static_cast<float>(observation->GetMinerals()),
+            static_cast<float>(observation->GetVespene())};
+    const uint32_t gameLoop = observation->GetGameLoop();
+    if(gameLoop < nextSample) { return; }
+    nextSample = gameLoop + INCOME_SAMPLE_INTERVAL;
+
+    model(units);
+    const ScoreDetails &score = observation->GetScore().score_details;
+    window[head] = {gameLoop, score.collected_minerals, score.collected_vespene, modelMinerals,
+                    modelVespene};
+    head = (head + 1) % INCOME_WINDOW;
+    count = std::min<std::size_t>(count + 1, INCOME_WINDOW);
+    calibrate();
+}
+
+/**
+ * @brief Gets the expected mineral income.
+ *
+ * @return float The minerals mined per game loop
+ */
+float IncomeModel::mineralRate() const { return modelMinerals * mineralScale; }
+
+/**
+ * @brief Gets the expected vespene income.
+ *
+ * @return float The vespene mined per game loop
+ */
+float IncomeModel::vespeneRate() const { return modelVespene * vespeneScale; }
+
+/**
+ * @brief Estimates how long until the bank covers a cost at the current income.
+ *
+ * @param minerals The mineral cost
+ * @param vespene The vespene cost
+ * @return uint32_t The number of game loops to wait, 0 if affordable now and
+ * UINT32_MAX if the missing resources are not being mined
+ */
+uint32_t IncomeModel::timeUntilAffordable(int minerals, int vespene) const {
+    const float missing[2] = {minerals - bank.minerals, vespene - bank.vespene};
+    const float rates[2] = {mineralRate(), vespeneRate()};
+    uint32_t wait = 0;
+    for(int i = 0; i < 2; ++i) {
+        if(missing[i] <= 0.0f) { continue; }
+        if(rates[i] <= 0.0f) { return std::numeric_limits<uint32_t>::max(); }
+        wait = std::max(wait, static_cast<uint32_t>(std::ceil(missing[i] / rates[i])));
+    }
+    return wait;
+}
+
+/**
+ * @brief Projects the bank forward, assuming nothing is spent.
+ *
+ * @param loops The number of game loops to look ahead
+ * @return Bank The expected minerals and vespene
+ */
+IncomeModel::Bank IncomeModel::project(uint32_t loops) const {
+    return {bank.minerals + mineralRate() * loops, bank.vespene + vespeneRate() * loops};
+}
+
+/**
+ * @brief Projects the bank at regular intervals, assuming nothing is spent.
+ *
+ * @param horizon The number of game loops to look ahead
+ * @param step The number of game loops between points
+ * @return std::vector<Bank> The expected bank now and after every step up to the horizon
+ */
+std::vector<IncomeModel::Bank> IncomeModel::curve(uint32_t horizon, uint32_t step) const {
+    std::vector<Bank> points;
+    if(step == 0) { return points; }
+    points.reserve(horizon / step + 1);
+    for(uint32_t loops = 0; loops <= horizon; loops += step) { points.push_back(project(loops)); }
+    return points;
+}
+
+/**
+ * @brief Models the income from the harvesters of every finished base and extractor.
+ *
+ * Mineral workers above the ideal count of a base, up to three per patch, mine
+ * at INCOME_OVERSATURATED_FACTOR of the rate of the others.
+ *
+ * @param units Our units of this step
+ */
+void IncomeModel::model(const Units &units) {
+    modelMinerals = 0.0f;
+    modelVespene = 0.0f;
+    for(const auto *unit : units) {
+        if(unit->build_progress < 1.0f
+           || (!IsTownHall(unit->unit_type) && unit->unit_type != UNIT_TYPEID::ZERG_EXTRACTOR)) {
+            continue;
+        }
+        const int ideal = unit->ideal_harvesters;
+        const int assigned = unit->assigned_harvesters;
+        if(unit->unit_type == UNIT_TYPEID::ZERG_EXTRACTOR) {
+            modelVespene += std::min(assigned, ideal) * INCOME_VESPENE_PER_WORKER;
+        } else {
+            const int extra = std::max(0, std::min(assigned - ideal, ideal / 2));
+            modelMinerals += (std::min(assigned, ideal) + INCOME_OVERSATURATED_FACTOR * extra)
+                             * INCOME_MINERALS_PER_WORKER;
+        }
+    }
+}
+
+/**
+ * @brief Scales the modelled rates to what was actually mined over the window.
+ *
+ * The model reacts to new harvesters straight away while the scale corrects
+ * for mining distances and travel, so the rate is both current and accurate.
+ */
+void IncomeModel::calibrate() {
+    if(count < 2) { return; }
+    const std::size_t first = (head + INCOME_WINDOW - count) % INCOME_WINDOW;
+    float expectedMinerals = 0.0f;
+    float expectedVespene = 0.0f;
+    for(std::size_t n = 0; n + 1 < count; ++n) {
+        const Sample &from = window[(first + n) % INCOME_WINDOW];
+        const Sample &to = window[(first + n + 1) % INCOME_WINDOW];
+        expectedMinerals += from.modelMinerals * (to.loop - from.loop);
+        expectedVespene += from.modelVespene * (to.loop - from.loop);
+    }
+    const Sample &oldest = window[first];
+    const Sample &newest = window[(head + INCOME_WINDOW - 1) % INCOME_WINDOW];
+    // Harvesters return 5 minerals or 4 vespene per trip, wait for a few trips before scaling
+    if(expectedMinerals >= 50.0f) {
+        mineralScale = (newest.collectedMinerals - oldest.collectedMinerals) / expectedMinerals;
+    }
+    if(expectedVespene >= 40.0f) {
+        vespeneScale = (newest.collectedVespene - oldest.collectedVespene) / expectedVespene;
+    }
+}
@@ -0,0 +1,152 @@
+#include "InjectScheduler.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace sc2;
+
+/**
+ * @brief Adds a new queen, paired with the closest hatchery without a queen.
+ *
+ * Queens beyond the number of hatcheries wait until a hatchery is free.
+ *
+ * @param queen The queen to add
+ * @param gameLoop The current game loop
+ */
+void InjectScheduler::addQueen(const Unit *queen, uint32_t gameLoop) {
+    if(pairings.count(queen->tag) != 0) { return; }
+    if(freeHatcheries.empty()) {
+        freeQueens.push_back(queen);
+        return;
+    }
+    positions.assign(freeHatcheries);
+    auto closest = freeHatcheries.begin() + Nearest(positions, queen->pos);
+    const Unit *hatchery = *closest;
+    freeHatcheries.erase(closest);
+    pair(queen, hatchery, gameLoop);
+}
+
+/**
+ * @brief Adds a finished hatchery, paired with the closest queen without a hatchery.
+ *
+ * @param hatchery The hatchery to add
+ * @param gameLoop The current game loop
+ */
+void InjectScheduler::addHatchery(const Unit *hatchery, uint32_t gameLoop) {
+    if(queenOf.count(hatchery->tag) != 0) { return; }
+    if(freeQueens.empty()) {
+        freeHatcheries.push_back(hatchery);
+        return;
+    }
+    positions.assign(freeQueens);
+    auto closest = freeQueens.begin() + Nearest(positions, hatchery->pos);
+    const Unit *queen = *closest;
+    freeQueens.erase(closest);
+    pair(queen, hatchery, gameLoop);
+}
+
+/**
+ * @brief Removes a queen or hatchery that died.
+ *
+ * The partner it leaves behind is paired again as if it was just added.
+ *
+ * @param tag The tag of the unit that died
+ * @param gameLoop The current game loop
+ */
+void InjectScheduler::remove(Tag tag, uint32_t gameLoop) {
+    auto byTag = [tag](const Unit *unit) { return unit->tag == tag; };
+    freeQueens.erase(std::remove_if(freeQueens.begin(), freeQueens.end(), byTag),
+                     freeQueens.end());
+    freeHatcheries.erase(std::remove_if(freeHatcheries.begin(), freeHatcheries.end(), byTag),
+                         freeHatcheries.end());
+    expiry.erase(tag);
+
+    auto hatchery = queenOf.find(tag);
+    auto queen = pairings.find(hatchery == queenOf.end() ? tag : hatchery->second);
+    if(queen == pairings.end()) { return; }
+    const Pairing pairing = queen->second;
+    pairings.erase(queen);
+    queenOf.erase(pairing.hatchery->tag);
+    if(pairing.queen->tag != tag) { addQueen(pairing.queen, gameLoop); }
+    if(pairing.hatchery->tag != tag) { addHatchery(pairing.hatchery, gameLoop); }
+}
+
+/**
+ * @brief Issues the injects that are due.
+ *
+ * Only the front of the queue is checked, so steps without a due inject cost
+ * constant time. The energy of a queen is checked when its inject is due and
+ * the inject is rescheduled if the prediction was early.
+ *
+ * @param gameLoop The current game loop
+ * @param actions The interface to issue the injects with
+ */
+void InjectScheduler::step(uint32_t gameLoop, ActionInterface *actions) {
+    while(!queue.empty() && queue.top().loop <= gameLoop) {
+        const Due due = queue.top();
+        queue.pop();
+        auto it = pairings.find(due.queen);
+        if(it == pairings.end() || it->second.version != due.version) { continue; }
+        const Pairing &pairing = it->second;
+        if(pairing.queen->energy < INJECT_ENERGY_COST) {
+            schedule(pairing, gameLoop + readyIn(pairing.queen->energy));
+            continue;
+        }
+        actions->UnitCommand(pairing.queen, ABILITY_ID::EFFECT_INJECTLARVA, pairing.hatchery);
+        LOG_INFO_LIMITED(1, "Command Sent: Injecting larvae into hatchery");
+        const uint32_t expires = gameLoop + INJECT_DURATION_LOOPS;
+        expiry[pairing.hatchery->tag] = expires;
+        schedule(pairing,
+                 std::max(gameLoop + readyIn(pairing.queen->energy - INJECT_ENERGY_COST), expires));
+    }
+}
+
+/**
+ * @brief Gets the number of hatcheries a queen is injecting.
+ *
+ * @return std::size_t The number of queen and hatchery pairs
+ */
+std::size_t InjectScheduler::injecting() const { return pairings.size(); }
+
+/**
+ * @brief Pairs a queen with a hatchery and schedules its first inject.
+ *
+ * @param queen The queen to pair
+ * @param hatchery The hatchery to inject
+ * @param gameLoop The current game loop
+ */
+void InjectScheduler::pair(const Unit *queen, const Unit *hatchery, uint32_t gameLoop) {
+    const Pairing pairing = {queen, hatchery, ++version};
+    pairings[queen->tag] = pairing;
+    queenOf[hatchery->tag] = queen->tag;
+    auto expires = expiry.find(hatchery->tag);
+    const uint32_t free = expires == expiry.end() ? gameLoop : expires->second;
+    schedule(pairing, std::max(gameLoop + readyIn(queen->energy), free));
+}
+
+/**
+ * @brief Queues the next inject of a pairing.
+ *
+ * @param pairing The queen and hatchery to inject
+ * @param loop The game loop the inject is due on
+ */
+void InjectScheduler::schedule(const Pairing &pairing, uint32_t loop) {
+    queue.push({loop, pairing.queen->tag, pairing.version});
+}
+
+// A queen regains the energy of an inject in 31.7 s of game time, 711 game loops
+static_assert(INJECT_ENERGY_COST / INJECT_ENERGY_PER_LOOP > 710.0f
+                && INJECT_ENERGY_COST / INJECT_ENERGY_PER_LOOP < 712.0f,
+              "Queen energy regeneration does not match the game");
+
+/**
+ * @brief Predicts how long a queen needs to regenerate energy for an inject.
+ *
+ * @param energy The current energy of the queen
+ * @return uint32_t The number of game loops until the queen can inject
+ */
+uint32_t InjectScheduler::readyIn(float energy) {
+    if(energy >= INJECT_ENERGY_COST) { return 0; }
+    return static_cast<uint32_t>(std::ceil((INJECT_ENERGY_COST - energy) / INJECT_ENERGY_PER_LOOP));
+}
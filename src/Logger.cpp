@@ -0,0 +1,213 @@
+#include "Logger.h"
+
+#define LOG_BINARY_MAGIC "ONPHLOG1"
+#define LOG_BINARY_SITE 0xFFFFFFFFu
+
+/**
+ * @brief Gets the process wide logger.
+ *
+ * The logger thread is started on first use and drained when the process exits.
+ *
+ * @return Logger& The logger instance
+ */
+Logger &Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : ring(new LogRecord[LOG_RING_SIZE]) {
+    for(uint64_t i = 0; i < LOG_RING_SIZE; ++i) {
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    worker = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+    running.store(false, std::memory_order_release);
+    if(worker.joinable()) { worker.join(); }
+    const uint64_t lost = dropped.load(std::memory_order_relaxed);
+    if(lost != 0) {
+        std::fprintf(stderr, "Logger dropped %llu messages\n",
+                     static_cast<unsigned long long>(lost));
+    }
+    if(std::FILE *file = binary.exchange(nullptr)) { std::fclose(file); }
+}
+
+/**
+ * @brief Additionally writes every message to a binary log file.
+ *
+ * Messages are written as raw arguments next to a table of format strings and can be
+ * turned back into text with scripts/decode-log.py. Result messages are still printed.
+ *
+ * @param path Path of the binary log file
+ * @return true if the file was opened, false otherwise
+ */
+bool Logger::openBinary(const std::string &path) {
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if(file == nullptr) { return false; }
+    std::fwrite(LOG_BINARY_MAGIC, 1, sizeof(LOG_BINARY_MAGIC) - 1, file);
+    if(std::FILE *previous = binary.exchange(file)) { std::fclose(previous); }
+    return true;
+}
+
+/**
+ * @brief Blocks until every message logged so far has been written.
+ *
+ * Only meant for the end of a game, never call this from the step loop.
+ */
+void Logger::flush() {
+    const uint64_t target = head.load(std::memory_order_acquire);
+    while(tail.load(std::memory_order_acquire) < target) {
+        if(!worker.joinable()) {
+            drain();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    std::fflush(stdout);
+    if(std::FILE *file = binary.load()) { std::fflush(file); }
+}
+
+/**
+ * @brief Applies the per-site rate limit of a message.
+ *
+ * @param site The call site that is logging
+ * @param now The current time in nanoseconds
+ * @param suppressed Set to the number of messages dropped in the previous window
+ * @return true if the message may be logged, false otherwise
+ */
+bool Logger::admit(LogSite &site, int64_t now, uint32_t &suppressed) {
+    int64_t start = site.windowStart.load(std::memory_order_relaxed);
+    if(now - start >= 1000000000
+       && site.windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        site.windowCount.store(1, std::memory_order_relaxed);
+        return true;
+    }
+    if(site.windowCount.fetch_add(1, std::memory_order_relaxed) < site.maxPerSecond) {
+        return true;
+    }
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+/**
+ * @brief Reserves the next free record of the ring buffer.
+ *
+ * Multiple threads may log at once, each claims a record with a single compare and
+ * swap. When the ring is full the message is dropped rather than blocking the caller.
+ *
+ * @param position Set to the ring position of the claimed record
+ * @return LogRecord* The claimed record, or nullptr if the ring is full
+ */
+LogRecord *Logger::claim(uint64_t &position) {
+    position = head.load(std::memory_order_relaxed);
+    for(;;) {
+        LogRecord &record = ring[position & (LOG_RING_SIZE - 1)];
+        const uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+        if(diff == 0) {
+            if(head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                return &record;
+            }
+        } else if(diff < 0) {
+            return nullptr;
+        } else {
+            position = head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Hands a filled record over to the logger thread.
+ *
+ * @param record The record to publish
+ * @param position The ring position the record was claimed at
+ */
+void Logger::publish(LogRecord *record, uint64_t position) {
+    record->sequence.store(position + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Main loop of the logger thread.
+ *
+ * Drains the ring buffer and writes the messages, sleeping briefly whenever the
+ * ring is empty.
+ */
+void Logger::run() {
+    while(running.load(std::memory_order_acquire)) {
+        bool wrote = false;
+        while(drain()) { wrote = true; }
+        if(wrote) {
+            std::fflush(stdout);
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    while(drain()) {}
+    std::fflush(stdout);
+}
+
+/**
+ * @brief Writes the oldest published record, if any.
+ *
+ * @return true if a record was written, false if the ring is empty
+ */
+bool Logger::drain() {
+    const uint64_t position = tail.load(std::memory_order_relaxed);
+    LogRecord &record = ring[position & (LOG_RING_SIZE - 1)];
+    if(record.sequence.load(std::memory_order_acquire) != position + 1) { return false; }
+    if(binary.load(std::memory_order_relaxed) != nullptr) {
+        writeBinary(record);
+        if(record.site->level >= LOG_LEVEL_RESULT) { writeText(record); }
+    } else {
+        writeText(record);
+    }
+    record.sequence.store(position + LOG_RING_SIZE, std::memory_order_release);
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Formats a record as a line of text on stdout.
+ *
+ * @param record The record to write
+ */
+void Logger::writeText(const LogRecord &record) {
+    line.clear();
+    record.args->format(record.site->format, record.payload, line);
+    if(record.suppressed != 0) {
+        line += " (" + std::to_string(record.suppressed) + " similar messages suppressed)";
+    }
+    line.push_back('\n');
+    std::fwrite(line.data(), 1, line.size(), stdout);
+}
+
+/**
+ * @brief Writes a record in binary form.
+ *
+ * The first message of each call site is preceded by a definition of the site
+ * holding its level, format string and argument signature.
+ *
+ * @param record The record to write
+ */
+void Logger::writeBinary(const LogRecord &record) {
+    std::FILE *file = binary.load(std::memory_order_relaxed);
+    LogSite &site = const_cast<LogSite &>(*record.site);
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if(id == 0) {
+        id = nextSiteId.fetch_add(1, std::memory_order_relaxed) + 1;
+        site.id.store(id, std::memory_order_relaxed);
+        const uint32_t marker = LOG_BINARY_SITE;
+        const int32_t level = site.level;
+        std::fwrite(&marker, sizeof(marker), 1, file);
+        std::fwrite(&id, sizeof(id), 1, file);
+        std::fwrite(&level, sizeof(level), 1, file);
+        LogSerialize(file, site.format);
+        LogSerialize(file, record.args->signature);
+    }
+    std::fwrite(&id, sizeof(id), 1, file);
+    std::fwrite(&record.timestamp, sizeof(record.timestamp), 1, file);
+    std::fwrite(&record.suppressed, sizeof(record.suppressed), 1, file);
+    record.args->serialize(record.payload, file);
+}
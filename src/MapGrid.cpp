@@ -0,0 +1,674 @@
+#include "MapGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+
+#if defined(__AVX2__)
+#define GRID_AVX2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRID_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief Counts the set bits of a word.
+ *
+ * @param word The word to count
+ * @return int The number of set bits
+ */
+static inline int PopCount(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(word));
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+    for(; word != 0; word &= word - 1) { ++count; }
+    return count;
+#endif
+}
+
+/**
+ * @brief Bit-reversal table for bytes, the images store the leftmost pixel in the MSB.
+ */
+static const struct ReversedBytes {
+    uint8_t values[256];
+    ReversedBytes() {
+        for(int i = 0; i < 256; ++i) {
+            uint8_t reversed = 0;
+            for(int bit = 0; bit < 8; ++bit) {
+                if(i & (1 << bit)) { reversed |= static_cast<uint8_t>(0x80 >> bit); }
+            }
+            values[i] = reversed;
+        }
+    }
+} ReversedByte;
+
+// Bulk kernels over whole grids, the word count is always a multiple of GRID_ROW_WORDS
+
+static void AndWords(uint64_t *dst, const uint64_t *src, std::size_t count) {
+    std::size_t i = 0;
+#if defined(GRID_AVX2)
+    for(; i + 4 <= count; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_and_si256(a, b));
+    }
+#elif defined(GRID_SSE2)
+    for(; i + 2 <= count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_and_si128(a, b));
+    }
+#endif
+    for(; i < count; ++i) { dst[i] &= src[i]; }
+}
+
+static void OrWords(uint64_t *dst, const uint64_t *src, std::size_t count) {
+    std::size_t i = 0;
+#if defined(GRID_AVX2)
+    for(; i + 4 <= count; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_or_si256(a, b));
+    }
+#elif defined(GRID_SSE2)
+    for(; i + 2 <= count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_or_si128(a, b));
+    }
+#endif
+    for(; i < count; ++i) { dst[i] |= src[i]; }
+}
+
+static void AndNotWords(uint64_t *dst, const uint64_t *src, std::size_t count) {
+    std::size_t i = 0;
+#if defined(GRID_AVX2)
+    for(; i + 4 <= count; i += 4) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_andnot_si256(b, a));
+    }
+#elif defined(GRID_SSE2)
+    for(; i + 2 <= count; i += 2) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_andnot_si128(b, a));
+    }
+#endif
+    for(; i < count; ++i) { dst[i] &= ~src[i]; }
+}
+
+/**
+ * @brief ORs a row with itself shifted one cell left and one cell right.
+ *
+ * @param src The row to spread
+ * @param dst The spread row
+ */
+static inline void SpreadRow(const uint64_t *src, uint64_t *dst) {
+#if defined(GRID_AVX2)
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    const __m256i zero = _mm256_setzero_si256();
+    // x + 1: carry the top bit of every word into the next word
+    __m256i carry = _mm256_permute4x64_epi64(_mm256_srli_epi64(v, 63), _MM_SHUFFLE(2, 1, 0, 3));
+    const __m256i up
+      = _mm256_or_si256(_mm256_slli_epi64(v, 1), _mm256_blend_epi32(carry, zero, 0x03));
+    // x - 1: carry the bottom bit of every word into the previous word
+    carry = _mm256_permute4x64_epi64(_mm256_slli_epi64(v, 63), _MM_SHUFFLE(0, 3, 2, 1));
+    const __m256i down
+      = _mm256_or_si256(_mm256_srli_epi64(v, 1), _mm256_blend_epi32(carry, zero, 0xC0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst),
+                        _mm256_or_si256(v, _mm256_or_si256(up, down)));
+#else
+    for(int i = 0; i < GRID_ROW_WORDS; ++i) {
+        uint64_t word = src[i] | (src[i] << 1) | (src[i] >> 1);
+        if(i > 0) { word |= src[i - 1] >> 63; }
+        if(i + 1 < GRID_ROW_WORDS) { word |= src[i + 1] << 63; }
+        dst[i] = word;
+    }
+#endif
+}
+
+/**
+ * @brief Creates an empty grid.
+ *
+ * @param width The width of the grid in cells, at most GRID_MAX_WIDTH
+ * @param height The height of the grid in cells
+ */
+BitGrid::BitGrid(int width, int height)
+    : width(std::max(0, std::min(width, GRID_MAX_WIDTH))), height(std::max(0, height)),
+      words(static_cast<std::size_t>(this->height) * GRID_ROW_WORDS, 0) {
+    for(int i = 0; i < GRID_ROW_WORDS; ++i) {
+        const int bits = std::max(0, std::min(64, this->width - i * 64));
+        tail[i] = bits == 64 ? ~0ULL : ((1ULL << bits) - 1);
+    }
+}
+
+/**
+ * @brief Decodes a packed image into a grid, setting every non-zero pixel.
+ *
+ * 1-bit images store pixels row by row, leftmost pixel in the most significant
+ * bit. When the rows are byte aligned whole bytes are copied at once.
+ *
+ * @param data The packed pixels
+ * @param width The width of the image
+ * @param height The height of the image
+ * @param bitsPerPixel 1 or 8
+ * @return BitGrid The decoded grid, empty if the image is malformed
+ */
+BitGrid BitGrid::decode(const std::string &data, int width, int height, int bitsPerPixel) {
+    const std::size_t pixels = static_cast<std::size_t>(width) * height;
+    if(width > GRID_MAX_WIDTH || (bitsPerPixel != 1 && bitsPerPixel != 8)
+       || data.size() * 8 < pixels * bitsPerPixel) {
+        return BitGrid();
+    }
+    BitGrid grid(width, height);
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data.data());
+    if(bitsPerPixel == 8) {
+        for(int y = 0; y < height; ++y) {
+            uint64_t *row = grid.row(y);
+            const uint8_t *src = bytes + static_cast<std::size_t>(y) * width;
+            for(int x = 0; x < width; ++x) {
+                row[x >> 6] |= static_cast<uint64_t>(src[x] != 0) << (x & 63);
+            }
+        }
+    } else if(width % 8 == 0) {
+        const int rowBytes = width / 8;
+        for(int y = 0; y < height; ++y) {
+            uint64_t *row = grid.row(y);
+            const uint8_t *src = bytes + static_cast<std::size_t>(y) * rowBytes;
+            for(int b = 0; b < rowBytes; ++b) {
+                const int x = b * 8;
+                row[x >> 6] |= static_cast<uint64_t>(ReversedByte.values[src[b]]) << (x & 63);
+            }
+        }
+    } else {
+        for(int y = 0; y < height; ++y) {
+            uint64_t *row = grid.row(y);
+            for(int x = 0; x < width; ++x) {
+                const std::size_t i = static_cast<std::size_t>(y) * width + x;
+                const uint64_t bit = (bytes[i >> 3] >> (7 - (i & 7))) & 1;
+                row[x >> 6] |= bit << (x & 63);
+            }
+        }
+    }
+    return grid;
+}
+
+/**
+ * @brief Decodes an 8-bit image into a grid, setting every pixel equal to a value.
+ *
+ * Used for the visibility map, where 2 means visible.
+ *
+ * @param data The pixels, one byte each
+ * @param width The width of the image
+ * @param height The height of the image
+ * @param value The pixel value to select
+ * @return BitGrid The decoded grid, empty if the image is malformed
+ */
+BitGrid BitGrid::decodeValue(const std::string &data, int width, int height, uint8_t value) {
+    if(width > GRID_MAX_WIDTH || data.size() < static_cast<std::size_t>(width) * height) {
+        return BitGrid();
+    }
+    const HeightMap view(data, width, height);
+    return view.band(value, value);
+}
+
+/**
+ * @brief Gets a cell, cells outside the grid are clear.
+ *
+ * @param x The column of the cell
+ * @param y The row of the cell
+ * @return true if the cell is set, false otherwise
+ */
+bool BitGrid::get(int x, int y) const {
+    if(x < 0 || y < 0 || x >= width || y >= height) { return false; }
+    return (row(y)[x >> 6] >> (x & 63)) & 1;
+}
+
+/**
+ * @brief Sets or clears a cell, cells outside the grid are ignored.
+ *
+ * @param x The column of the cell
+ * @param y The row of the cell
+ * @param value Whether the cell is set
+ */
+void BitGrid::set(int x, int y, bool value) {
+    if(x < 0 || y < 0 || x >= width || y >= height) { return; }
+    const uint64_t bit = 1ULL << (x & 63);
+    if(value) {
+        row(y)[x >> 6] |= bit;
+    } else {
+        row(y)[x >> 6] &= ~bit;
+    }
+}
+
+/**
+ * @brief Sets or clears every cell.
+ *
+ * @param value Whether the cells are set
+ */
+void BitGrid::fill(bool value) {
+    for(int y = 0; y < height; ++y) {
+        uint64_t *cells = row(y);
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) { cells[i] = value ? tail[i] : 0; }
+    }
+}
+
+/**
+ * @brief Intersects this grid with another grid of the same size.
+ *
+ * @param other The other grid
+ * @return BitGrid& This grid
+ */
+BitGrid &BitGrid::operator&=(const BitGrid &other) {
+    AndWords(words.data(), other.words.data(), std::min(words.size(), other.words.size()));
+    return *this;
+}
+
+/**
+ * @brief Unites this grid with another grid of the same size.
+ *
+ * @param other The other grid
+ * @return BitGrid& This grid
+ */
+BitGrid &BitGrid::operator|=(const BitGrid &other) {
+    OrWords(words.data(), other.words.data(), std::min(words.size(), other.words.size()));
+    return *this;
+}
+
+/**
+ * @brief Clears every cell that is set in another grid of the same size.
+ *
+ * @param other The other grid
+ * @return BitGrid& This grid
+ */
+BitGrid &BitGrid::andNot(const BitGrid &other) {
+    AndNotWords(words.data(), other.words.data(), std::min(words.size(), other.words.size()));
+    return *this;
+}
+
+/**
+ * @brief Flips every cell of the grid.
+ *
+ * @return BitGrid& This grid
+ */
+BitGrid &BitGrid::invert() {
+    for(int y = 0; y < height; ++y) {
+        uint64_t *cells = row(y);
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) { cells[i] = ~cells[i] & tail[i]; }
+    }
+    return *this;
+}
+
+/**
+ * @brief Moves every cell by an offset, cells shifted in from outside are clear.
+ *
+ * @param dx The offset along x
+ * @param dy The offset along y
+ * @return BitGrid The shifted grid
+ */
+BitGrid BitGrid::shifted(int dx, int dy) const {
+    BitGrid result(width, height);
+    if(dx >= width || -dx >= width || dy >= height || -dy >= height) { return result; }
+    const int wordShift = (dx >= 0 ? dx : -dx) >> 6;
+    const int bitShift = (dx >= 0 ? dx : -dx) & 63;
+    for(int y = std::max(0, dy); y < std::min(height, height + dy); ++y) {
+        const uint64_t *src = row(y - dy);
+        uint64_t *dst = result.row(y);
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) {
+            uint64_t word = 0;
+            if(dx >= 0) {
+                const int j = i - wordShift;
+                if(j >= 0) { word = src[j] << bitShift; }
+                if(bitShift != 0 && j - 1 >= 0) { word |= src[j - 1] >> (64 - bitShift); }
+            } else {
+                const int j = i + wordShift;
+                if(j < GRID_ROW_WORDS) { word = src[j] >> bitShift; }
+                if(bitShift != 0 && j + 1 < GRID_ROW_WORDS) {
+                    word |= src[j + 1] << (64 - bitShift);
+                }
+            }
+            dst[i] = word;
+        }
+        result.clipRow(dst);
+    }
+    return result;
+}
+
+/**
+ * @brief Grows the set cells by a number of cells in all eight directions.
+ *
+ * Every pass spreads each row horizontally, then ORs every row with its
+ * neighbours above and below.
+ *
+ * @param radius The number of cells to grow by
+ * @return BitGrid& This grid
+ */
+BitGrid &BitGrid::dilate(int radius) {
+    std::vector<uint64_t> spread(words.size());
+    for(int pass = 0; pass < radius && height > 0; ++pass) {
+        for(int y = 0; y < height; ++y) {
+            uint64_t *dst = &spread[static_cast<std::size_t>(y) * GRID_ROW_WORDS];
+            SpreadRow(row(y), dst);
+            clipRow(dst);
+        }
+        std::copy(spread.begin(), spread.end(), words.begin());
+        if(height > 1) {
+            OrWords(words.data(), spread.data() + GRID_ROW_WORDS, words.size() - GRID_ROW_WORDS);
+            OrWords(words.data() + GRID_ROW_WORDS, spread.data(), words.size() - GRID_ROW_WORDS);
+        }
+    }
+    return *this;
+}
+
+/**
+ * @brief Shrinks the set cells by a number of cells in all eight directions.
+ *
+ * Cells outside the grid count as clear, so cells near the border are eroded.
+ *
+ * @param radius The number of cells to shrink by
+ * @return BitGrid& This grid
+ */
+BitGrid &BitGrid::erode(int radius) {
+    // Erosion is the complement of dilating the complement
+    invert();
+    dilate(radius);
+    invert();
+    // Cells within radius of the border touch clear cells outside the grid
+    uint64_t mask[GRID_ROW_WORDS];
+    rectMask(radius, width - 2 * radius, mask);
+    for(int y = 0; y < height; ++y) {
+        uint64_t *cells = row(y);
+        const bool edge = y < radius || y >= height - radius;
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) { cells[i] = edge ? 0 : cells[i] & mask[i]; }
+    }
+    return *this;
+}
+
+/**
+ * @brief Counts the set cells of the grid.
+ *
+ * @return std::size_t The number of set cells
+ */
+std::size_t BitGrid::count() const {
+    std::size_t total = 0;
+    for(const auto word : words) { total += PopCount(word); }
+    return total;
+}
+
+/**
+ * @brief Counts the set cells inside a rectangle.
+ *
+ * @param x The left column of the rectangle
+ * @param y The bottom row of the rectangle
+ * @param w The width of the rectangle
+ * @param h The height of the rectangle
+ * @return std::size_t The number of set cells, cells outside the grid count as clear
+ */
+std::size_t BitGrid::count(int x, int y, int w, int h) const {
+    uint64_t mask[GRID_ROW_WORDS];
+    if(!rectMask(x, w, mask)) { return 0; }
+    std::size_t total = 0;
+    for(int r = std::max(0, y); r < std::min(height, y + h); ++r) {
+        const uint64_t *cells = row(r);
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) { total += PopCount(cells[i] & mask[i]); }
+    }
+    return total;
+}
+
+/**
+ * @brief Checks whether every cell of a footprint is set.
+ *
+ * @param x The left column of the footprint
+ * @param y The bottom row of the footprint
+ * @param w The width of the footprint
+ * @param h The height of the footprint
+ * @return true if the footprint lies inside the grid and all its cells are set
+ */
+bool BitGrid::fits(int x, int y, int w, int h) const {
+    if(x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > width || y + h > height) { return false; }
+    uint64_t mask[GRID_ROW_WORDS];
+    rectMask(x, w, mask);
+    const int first = x >> 6;
+    const int last = (x + w - 1) >> 6;
+    for(int r = y; r < y + h; ++r) {
+        const uint64_t *cells = row(r);
+        for(int i = first; i <= last; ++i) {
+            if((cells[i] & mask[i]) != mask[i]) { return false; }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Checks whether any cell inside a rectangle is set.
+ *
+ * @param x The left column of the rectangle
+ * @param y The bottom row of the rectangle
+ * @param w The width of the rectangle
+ * @param h The height of the rectangle
+ * @return true if at least one cell is set
+ */
+bool BitGrid::any(int x, int y, int w, int h) const {
+    uint64_t mask[GRID_ROW_WORDS];
+    if(!rectMask(x, w, mask)) { return false; }
+    for(int r = std::max(0, y); r < std::min(height, y + h); ++r) {
+        const uint64_t *cells = row(r);
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) {
+            if((cells[i] & mask[i]) != 0) { return true; }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Finds the closest set cell, searching square rings around a cell.
+ *
+ * @param x The column to search from, replaced by the column of the found cell
+ * @param y The row to search from, replaced by the row of the found cell
+ * @param radius The largest ring to search
+ * @return true if a set cell was found, false otherwise
+ */
+bool BitGrid::nearest(int &x, int &y, int radius) const {
+    for(int ring = 0; ring <= radius; ++ring) {
+        for(int dy = -ring; dy <= ring; ++dy) {
+            const int step = (dy == -ring || dy == ring) ? 1 : 2 * ring;
+            for(int dx = -ring; dx <= ring; dx += std::max(step, 1)) {
+                if(get(x + dx, y + dy)) {
+                    x += dx;
+                    y += dy;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Computes the travel distance from a cell to every set cell.
+ *
+ * Runs Dijkstra over the set cells with 8-neighbour moves, diagonal moves may
+ * not cut the corner of a clear cell.
+ *
+ * @param x The column of the source cell
+ * @param y The row of the source cell
+ * @return std::vector<float> The distance of every cell, row by row, infinity
+ * for cells that cannot be reached
+ */
+std::vector<float> BitGrid::distanceField(int x, int y) const {
+    DistanceSearch search;
+    search.start(*this, x, y);
+    search.advance(*this, std::numeric_limits<std::size_t>::max());
+    return std::move(search.distances);
+}
+
+/**
+ * @brief Starts a search from a cell, with every other cell unreached.
+ *
+ * @param grid The grid to search, the same grid must be passed to advance
+ * @param x The column of the source cell
+ * @param y The row of the source cell
+ */
+void DistanceSearch::start(const BitGrid &grid, int x, int y) {
+    distances.assign(static_cast<std::size_t>(grid.width) * grid.height,
+                     std::numeric_limits<float>::infinity());
+    open.clear();
+    if(!grid.get(x, y)) { return; }
+    distances[static_cast<std::size_t>(y) * grid.width + x] = 0.0f;
+    open.push_back(Entry(0.0f, y * grid.width + x));
+}
+
+/**
+ * @brief Continues the search for a bounded number of cells.
+ *
+ * Runs Dijkstra over the set cells with 8-neighbour moves, diagonal moves may
+ * not cut the corner of a clear cell. The open list is kept between calls, so
+ * a search split over several calls gives the same distances as one call.
+ *
+ * @param grid The grid the search was started on
+ * @param cells The number of open cells to expand at most
+ * @return true if the search is done, false if cells are left to expand
+ */
+bool DistanceSearch::advance(const BitGrid &grid, std::size_t cells) {
+    static const int dxs[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+    static const int dys[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+    const float diagonal = std::sqrt(2.0f);
+    const std::greater<Entry> later;
+    for(std::size_t expanded = 0; expanded < cells && !open.empty(); ++expanded) {
+        std::pop_heap(open.begin(), open.end(), later);
+        const Entry entry = open.back();
+        open.pop_back();
+        const int cx = entry.second % grid.width;
+        const int cy = entry.second / grid.width;
+        if(entry.first > distances[entry.second]) { continue; }
+        for(int k = 0; k < 8; ++k) {
+            const int nx = cx + dxs[k];
+            const int ny = cy + dys[k];
+            if(!grid.get(nx, ny)) { continue; }
+            if(k >= 4 && (!grid.get(nx, cy) || !grid.get(cx, ny))) { continue; }
+            const float next = entry.first + (k >= 4 ? diagonal : 1.0f);
+            const int cell = ny * grid.width + nx;
+            if(next < distances[cell]) {
+                distances[cell] = next;
+                open.push_back(Entry(next, cell));
+                std::push_heap(open.begin(), open.end(), later);
+            }
+        }
+    }
+    return open.empty();
+}
+
+/**
+ * @brief Clears the bits of a row at or beyond the width of the grid.
+ *
+ * @param row The row to clip
+ */
+void BitGrid::clipRow(uint64_t *row) const {
+    for(int i = 0; i < GRID_ROW_WORDS; ++i) { row[i] &= tail[i]; }
+}
+
+/**
+ * @brief Builds the per-word column mask of a rectangle, clipped to the grid.
+ *
+ * @param x The left column of the rectangle
+ * @param w The width of the rectangle
+ * @param mask The column mask of every word of a row
+ * @return true if the rectangle covers at least one column of the grid
+ */
+bool BitGrid::rectMask(int x, int w, uint64_t mask[GRID_ROW_WORDS]) const {
+    const int begin = std::max(0, x);
+    const int end = std::min(width, x + w);
+    for(int i = 0; i < GRID_ROW_WORDS; ++i) {
+        const int low = std::max(begin - i * 64, 0);
+        const int high = std::min(end - i * 64, 64);
+        if(low >= high) {
+            mask[i] = 0;
+        } else {
+            const uint64_t upper = high == 64 ? ~0ULL : ((1ULL << high) - 1);
+            mask[i] = upper & ~((1ULL << low) - 1);
+        }
+    }
+    return begin < end;
+}
+
+/**
+ * @brief Views an 8-bit image in place.
+ *
+ * @param data The pixels, one byte each, must outlive the view
+ * @param width The width of the image
+ * @param height The height of the image
+ */
+HeightMap::HeightMap(const std::string &data, int width, int height) {
+    if(data.size() >= static_cast<std::size_t>(width) * height) {
+        this->width = width;
+        this->height = height;
+        cells = reinterpret_cast<const uint8_t *>(data.data());
+    }
+}
+
+/**
+ * @brief Gets the raw value of a cell.
+ *
+ * @param x The column of the cell
+ * @param y The row of the cell
+ * @return uint8_t The value, 0 outside the map
+ */
+uint8_t HeightMap::at(int x, int y) const {
+    if(x < 0 || y < 0 || x >= width || y >= height) { return 0; }
+    return cells[static_cast<std::size_t>(y) * width + x];
+}
+
+/**
+ * @brief Gets the terrain height of a cell in world units.
+ *
+ * @param x The column of the cell
+ * @param y The row of the cell
+ * @return float The height, the raw values map -16 to 16 onto 0 to 255
+ */
+float HeightMap::terrainHeight(int x, int y) const { return -16.0f + 32.0f * at(x, y) / 255.0f; }
+
+/**
+ * @brief Selects every cell whose value lies in a range.
+ *
+ * Useful to find the cells on one height level, e.g. the main base plateau.
+ *
+ * @param low The lowest value to select
+ * @param high The highest value to select
+ * @return BitGrid A grid with the selected cells set
+ */
+BitGrid HeightMap::band(uint8_t low, uint8_t high) const {
+    BitGrid grid(width, height);
+    for(int y = 0; y < height; ++y) {
+        const uint8_t *src = cells + static_cast<std::size_t>(y) * width;
+        uint64_t *row = grid.row(y);
+        int x = 0;
+#if defined(GRID_AVX2) || defined(GRID_SSE2)
+        // low <= v <= high as unsigned bytes: max(v, low) == v and min(v, high) == v
+        const __m128i lo = _mm_set1_epi8(static_cast<char>(low));
+        const __m128i hi = _mm_set1_epi8(static_cast<char>(high));
+        for(; x + 16 <= width; x += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + x));
+            const __m128i in = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(v, lo), v),
+                                             _mm_cmpeq_epi8(_mm_min_epu8(v, hi), v));
+            const uint64_t bits = static_cast<uint32_t>(_mm_movemask_epi8(in));
+            row[x >> 6] |= bits << (x & 63);
+        }
+#endif
+        for(; x < width; ++x) {
+            const bool in = src[x] >= low && src[x] <= high;
+            row[x >> 6] |= static_cast<uint64_t>(in) << (x & 63);
+        }
+    }
+    return grid;
+}
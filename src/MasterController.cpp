@@ -13,39 +13,54 @@ MasterController::MasterController(OnPhone &bot)
 void MasterController::addUnitGroup(UnitGroup unitGroup) { unitGroups.push_back(unitGroup); }
 
 /**
- * @brief Steps the master controller
+ * @brief Steps the unit groups of one role
  *
- * This function steps the master controller by iterating through all unit groups
- * and executing the base step for each unit in the group.
+ * This function steps the master controller by iterating through the unit groups
+ * of a role and executing the base step for each unit in the group that its controller
+ * considers awake, so sleeping workers and scouts cost no controller work.
+ * Dead units are dropped from their group without allocating. Roles are stepped
+ * separately so the step budget can defer the less urgent ones.
+ *
+ * @param role The role of the groups to step
  */
-void MasterController::step() {
+void MasterController::step(ROLE role) {
     for(auto &unitGroup : this->unitGroups) {
+        if(unitGroup.unitRole != role) { continue; }
         switch(unitGroup.unitRole) {
         case ROLE::ATTACK:
+            attack_controller.groupSquads(unitGroup);
             if(attack_controller.isAttacking) {
-                attack_controller.getMostDangerous();
+                attack_controller.getMostDangerous(*bot.pool);
                 unitGroup.unitTask = TASK::ATTACK;
             }
             break;
-        case ROLE::WORKER: worker_controller.getMostDangerous(); break;
+        case ROLE::WORKER: worker_controller.getMostDangerous(*bot.pool); break;
         default: break;
         }
-        std::vector<AllyUnit> new_units;
-        for(auto &unit : unitGroup.units) {
+        // Survivors are compacted in place, so the group never reallocates
+        std::size_t kept = 0;
+        for(std::size_t i = 0; i < unitGroup.units.size(); ++i) {
+            AllyUnit &unit = unitGroup.units[i];
             if(unit.unit != nullptr && unit.unit->is_alive && unit.unit->health > 0) {
-                if(unitGroup.unitTask != TASK::UNSET) {
+                if(unitGroup.unitTask != TASK::UNSET && unit.unitTask != unitGroup.unitTask) {
                     unit.unitTask = unitGroup.unitTask; // Done this way so if we want to override
                                                         // group tasks, currently temporary
+                    bot.events.wake(unit.unit->tag, EventDispatcher::TASK_CHANGED);
                 }
                 switch(unitGroup.unitRole) {
-                case ROLE::SCOUT: scout_controller.base_step(unit); break;
-                case ROLE::ATTACK: attack_controller.base_step(unit); break;
-                case ROLE::WORKER: worker_controller.base_step(unit); break;
+                case ROLE::SCOUT:
+                    if(scout_controller.awake(unit)) { scout_controller.base_step(unit); }
+                    break;
+                case ROLE::ATTACK:
+                    if(attack_controller.awake(unit)) { attack_controller.base_step(unit); }
+                    break;
+                case ROLE::WORKER:
+                    if(worker_controller.awake(unit)) { worker_controller.base_step(unit); }
+                    break;
                 default: break;
                 }
-                unit.priorHealth = unit.unit->health;
-                unit.priorPos = unit.unit->pos;
-                new_units.push_back(unit);
+                if(kept != i) { unitGroup.units[kept] = unit; }
+                ++kept;
             } else {
                 unit.unit = nullptr;
                 switch(unitGroup.unitRole) {
@@ -56,6 +71,21 @@ void MasterController::step() {
                 }
             }
         }
-        unitGroup.units = new_units;
+        unitGroup.units.erase(unitGroup.units.begin() + kept, unitGroup.units.end());
+        if(unitGroup.unitRole == ROLE::ATTACK) { attack_controller.command(*bot.pool); }
+    }
+}
+
+/**
+ * @brief Keeps the wake-ups of the units of a role whose step was deferred.
+ *
+ * @param role The role of the groups that were not stepped
+ */
+void MasterController::postpone(ROLE role) {
+    for(const auto &unitGroup : this->unitGroups) {
+        if(unitGroup.unitRole != role) { continue; }
+        for(const auto &unit : unitGroup.units) {
+            if(unit.unit != nullptr) { bot.events.postpone(unit.unit->tag); }
+        }
     }
-};
\ No newline at end of file
+}
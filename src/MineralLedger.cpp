@@ -0,0 +1,108 @@
+#include "MineralLedger.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace sc2;
+
+/**
+ * @brief Counts the drones gathering from every mineral field.
+ *
+ * Called once per step, the containers keep their capacity so a step
+ * allocates nothing once the counts of the first steps were built.
+ *
+ * @param minerals The mineable mineral fields
+ * @param drones The drones, their gather orders are counted
+ */
+void MineralLedger::reset(const Units &minerals, const Units &drones) {
+    this->minerals = minerals;
+    positions.assign(minerals);
+    counts.assign(minerals.size(), 0);
+    distances.resize(minerals.size());
+    fieldIndex.clear();
+    for(std::size_t i = 0; i < minerals.size(); ++i) {
+        fieldIndex.push_back({minerals[i]->tag, i});
+    }
+    std::sort(fieldIndex.begin(), fieldIndex.end());
+    counted.clear();
+    for(const auto *drone : drones) {
+        if(drone->orders.empty()
+           || drone->orders.front().ability_id != ABILITY_ID::HARVEST_GATHER) {
+            continue;
+        }
+        const std::size_t field = fieldOf(drone->orders.front().target_unit_tag);
+        if(field == GEOMETRY_NONE) { continue; }
+        ++counts[field];
+        counted.push_back({drone->tag, field});
+    }
+    std::sort(counted.begin(), counted.end());
+}
+
+/**
+ * @brief Picks the mineral field of a base with the fewest drones gathering from it.
+ *
+ * Ties go to the field closest to the town hall.
+ *
+ * @param worker The drone to pick a mineral for, it is not counted on its own field
+ * @param hall The position of the town hall of the base
+ * @return std::size_t The index of the field, GEOMETRY_NONE if none is within CLUSTER_DISTANCE
+ */
+std::size_t MineralLedger::pick(const Unit *worker, const Point2D &hall) {
+    auto own = countedOn(worker->tag);
+    const std::size_t current = own == counted.end() ? GEOMETRY_NONE : own->second;
+    DistancesSquared(positions, hall, distances.data());
+    std::size_t best = GEOMETRY_NONE;
+    int fewest = std::numeric_limits<int>::max();
+    float closest = std::numeric_limits<float>::max();
+    for(std::size_t i = 0; i < minerals.size(); ++i) {
+        const float distance = distances[i];
+        if(distance > CLUSTER_DISTANCE * CLUSTER_DISTANCE) { continue; }
+        const int count = counts[i] - (i == current ? 1 : 0);
+        if(count < fewest || (count == fewest && distance < closest)) {
+            fewest = count;
+            closest = distance;
+            best = i;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Counts a drone on the field it was sent to instead of its old field.
+ *
+ * @param worker The drone
+ * @param field The index of the field it was sent to
+ */
+void MineralLedger::assign(const Unit *worker, std::size_t field) {
+    auto own = countedOn(worker->tag);
+    if(own != counted.end()) {
+        --counts[own->second];
+        own->second = field;
+    } else {
+        const Entry entry(worker->tag, field);
+        counted.insert(std::lower_bound(counted.begin(), counted.end(), entry), entry);
+    }
+    ++counts[field];
+}
+
+/**
+ * @brief Finds a mineral field by tag.
+ *
+ * @param mineral The tag of the field
+ * @return std::size_t The index of the field, GEOMETRY_NONE if it is not mineable
+ */
+std::size_t MineralLedger::fieldOf(Tag mineral) const {
+    auto it = std::lower_bound(fieldIndex.begin(), fieldIndex.end(), Entry(mineral, 0));
+    return it != fieldIndex.end() && it->first == mineral ? it->second : GEOMETRY_NONE;
+}
+
+/**
+ * @brief Finds the entry of a drone.
+ *
+ * @param drone The tag of the drone
+ * @return std::vector<Entry>::iterator The entry, end if the drone is not counted on a field
+ */
+std::vector<MineralLedger::Entry>::iterator MineralLedger::countedOn(Tag drone) {
+    auto it = std::lower_bound(counted.begin(), counted.end(), Entry(drone, 0));
+    return it != counted.end() && it->first == drone ? it : counted.end();
+}
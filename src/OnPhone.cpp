@@ -1,11 +1,21 @@
 #include "OnPhone.h"
 #include "MasterController.h"
 
+#include <chrono>
 #include <cstddef>
-#include <iostream>
+#include <cstdlib>
 #include <limits>
+#include <thread>
 
-OnPhone::OnPhone() : controller(*this) {};
+static const char *const OPENING_NAMES[] = {"roach", "ling flood", "hatch first"};
+
+OnPhone::OnPhone() : controller(*this), saturation(*this), dispatcher(*this) {
+    buildTask = budget.add("build order", StepBudget::HIGH, 0.5f);
+    armyTask = budget.add("army", StepBudget::HIGH, 2.0f);
+    workerTask = budget.add("workers", StepBudget::NORMAL, 1.0f);
+    scoutTask = budget.add("scouts", StepBudget::LOW, 0.5f);
+    analysisTask = budget.add("flow fields", StepBudget::LOW, 0.5f);
+};
 
 /**
  * @brief Initializes the build order for the Zerg bot.
@@ -13,16 +23,58 @@ OnPhone::OnPhone() : controller(*this) {};
  * This function is called at the start of the game and sets up the initial
  * build order for the Zerg bot. It defines a sequence of actions to be
  * executed at specific supply counts, including:
- * - Building drones, overlords, and other structures
+ * - Building drones and structures
  * - Producing combat units like zerglings and roaches
  * - Researching upgrades
+ *
+ * The opening is picked from the results of earlier games against the same
+ * opponent, read from the opponent history in ONPHONE_DATA_DIR.
  */
 void OnPhone::OnGameStart() {
     const auto &gameInfo = Observation()->GetGameInfo();
+    enemyMemory.initialize(gameInfo, Observation()->GetUnitTypeData());
+    pathingGrid = BitGrid::fromImage(gameInfo.pathing_grid);
+    placementGrid = BitGrid::fromImage(gameInfo.placement_grid);
+    heightMap = HeightMap::fromImage(gameInfo.terrain_height);
+    controller.scout_controller.scheduler.initialize(gameInfo.width, gameInfo.height);
+    controller.attack_controller.squads.initialize(gameInfo.width, gameInfo.height);
+    tasks.clear();
+    metabolicBoostQueued = false;
+    metabolicBoostStarted = false;
     startLoc = Observation()->GetStartLocation();
-    std::cout << "Start location: (" << startLoc.x << ", " << startLoc.y << ")\n";
+    LOG_INFO("Start location: (%g, %g)", startLoc.x, startLoc.y);
     mapCenter = (gameInfo.playable_min + gameInfo.playable_max) * 0.5f;
-    std::cout << "Map center: (" << mapCenter.x << ", " << mapCenter.y << ")\n";
+    LOG_INFO("Map center: (%g, %g)", mapCenter.x, mapCenter.y);
+    if(const char *ceiling = std::getenv("ONPHONE_STEP_BUDGET_MS")) {
+        const float ms = std::strtof(ceiling, nullptr);
+        if(ms > 0.0f) {
+            budget.ceiling = ms;
+        } else {
+            LOG_WARN("Ignoring ONPHONE_STEP_BUDGET_MS, not a positive number of milliseconds");
+        }
+    }
+    LOG_INFO("Step budget: %g ms", budget.ceiling);
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    if(const char *count = std::getenv("ONPHONE_THREADS")) {
+        const long value = std::strtol(count, nullptr, 10);
+        if(value > 0) {
+            threads = static_cast<unsigned>(value);
+        } else {
+            LOG_WARN("Ignoring ONPHONE_THREADS, not a positive number of threads");
+        }
+    }
+    pool.reset(new ThreadPool(threads));
+    LOG_INFO("Thread pool: %u workers", pool->size());
+
+    std::vector<Point2D> keyPoints = FindResourceClusters(Observation()->GetUnits(
+      Unit::Alliance::Neutral, [](const Unit &unit) { return IsResource(unit); }));
+    keyPoints.push_back(startLoc);
+    keyPoints.insert(keyPoints.end(), gameInfo.enemy_start_locations.begin(),
+                     gameInfo.enemy_start_locations.end());
+    keyPoints.push_back(mapCenter);
+    baseDistances = DistanceMatrix::ground(keyPoints, pathingGrid);
+    LOG_INFO("Ground distances between %zu key points", keyPoints.size());
+
     top = startLoc.y > mapCenter.y;
     right = startLoc.x > mapCenter.x;
     std::size_t enemyLocationCount = Observation()->GetGameInfo().enemy_start_locations.size();
@@ -44,29 +96,115 @@ void OnPhone::OnGameStart() {
 
     constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)].push_back(
       Observation()->GetUnits(Unit::Alliance::Self, IsUnit(UNIT_TYPEID::ZERG_HATCHERY))[0]);
-    buildOrder.push_back({13, std::bind(&OnPhone::BuildOverlord, this)});
-    buildOrder.push_back({16, std::bind(&OnPhone::BuildExtractor, this)});
-    buildOrder.push_back({16, std::bind(&OnPhone::BuildSpawningPool, this)});
-    buildOrder.push_back({17, std::bind(&OnPhone::BuildHatchery, this)});
-    for(int i = 0; i < 3; ++i) {
-        buildOrder.push_back({16, std::bind(&OnPhone::BuildZergling, this)});
-    }
-    buildOrder.push_back({19, std::bind(&OnPhone::BuildQueen, this)});
-    buildOrder.push_back({21, std::bind(&OnPhone::BuildRoachWarren, this)});
-    buildOrder.push_back({21, std::bind(&OnPhone::ResearchMetabolicBoost, this)});
-    buildOrder.push_back({21, std::bind(&OnPhone::BuildOverlord, this)});
-    for(int i = 0; i < 4; ++i) {
-        buildOrder.push_back({21, std::bind(&OnPhone::BuildRoach, this)});
+    injects.addHatchery(constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)][0],
+                        Observation()->GetGameLoop());
+
+    const char *directory = std::getenv("ONPHONE_DATA_DIR");
+    if(!opponents.open(directory != nullptr ? directory : OPPONENT_DEFAULT_DIR)) {
+        LOG_WARN("Could not read the opponent history");
     }
-    buildOrder.push_back({29, std::bind(&OnPhone::BuildOverlord, this)});
-    for(int i = 0; i < 5; ++i) {
-        buildOrder.push_back({29, std::bind(&OnPhone::BuildZergling, this)});
+    const auto started = std::chrono::steady_clock::now();
+    game.opponent = OpponentStore::hash(opponentId);
+    const OPENING opening = opponents.choose(game.opponent);
+    const auto chosen = std::chrono::steady_clock::now();
+    game.opening = static_cast<uint8_t>(opening);
+    uint32_t played = 0;
+    for(const auto &stats : opponents.history(game.opponent)) { played += stats.games; }
+    LOG_INFO("Opening %s against an opponent with %u games on record, chosen in %lld us",
+             OPENING_NAMES[game.opening], played,
+             static_cast<long long>(
+               std::chrono::duration_cast<std::chrono::microseconds>(chosen - started).count()));
+    if(opponents.damaged > 0) {
+        LOG_WARN("Skipped %zu damaged opponent records", opponents.damaged);
     }
-    buildOrder.push_back({34, std::bind(&OnPhone::BuildRavager, this)});
-    for(int i = 0; i < 5; ++i) {
-        buildOrder.push_back({29, std::bind(&OnPhone::BuildZergling, this)});
+    QueueOpening(opening);
+}
+
+/**
+ * @brief Queues the build order of an opening.
+ *
+ * @param opening The opening picked for this game
+ */
+void OnPhone::QueueOpening(OPENING opening) {
+    switch(opening) {
+    case OPENING::LING_FLOOD:
+        buildOrder.push_back({14, std::bind(&OnPhone::BuildSpawningPool, this),
+                              SPAWNINGPOOL_COST, 0, true});
+        buildOrder.push_back({15, std::bind(&OnPhone::BuildExtractor, this), EXTRACTOR_COST, 0,
+                              true});
+        for(int i = 0; i < 3; ++i) {
+            buildOrder.push_back({15, std::bind(&OnPhone::BuildZergling, this),
+                                  ZERGLING_MINERAL_COST});
+        }
+        buildOrder.push_back({18, std::bind(&OnPhone::ResearchMetabolicBoost, this),
+                              METABOLIC_BOOST_COST, METABOLIC_BOOST_COST});
+        buildOrder.push_back({18, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
+        buildOrder.push_back({18, std::bind(&OnPhone::BuildHatchery, this), HATCHERY_COST, 0,
+                              true});
+        for(int i = 0; i < 10; ++i) {
+            buildOrder.push_back({20, std::bind(&OnPhone::BuildZergling, this),
+                                  ZERGLING_MINERAL_COST});
+        }
+        buildOrder.push_back({26, std::bind(&OnPhone::BuildRoachWarren, this),
+                              ROACHWARREN_COST, 0, true});
+        buildOrder.push_back({26, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
+        break;
+    case OPENING::HATCH_FIRST:
+        buildOrder.push_back({16, std::bind(&OnPhone::BuildHatchery, this), HATCHERY_COST, 0,
+                              true});
+        buildOrder.push_back({17, std::bind(&OnPhone::BuildExtractor, this), EXTRACTOR_COST, 0,
+                              true});
+        buildOrder.push_back({17, std::bind(&OnPhone::BuildSpawningPool, this),
+                              SPAWNINGPOOL_COST, 0, true});
+        for(int i = 0; i < 2; ++i) {
+            buildOrder.push_back({19, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
+        }
+        buildOrder.push_back({21, std::bind(&OnPhone::BuildZergling, this),
+                              ZERGLING_MINERAL_COST});
+        buildOrder.push_back({24, std::bind(&OnPhone::ResearchMetabolicBoost, this),
+                              METABOLIC_BOOST_COST, METABOLIC_BOOST_COST});
+        buildOrder.push_back({28, std::bind(&OnPhone::BuildRoachWarren, this),
+                              ROACHWARREN_COST, 0, true});
+        for(int i = 0; i < 6; ++i) {
+            buildOrder.push_back({30, std::bind(&OnPhone::BuildRoach, this),
+                                  ROACH_MINERAL_COST, ROACH_VESPENE_COST});
+        }
+        buildOrder.push_back({40, std::bind(&OnPhone::BuildRavager, this),
+                              RAVAGER_MINERAL_COST, RAVAGER_VESPENE_COST});
+        break;
+    default:
+        buildOrder.push_back({16, std::bind(&OnPhone::BuildExtractor, this), EXTRACTOR_COST, 0,
+                              true});
+        buildOrder.push_back({16, std::bind(&OnPhone::BuildSpawningPool, this),
+                              SPAWNINGPOOL_COST, 0, true});
+        buildOrder.push_back({17, std::bind(&OnPhone::BuildHatchery, this), HATCHERY_COST, 0,
+                              true});
+        for(int i = 0; i < 3; ++i) {
+            buildOrder.push_back({16, std::bind(&OnPhone::BuildZergling, this),
+                                  ZERGLING_MINERAL_COST});
+        }
+        buildOrder.push_back({19, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
+        buildOrder.push_back({21, std::bind(&OnPhone::BuildRoachWarren, this),
+                              ROACHWARREN_COST, 0, true});
+        buildOrder.push_back({21, std::bind(&OnPhone::ResearchMetabolicBoost, this),
+                              METABOLIC_BOOST_COST, METABOLIC_BOOST_COST});
+        for(int i = 0; i < 4; ++i) {
+            buildOrder.push_back({21, std::bind(&OnPhone::BuildRoach, this),
+                                  ROACH_MINERAL_COST, ROACH_VESPENE_COST});
+        }
+        for(int i = 0; i < 5; ++i) {
+            buildOrder.push_back({29, std::bind(&OnPhone::BuildZergling, this),
+                                  ZERGLING_MINERAL_COST});
+        }
+        buildOrder.push_back({34, std::bind(&OnPhone::BuildRavager, this),
+                              RAVAGER_MINERAL_COST, RAVAGER_VESPENE_COST});
+        for(int i = 0; i < 5; ++i) {
+            buildOrder.push_back({29, std::bind(&OnPhone::BuildZergling, this),
+                                  ZERGLING_MINERAL_COST});
+        }
+        buildOrder.push_back({19, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
+        break;
     }
-    buildOrder.push_back({19, std::bind(&OnPhone::BuildQueen, this)});
 }
 
 /**
@@ -75,11 +213,95 @@ void OnPhone::OnGameStart() {
  * This function is called on every game step and is responsible for
  * executing the current build order. It ensures that the bot continuously
  * progresses through its planned strategy by calling ExecuteBuildOrder().
+ * The frame delta and enemy memory are refreshed first and the queued unit
+ * wake-ups are dispatched so controllers only react to changes, the income
+ * forecast is updated, and economic telemetry is sampled every
+ * TELEMETRY_INTERVAL game loops. The rest of the step runs through the step
+ * budget: the build order and the army always run unless the step is already
+ * over its ceiling, while workers, scouts and flow field building are deferred
+ * to later steps when the budget runs low. Deferred units keep their wake-ups.
+ * Workers are rebalanced over the bases and queen injects are issued on the game
+ * loop they become possible. Temporary containers of the step live in the frame
+ * arena, which is reset first. The units are fetched once and shared by the
+ * subsystems. The actions of the step are counted at its end.
  */
 void OnPhone::OnStep() {
+    budget.begin();
+    arena.reset();
+    const uint64_t heapCalls = HeapAllocations();
+    const ObservationInterface *observation = Observation();
+    FetchUnits(observation);
+    frameDelta.update(selfUnits, observation->GetGameLoop());
+    for(const auto tag : frameDelta.damaged) { events.wake(tag, EventDispatcher::DAMAGED); }
+    events.dispatch();
+    income.update(observation, selfUnits);
+    telemetry.countSupply(observation->GetGameLoop(), observation->GetFoodUsed(),
+                          observation->GetFoodCap());
+    if(telemetry.due(observation->GetGameLoop())) {
+        const int bases = static_cast<int>(
+          constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)].size());
+        telemetry.sample(observation, bases, income.mineralRate());
+    }
+    enemyMemory.update(enemyUnits, observation->GetGameLoop());
+    RecordOpponent(observation->GetGameLoop());
     GetEnemyUnitLocations();
-    ExecuteBuildOrder();
-    this->controller.step();
+    tasks.resume(observation->GetGameLoop());
+    budget.run(buildTask, [this] {
+        AdaptBuildOrder();
+        ExecuteBuildOrder();
+        dispatcher.update();
+    });
+    if(!budget.run(armyTask, [this] { controller.step(ROLE::ATTACK); })) {
+        controller.postpone(ROLE::ATTACK);
+    }
+    const bool workers = budget.run(workerTask, [this] {
+        saturation.update();
+        controller.step(ROLE::WORKER);
+    });
+    if(!workers) { controller.postpone(ROLE::WORKER); }
+    controller.step(ROLE::INTERMEDIATE);
+    // After the controllers, so an inject overrides any order given to the queen this step
+    injects.step(observation->GetGameLoop(), Actions());
+    if(!budget.run(scoutTask, [this, observation] {
+           controller.scout_controller.scheduler.update(observation);
+           controller.step(ROLE::SCOUT);
+       })) {
+        controller.postpone(ROLE::SCOUT);
+    }
+    if(flowFields.pending()) {
+        budget.slice(analysisTask,
+                     [this] { return flowFields.build(pathingGrid, FLOW_SLICE_CELLS); });
+    }
+    // At the end, the commands of the step stay buffered until they are sent after OnStep
+    const std::size_t actions = Actions()->Commands().size();
+    telemetry.countActions(actions);
+    if(controller.attack_controller.takeSent() > 0 && actions == 0) {
+        LOG_WARN("Squad commands were sent but no actions were counted");
+    }
+    arena.endStep(HeapAllocations() - heapCalls);
+    budget.end();
+}
+
+/**
+ * @brief Splits the units of the step by alliance.
+ *
+ * GetUnits returns a new list on every call, so the units are fetched once per
+ * step and copied into lists whose capacity is kept between steps.
+ *
+ * @param observation The current observation
+ */
+void OnPhone::FetchUnits(const ObservationInterface *observation) {
+    selfUnits.clear();
+    enemyUnits.clear();
+    neutralUnits.clear();
+    for(const auto *unit : observation->GetUnits()) {
+        switch(unit->alliance) {
+        case Unit::Alliance::Self: selfUnits.push_back(unit); break;
+        case Unit::Alliance::Enemy: enemyUnits.push_back(unit); break;
+        case Unit::Alliance::Neutral: neutralUnits.push_back(unit); break;
+        default: break;
+        }
+    }
 }
 
 /**
@@ -92,6 +314,7 @@ void OnPhone::OnStep() {
  * @param unit Pointer to the destroyed unit
  */
 void OnPhone::OnUnitDestroyed(const Unit *unit) {
+    if(unit->alliance == Unit::Alliance::Enemy) { enemyMemory.forget(unit->tag); }
     if((unit->alliance == Unit::Alliance::Enemy)
        && (unit->unit_type == UNIT_TYPEID::TERRAN_COMMANDCENTER
            || unit->unit_type == UNIT_TYPEID::PROTOSS_NEXUS
@@ -101,49 +324,99 @@ void OnPhone::OnUnitDestroyed(const Unit *unit) {
         controller.scout_controller.foundEnemyLocation.x = 0;
         controller.scout_controller.foundEnemyLocation.y = 0;
     } else if(unit->alliance != Unit::Alliance::Enemy) {
+        controller.scout_controller.release(unit->tag);
+        injects.remove(unit->tag, Observation()->GetGameLoop());
+        if(IsResource(*unit)) { saturation.markDirty(); }
         switch(unit->unit_type.ToType()) {
         case UNIT_TYPEID::ZERG_ZERGLING:
-            buildOrder.push_back({0, std::bind(&OnPhone::BuildZergling, this)});
+            buildOrder.push_back({0, std::bind(&OnPhone::BuildZergling, this),
+                                  ZERGLING_MINERAL_COST});
             break;
         case UNIT_TYPEID::ZERG_ROACH:
-            buildOrder.push_back({0, std::bind(&OnPhone::BuildRoach, this)});
+            buildOrder.push_back({0, std::bind(&OnPhone::BuildRoach, this),
+                                  ROACH_MINERAL_COST, ROACH_VESPENE_COST});
             break;
         case UNIT_TYPEID::ZERG_RAVAGER:
-            buildOrder.push_back({0, std::bind(&OnPhone::BuildRoach, this)});
-            buildOrder.push_back({0, std::bind(&OnPhone::BuildRavager, this)});
+            buildOrder.push_back({0, std::bind(&OnPhone::BuildRoach, this),
+                                  ROACH_MINERAL_COST, ROACH_VESPENE_COST});
+            buildOrder.push_back({0, std::bind(&OnPhone::BuildRavager, this),
+                                  RAVAGER_MINERAL_COST, RAVAGER_VESPENE_COST});
             break;
         case UNIT_TYPEID::ZERG_QUEEN:
-            buildOrder.push_back({0, std::bind(&OnPhone::BuildQueen, this)});
+            buildOrder.push_back({0, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
             break;
         case UNIT_TYPEID::ZERG_EXTRACTOR:
             OnBuildingDestruction(unit);
-            buildOrder.push_front({0, std::bind(&OnPhone::BuildExtractor, this)});
+            buildOrder.push_front({0, std::bind(&OnPhone::BuildExtractor, this),
+                                   EXTRACTOR_COST, 0, true});
             break;
         case UNIT_TYPEID::ZERG_HATCHERY:
+            supply.hatcheryFinished(unit->tag);
             OnBuildingDestruction(unit);
-            buildOrder.push_front({0, std::bind(&OnPhone::BuildHatchery, this)});
+            buildOrder.push_front({0, std::bind(&OnPhone::BuildHatchery, this),
+                                   HATCHERY_COST, 0, true});
             break;
         case UNIT_TYPEID::ZERG_SPAWNINGPOOL:
             OnBuildingDestruction(unit);
-            buildOrder.push_front({0, std::bind(&OnPhone::BuildSpawningPool, this)});
+            buildOrder.push_front({0, std::bind(&OnPhone::BuildSpawningPool, this),
+                                   SPAWNINGPOOL_COST, 0, true});
             break;
         default: break;
         }
     }
 }
 
+/**
+ * @brief Handles enemy units entering vision.
+ *
+ * Records the sighting in the enemy memory so new structures are remembered
+ * as soon as they are seen.
+ *
+ * @param unit Pointer to the unit that entered vision
+ */
+void OnPhone::OnUnitEnterVision(const Unit *unit) {
+    enemyMemory.see(*unit, Observation()->GetGameLoop());
+    if(unit->alliance == Unit::Alliance::Enemy && IsBuilding(*unit)) {
+        events.broadcast(EventDispatcher::ENEMY_SEEN);
+    }
+}
+
+/**
+ * @brief Handles units becoming idle.
+ *
+ * Wakes the unit so its controller can give it new orders on the next step.
+ *
+ * @param unit Pointer to the idle unit
+ */
+void OnPhone::OnUnitIdle(const Unit *unit) { events.wake(unit->tag, EventDispatcher::IDLE); }
+
+/**
+ * @brief Handles upgrade completion events.
+ *
+ * Wakes every unit whose controller subscribes to upgrades.
+ *
+ * @param upgrade The completed upgrade
+ */
+void OnPhone::OnUpgradeCompleted(UpgradeID upgrade) {
+    LOG_INFO("Upgrade completed: %u", static_cast<uint32_t>(upgrade));
+    events.broadcast(EventDispatcher::UPGRADED);
+}
+
 /**
  * @brief Handles unit creation events.
  *
  * This function is called whenever a new unit is created. It checks the type
  * of the created unit and performs specific actions based on the unit type.
+ * The unit is woken so its controller gives it orders on the next step.
  *
  * @param unit Pointer to the newly created unit.
  */
 void OnPhone::OnUnitCreated(const Unit *unit) {
+    events.wake(unit->tag, EventDispatcher::CREATED);
     switch(unit->unit_type.ToType()) {
     case UNIT_TYPEID::ZERG_QUEEN: {
         this->Workers->addUnit(AllyUnit(unit, TASK::UNSET, this->Workers));
+        injects.addQueen(unit, Observation()->GetGameLoop());
         break;
     }
     case UNIT_TYPEID::ZERG_DRONE: {
@@ -156,6 +429,11 @@ void OnPhone::OnUnitCreated(const Unit *unit) {
     }
     case UNIT_TYPEID::ZERG_OVERLORD: {
         this->Scouts->addUnit(AllyUnit(unit, TASK::SCOUT, this->Scouts));
+        supply.overlordCreated();
+        break;
+    }
+    case UNIT_TYPEID::ZERG_HATCHERY: {
+        supply.hatcheryStarted(unit, Observation()->GetGameLoop());
         break;
     }
     case UNIT_TYPEID::ZERG_ZERGLING:
@@ -179,14 +457,20 @@ void OnPhone::OnUnitCreated(const Unit *unit) {
  *
  * This function is called whenever a building finishes construction. It adds the
  * completed building to the appropriate tracking container and performs specific
- * actions based on the building type. For extractors, it automatically assigns
- * workers to harvest from them.
+ * actions based on the building type. Finished extractors and hatcheries make the
+ * workers rebalance, and hatcheries are paired with a queen to inject them and
+ * no longer count as supply in progress.
  *
  * @param unit Pointer to the newly constructed building.
  */
 void OnPhone::OnBuildingConstructionComplete(const Unit *unit) {
     constructedBuildings[GetBuildingIndex(unit->unit_type)].push_back(unit);
-    if(unit->unit_type == UNIT_TYPEID::ZERG_EXTRACTOR) { AssignWorkersToExtractor(unit); }
+    if(unit->unit_type == UNIT_TYPEID::ZERG_EXTRACTOR) { saturation.markDirty(); }
+    if(unit->unit_type == UNIT_TYPEID::ZERG_HATCHERY) {
+        supply.hatcheryFinished(unit->tag);
+        injects.addHatchery(unit, Observation()->GetGameLoop());
+        saturation.markDirty();
+    }
 }
 
 /**
@@ -198,6 +482,7 @@ void OnPhone::OnBuildingConstructionComplete(const Unit *unit) {
  * @param unit Pointer to the destroyed building.
  */
 void OnPhone::OnBuildingDestruction(const Unit *unit) {
+    saturation.markDirty();
     for(auto it = constructedBuildings[GetBuildingIndex(unit->unit_type)].begin();
         it != constructedBuildings[GetBuildingIndex(unit->unit_type)].end(); ++it) {
         if((*it)->tag == unit->tag) {
@@ -217,83 +502,101 @@ void OnPhone::OnBuildingDestruction(const Unit *unit) {
  * to build a Drone instead.
  *
  * This method ensures continuous unit production by defaulting to Drone
- * construction when the build order cannot be followed.
+ * construction when the build order cannot be followed. Overlords come first:
+ * while the supply planner asks for one, nothing else is started on the step
+ * it is sent or while idle larva wait for its cost to be banked within
+ * SUPPLY_SAVE_LOOPS. Otherwise the build order goes on without it.
  */
 void OnPhone::ExecuteBuildOrder() {
     const int currentSupply = Observation()->GetFoodUsed();
     const int maxSupply = Observation()->GetFoodCap();
-
-    if(controller.attack_controller.isAttacking && currentSupply >= maxSupply - 4) {
-        Units overlords_queued
-          = Observation()->GetUnits(Unit::Alliance::Self, [](const Unit &unit) {
-                return (unit.unit_type == UNIT_TYPEID::ZERG_LARVA && !unit.orders.empty()
-                        && unit.orders.front().ability_id == ABILITY_ID::TRAIN_OVERLORD)
-                       || (unit.unit_type == UNIT_TYPEID::ZERG_EGG && !unit.orders.empty()
-                           && unit.orders.front().ability_id == ABILITY_ID::TRAIN_OVERLORD);
-            });
-
-        if(overlords_queued.empty()) { BuildOverlord(); }
+    const int bases = static_cast<int>(
+      constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)].size());
+
+    if(supply.needed(Observation()->GetGameLoop(), currentSupply, maxSupply, bases,
+                     static_cast<int>(injects.injecting()), income)
+       > 0) {
+        // One per step, the larva only shows its order on the next observation
+        if(BuildOverlord()) { return; }
+        // Save up for it when it is only short of minerals for a moment, else keep building
+        if(income.timeUntilAffordable(OVERLORD_MINERAL_COST) <= SUPPLY_SAVE_LOOPS
+           && !GetIdleLarva().empty()) {
+            return;
+        }
     }
 
     if(buildOrder.empty()) return;
 
     const auto &nextBuild = buildOrder.front();
 
-    if(currentSupply >= nextBuild.first) {
-        if(nextBuild.second()) { buildOrder.pop_front(); }
+    if(currentSupply >= nextBuild.supply) {
+        // Wait for the forecast bank instead of retrying the build every step, builders leave early
+        const uint32_t lead = nextBuild.walk ? DISPATCH_HORIZON : 0;
+        if(income.timeUntilAffordable(nextBuild.minerals, nextBuild.vespene) > lead) { return; }
+        if(nextBuild.build()) { buildOrder.pop_front(); }
     } else {
         BuildDrone();
     }
 }
 
 /**
- * @brief Tries to inject larvae into hatcheries using queens.
+ * @brief Changes the build order in response to the enemy composition.
  *
- * This function checks if there are any available queens with enough energy
- * to inject larvae into hatcheries. If a queen is available, it is commanded
- * to inject larvae into the hatchery closest to it.
+ * Reads the running totals of the enemy memory, so it costs nothing to call
+ * every step. Queens are added once when the enemy air army appears, as they
+ * are the only anti-air of the build, and roaches are added whenever the enemy
+ * army outgrows ours, at most every ADAPT_INTERVAL game loops. Reactions wait
+ * for the structure that produces them, so they never block the build order.
  */
-void OnPhone::tryInjection() {
-    const ObservationInterface *observation = Observation();
-
-    Units queens = observation->GetUnits(Unit::Alliance::Self, [](const Unit &unit) {
-        return unit.unit_type == UNIT_TYPEID::ZERG_QUEEN && unit.energy >= 25;
-    });
-
-    if(queens.empty()) { return; }
-
-    Units hatcheries = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)];
-
-    if(hatcheries.empty()) { return; }
-
-    for(const auto &hatchery : hatcheries) {
-        bool already_injected = false;
-        for(const auto &order : hatchery->orders) {
-            if(order.ability_id == ABILITY_ID::EFFECT_INJECTLARVA) {
-                already_injected = true;
-                break;
-            }
+void OnPhone::AdaptBuildOrder() {
+    const EnemyComposition &enemy = enemyMemory.composition;
+    const uint32_t gameLoop = Observation()->GetGameLoop();
+    if(!adaptedToAir && enemy.airSupply >= ADAPT_AIR_SUPPLY
+       && !constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_SPAWNINGPOOL)].empty()) {
+        adaptedToAir = true;
+        LOG_INFO("Enemy air army of %g supply, adding queens", enemy.airSupply);
+        for(int i = 0; i < ADAPT_AIR_QUEENS; ++i) {
+            buildOrder.push_front({0, std::bind(&OnPhone::BuildQueen, this), QUEEN_MINERAL_COST});
         }
+    }
+    if(enemy.armySupply >= Observation()->GetFoodArmy() + ADAPT_ARMY_MARGIN
+       && gameLoop >= lastAdapted + ADAPT_INTERVAL
+       && !constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_ROACHWARREN)].empty()) {
+        lastAdapted = gameLoop;
+        LOG_INFO("Enemy army of %g supply worth %d, adding roaches", enemy.armySupply,
+                 enemy.armyValue());
+        for(int i = 0; i < ADAPT_ARMY_ROACHES; ++i) {
+            buildOrder.push_front({0, std::bind(&OnPhone::BuildRoach, this), ROACH_MINERAL_COST,
+                                   ROACH_VESPENE_COST});
+        }
+    }
+}
 
-        if(!already_injected) {
-            // Find the closest Queen to this Hatchery
-            const Unit *closest_queen = nullptr;
-            float closest_distance = std::numeric_limits<float>::max();
-
-            for(const auto &queen : queens) {
-                float distance = DistanceSquared2D(queen->pos, hatchery->pos);
-                if(distance < closest_distance && queen->orders.empty()) {
-                    closest_distance = distance;
-                    closest_queen = queen;
-                }
-            }
-
-            if(closest_queen) {
-                Actions()->UnitCommand(closest_queen, ABILITY_ID::EFFECT_INJECTLARVA, hatchery);
-                std::cout << "Command Sent: Injecting larvae into hatchery\n";
+/**
+ * @brief Records what the opponent showed this game, for the opponent history.
+ *
+ * Keeps the first game loop enemy army units were seen in our main and the
+ * largest enemy army, both read from running totals of the enemy memory.
+ *
+ * @param gameLoop The current game loop
+ */
+void OnPhone::RecordOpponent(uint32_t gameLoop) {
+    if(game.firstAttack == 0) {
+        for(const auto index : enemyMemory.near(startLoc)) {
+            if(enemyMemory.isArmy(enemyMemory.records[index])) {
+                game.firstAttack = gameLoop;
+                LOG_INFO("First enemy attack at loop %u", gameLoop);
+                break;
             }
         }
     }
+    const EnemyComposition &enemy = enemyMemory.composition;
+    if(enemy.armySupply > game.armySupply) {
+        game.armySupply = enemy.armySupply;
+        game.armyValue = enemy.armyValue();
+    }
+    game.airSupply = std::max(game.airSupply, enemy.airSupply);
+    game.detectors = std::max(game.detectors, static_cast<uint16_t>(enemy.detectors));
 }
 
 /**
@@ -314,25 +617,21 @@ bool OnPhone::BuildDrone() {
     }
 
     Units larva = GetIdleLarva();
-    if(larva.empty()) {
-        tryInjection();
-        return false;
-    }
+    if(larva.empty()) { return false; }
 
     Actions()->UnitCommand(larva.front(), ABILITY_ID::TRAIN_DRONE);
-    std::cout << "Command Sent: Build Drone\n";
+    LOG_INFO("Command Sent: Build Drone");
     return true;
 }
 
 /**
  * @brief Attempts to build an Overlord unit.
  *
- * This function checks if an Overlord has already been built, then looks for
- * available larva and sufficient minerals. If conditions are met, it issues a
- * command to train an Overlord.
+ * This function looks for available larva and sufficient minerals. If
+ * conditions are met, it issues a command to train an Overlord and tells the
+ * supply planner it is on the way.
  *
- * @return true if an Overlord was successfully queued for production or has
- * been built before, false otherwise.
+ * @return true if an Overlord was successfully queued for production, false otherwise.
  */
 bool OnPhone::BuildOverlord() {
     const ObservationInterface *observation = Observation();
@@ -340,13 +639,11 @@ bool OnPhone::BuildOverlord() {
     if(observation->GetMinerals() < OVERLORD_MINERAL_COST) { return false; }
 
     Units larva = GetIdleLarva();
-    if(larva.empty()) {
-        tryInjection();
-        return false;
-    }
+    if(larva.empty()) { return false; }
 
     Actions()->UnitCommand(larva.front(), ABILITY_ID::TRAIN_OVERLORD);
-    std::cout << "Command Sent: Build Overlord\n";
+    supply.ordered(observation->GetGameLoop());
+    LOG_INFO("Command Sent: Build Overlord");
     return true;
 }
 
@@ -368,17 +665,15 @@ bool OnPhone::BuildZergling() {
         return false;
     }
 
-    Units spawning_pool = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_SPAWNINGPOOL)];
+    const Units &spawning_pool
+      = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_SPAWNINGPOOL)];
     if(spawning_pool.empty()) { return false; }
 
     Units larva = GetIdleLarva();
-    if(larva.empty()) {
-        tryInjection();
-        return false;
-    }
+    if(larva.empty()) { return false; }
 
     Actions()->UnitCommand(larva[0], ABILITY_ID::TRAIN_ZERGLING);
-    std::cout << "Command Sent: Build Zergling\n";
+    LOG_INFO("Command Sent: Build Zergling");
     return true;
 }
 
@@ -400,13 +695,14 @@ bool OnPhone::BuildQueen() {
         return false;
     }
 
-    Units hatchery = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)];
-    Units spawning_pool = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_SPAWNINGPOOL)];
+    const Units &hatchery = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_HATCHERY)];
+    const Units &spawning_pool
+      = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_SPAWNINGPOOL)];
 
     if(hatchery.empty() || spawning_pool.empty()) { return false; }
 
     Actions()->UnitCommand(hatchery[0], ABILITY_ID::TRAIN_QUEEN);
-    std::cout << "Command Sent: Build Queen\n";
+    LOG_INFO("Command Sent: Build Queen");
     return true;
 }
 
@@ -430,16 +726,14 @@ bool OnPhone::BuildRoach() {
     }
 
     Units larva = GetIdleLarva();
-    if(larva.empty()) {
-        tryInjection();
-        return false;
-    }
+    if(larva.empty()) { return false; }
 
-    Units roach_warren = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_ROACHWARREN)];
+    const Units &roach_warren
+      = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_ROACHWARREN)];
     if(roach_warren.empty()) return false;
 
     Actions()->UnitCommand(larva[0], ABILITY_ID::TRAIN_ROACH);
-    std::cout << "Command Sent: Build Roach\n";
+    LOG_INFO("Command Sent: Build Roach");
     return true;
 }
 
@@ -462,47 +756,38 @@ bool OnPhone::BuildRavager() {
         return false;
     }
 
-    Units roach_warren = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_ROACHWARREN)];
+    const Units &roach_warren
+      = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_ROACHWARREN)];
     if(roach_warren.empty()) return false;
 
     Units roaches = observation->GetUnits(Unit::Alliance::Self, IsUnit(UNIT_TYPEID::ZERG_ROACH));
     if(roaches.empty()) return false;
 
     Actions()->UnitCommand(roaches[0], ABILITY_ID::MORPH_RAVAGER);
-    std::cout << "Command Sent: Build Ravager\n";
+    LOG_INFO("Command Sent: Build Ravager");
     return true;
 }
 
 /**
  * @brief Attempts to build a Spawning Pool structure.
  *
- * This function checks if a Spawning Pool has already been built, then looks
- * for available drones and sufficient minerals. If conditions are met, it finds
- * a suitable location and issues a command to build a Spawning Pool.
+ * This function finds a suitable location and has the drone dispatcher send a
+ * drone there, which builds the Spawning Pool once the minerals are banked.
  *
  * @return true if a Spawning Pool was successfully queued for construction or
  * has been built before, false otherwise.
  */
 bool OnPhone::BuildSpawningPool() {
-    const ObservationInterface *observation = Observation();
-    if(observation->GetMinerals() < SPAWNINGPOOL_COST) return false;
-
-    AllyUnit *drone = nullptr;
-    for(auto &worker : this->Workers->units) {
-        if(worker.unitTask == TASK::MINE) {
-            drone = &worker;
-            break;
-        }
+    Point2D buildLocation;
+    if(!dispatcher.location(ABILITY_ID::BUILD_SPAWNINGPOOL, buildLocation)) {
+        buildLocation = FindPlacementForBuilding(ABILITY_ID::BUILD_SPAWNINGPOOL);
+        if(buildLocation.x == 0 && buildLocation.y == 0) return false;
     }
-    if(!drone) return false;
 
-    Point2D buildLocation = FindPlacementForBuilding(ABILITY_ID::BUILD_SPAWNINGPOOL);
-    if(buildLocation.x == 0 && buildLocation.y == 0) return false;
-
-    drone->unitTask = TASK::UNSET;
-    Actions()->UnitCommand(drone->unit, ABILITY_ID::BUILD_SPAWNINGPOOL, buildLocation);
-    std::cout << "Command Sent: Build Spawning Pool at (" << buildLocation.x << ", "
-              << buildLocation.y << ")\n";
+    if(!dispatcher.build(ABILITY_ID::BUILD_SPAWNINGPOOL, buildLocation, SPAWNINGPOOL_COST)) {
+        return false;
+    }
+    LOG_INFO("Command Sent: Build Spawning Pool at (%g, %g)", buildLocation.x, buildLocation.y);
     return true;
 }
 
@@ -525,27 +810,15 @@ bool OnPhone::IsGeyser(const Unit &unit) {
 
 /**
  * @brief Attempts to build an Extractor structure.
- * This function checks if an Extractor has already been built, then looks
- * for available drones and sufficient minerals. If conditions are met, it finds
- * a vespene geyser near the main Hatchery (within 15 units) and issues a
- * command to build an Extractor on it.
+ * This function finds a vespene geyser near the main Hatchery (within 15 units)
+ * and has the drone dispatcher send a drone there, which builds the Extractor
+ * once the minerals are banked.
  *
  * @return true if an Extractor was successfully queued for construction or
  * has been built before, false otherwise.
  */
 bool OnPhone::BuildExtractor() {
     const ObservationInterface *observation = Observation();
-    if(observation->GetMinerals() < EXTRACTOR_COST) return false;
-
-    AllyUnit *drone = nullptr;
-    for(auto &worker : this->Workers->units) {
-        if(worker.unitTask == TASK::MINE) {
-            drone = &worker;
-            break;
-        }
-    }
-    if(!drone) return false;
-
     Units geysers = observation->GetUnits(Unit::Alliance::Neutral,
                                           [this](const Unit &unit) { return IsGeyser(unit); });
     Point2D startLocation;
@@ -555,134 +828,126 @@ bool OnPhone::BuildExtractor() {
         startLocation = startLoc;
     }
 
-    for(const auto &geyser : geysers) {
-        if(Distance2D(geyser->pos, startLocation) < BASE_SIZE) {
-            drone->unitTask = TASK::UNSET;
-            Actions()->UnitCommand(drone->unit, ABILITY_ID::BUILD_EXTRACTOR, geyser);
-            std::cout << "Command Sent: Build Extractor\n";
-            return true;
-        }
+    const std::size_t closest = FirstWithin(PointSet(geysers), startLocation, BASE_SIZE);
+    if(closest == GEOMETRY_NONE) { return false; }
+    if(!dispatcher.build(ABILITY_ID::BUILD_EXTRACTOR, geysers[closest]->pos, EXTRACTOR_COST,
+                         geysers[closest])) {
+        return false;
     }
-    return false;
+    LOG_INFO("Command Sent: Build Extractor");
+    return true;
 }
 
 /**
- * @brief Assigns workers to an Extractor.
+ * @brief Attempts to build a Hatchery structure.
  *
- * This function assigns up to 3 idle workers to the given Extractor.
- * It iterates through idle workers and commands them to work on the Extractor
- * using the SMART ability.
+ * This function finds an expansion location and has the drone dispatcher send
+ * a drone there, which builds the Hatchery once the minerals are banked.
  *
- * @param extractor Pointer to the Extractor unit to assign workers to.
+ * @return bool Returns true if the build command was issued, false otherwise.
  */
-void OnPhone::AssignWorkersToExtractor(const Unit *extractor) {
-    int assignedWorkers = 0;
-    for(auto &worker : this->Workers->units) {
-        if(assignedWorkers >= MAX_EXTRACTOR_WORKERS) break;
-        if(worker.unitTask == TASK::MINE) {
-            ++assignedWorkers;
-            worker.unitTask = TASK::EXTRACT;
-        }
+bool OnPhone::BuildHatchery() {
+    Point2D buildLocation;
+    if(!dispatcher.location(ABILITY_ID::BUILD_HATCHERY, buildLocation)) {
+        buildLocation = FindExpansionLocation();
+        if(buildLocation.x == 0 && buildLocation.y == 0) return false;
+    }
+
+    if(!dispatcher.build(ABILITY_ID::BUILD_HATCHERY, buildLocation, HATCHERY_COST)) {
+        return false;
     }
+    LOG_INFO("Command Sent: Build Hatchery at (%g, %g)", buildLocation.x, buildLocation.y);
+    return true;
 }
 
 /**
- * @brief Attempts to build a Hatchery structure.
+ * @brief Builds a Roach Warren structure.
  *
- * This function checks for available idle drones and sufficient minerals.
- * If conditions are met, it finds a suitable location and issues a command
- * to build a Hatchery.
+ * This function uses FindPlacementForBuilding to determine a suitable location
+ * and has the drone dispatcher send a drone there, which builds the Roach
+ * Warren once the minerals are banked.
  *
  * @return bool Returns true if the build command was issued, false otherwise.
  */
-bool OnPhone::BuildHatchery() {
-    const ObservationInterface *observation = Observation();
-    if(observation->GetMinerals() < HATCHERY_COST) return false;
-
-    AllyUnit *drone = nullptr;
-    for(auto &worker : this->Workers->units) {
-        if(worker.unitTask == TASK::MINE) {
-            drone = &worker;
-            break;
-        }
+bool OnPhone::BuildRoachWarren() {
+    Point2D buildLocation;
+    if(!dispatcher.location(ABILITY_ID::BUILD_ROACHWARREN, buildLocation)) {
+        buildLocation = FindPlacementForBuilding(ABILITY_ID::BUILD_ROACHWARREN);
+        if(buildLocation.x == 0 && buildLocation.y == 0) return false;
     }
 
-    if(!drone) return false;
-
-    Point2D buildLocation = FindExpansionLocation();
-    if(buildLocation.x == 0 && buildLocation.y == 0) return false;
-
-    drone->unitTask = TASK::UNSET;
-    Actions()->UnitCommand(drone->unit, ABILITY_ID::BUILD_HATCHERY, buildLocation);
-    std::cout << "Command Sent: Build Hatchery at (" << buildLocation.x << ", " << buildLocation.y
-              << ")\n";
+    if(!dispatcher.build(ABILITY_ID::BUILD_ROACHWARREN, buildLocation, ROACHWARREN_COST)) {
+        return false;
+    }
+    LOG_INFO("Command Sent: Build Roach Warren");
     return true;
 }
 
 /**
- * @brief Builds a Roach Warren structure.
+ * @brief Researches an upgrade once its structure is built and the cost is banked.
  *
- * This function attempts to build a Roach Warren if there's an idle Drone
- * and enough minerals available. It uses FindPlacementForBuilding to determine
- * a suitable location for the structure.
+ * The research is sent again if the structure does not show it within
+ * RESEARCH_CONFIRM_LOOPS, e.g. when the structure was destroyed.
  *
- * @return bool Returns true if the build command was issued, false otherwise.
+ * @param ability The research ability
+ * @param structure The type of the structure researching it
+ * @param minerals The mineral cost of the research
+ * @param vespene The vespene cost of the research
+ * @param started Set once the structure started the research
+ * @return StepTask The task, to be spawned on the task scheduler
  */
-bool OnPhone::BuildRoachWarren() {
+StepTask OnPhone::Research(ABILITY_ID ability, UNIT_TYPEID structure, int minerals, int vespene,
+                           bool &started) {
     const ObservationInterface *observation = Observation();
-    if(observation->GetMinerals() < ROACHWARREN_COST) return false;
-
-    AllyUnit *drone = nullptr;
-    for(auto &worker : this->Workers->units) {
-        if(worker.unitTask == TASK::MINE) {
-            drone = &worker;
-            break;
+    const Units &buildings = constructedBuildings[GetBuildingIndex(structure)];
+    while(true) {
+        co_await tasks.until([observation, &buildings, minerals, vespene] {
+            return !buildings.empty() && observation->GetMinerals() >= minerals
+                   && observation->GetVespene() >= vespene;
+        });
+        const Tag building = buildings[0]->tag;
+        Actions()->UnitCommand(buildings[0], ability);
+        LOG_INFO("Command Sent: Research %d", static_cast<int>(ability));
+        const bool confirmed = co_await tasks.until(
+          [observation, building, ability] {
+              const Unit *unit = observation->GetUnit(building);
+              return unit != nullptr && !unit->orders.empty()
+                     && unit->orders[0].ability_id == ability;
+          },
+          RESEARCH_CONFIRM_LOOPS);
+        if(confirmed) {
+            started = true;
+            co_return;
         }
+        LOG_WARN("Research %d did not start, sending it again", static_cast<int>(ability));
     }
-    if(!drone) return false;
-
-    Point2D buildLocation = FindPlacementForBuilding(ABILITY_ID::BUILD_ROACHWARREN);
-    if(buildLocation.x == 0 && buildLocation.y == 0) return false;
-
-    drone->unitTask = TASK::UNSET;
-    Actions()->UnitCommand(drone->unit, ABILITY_ID::BUILD_ROACHWARREN, buildLocation);
-    std::cout << "Command Sent: Build Roach Warren\n";
-    return true;
 }
 
 /**
  * @brief Researches Metabolic Boost upgrade for Zerglings.
  *
- * This function attempts to research the Metabolic Boost upgrade if there's a
- * constructed Spawning Pool and enough resources available.
+ * The first call starts a research task, which waits for a constructed
+ * Spawning Pool and the resources before sending the research.
  *
- * @return bool Returns true if the research command was issued, false
+ * @return bool Returns true once the Spawning Pool started the research, false
  * otherwise.
  */
 bool OnPhone::ResearchMetabolicBoost() {
-    const ObservationInterface *observation = Observation();
-    const auto &spawning_pool
-      = constructedBuildings[GetBuildingIndex(UNIT_TYPEID::ZERG_SPAWNINGPOOL)];
-
-    if(spawning_pool.empty() || observation->GetMinerals() < METABOLIC_BOOST_COST
-       || observation->GetVespene() < METABOLIC_BOOST_COST) {
-        return !spawning_pool.empty() && !spawning_pool[0]->orders.empty()
-               && spawning_pool[0]->orders[0].ability_id
-                    == ABILITY_ID::RESEARCH_ZERGLINGMETABOLICBOOST;
+    if(!metabolicBoostQueued) {
+        metabolicBoostQueued = true;
+        tasks.spawn(Research(ABILITY_ID::RESEARCH_ZERGLINGMETABOLICBOOST,
+                             UNIT_TYPEID::ZERG_SPAWNINGPOOL, METABOLIC_BOOST_COST,
+                             METABOLIC_BOOST_COST, metabolicBoostStarted));
     }
-
-    const Unit *pool = spawning_pool[0];
-    Actions()->UnitCommand(pool, ABILITY_ID::RESEARCH_ZERGLINGMETABOLICBOOST);
-    std::cout << "Command Sent: Research Metabolic Boost\n";
-    return false;
+    return metabolicBoostStarted;
 }
 
 /**
  * @brief Finds a suitable location for expanding the base.
  *
  * This function searches for mineral fields that are not too close to the
- * starting location and checks if there's enough space to build a Hatchery
- * nearby. It avoids locations where a Hatchery already exists.
+ * starting location, closest by ground distance first, and checks if there's
+ * enough space to build a Hatchery nearby. It avoids locations where a Hatchery already exists.
  *
  * @return Point2D The coordinates where a new Hatchery can be placed for
  * expansion. Returns (0, 0) if no suitable location is found.
@@ -700,27 +965,17 @@ Point2D OnPhone::FindExpansionLocation() {
                || u.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750;
     });
 
-    std::sort(minerals.begin(), minerals.end(), [startLocation](const Unit *a, const Unit *b) {
-        return Distance2D(a->pos, startLocation) < Distance2D(b->pos, startLocation);
-    });
-
-    auto it = std::find_if(minerals.begin(), minerals.end(), [startLocation](const Unit *m) {
-        return Distance2D(m->pos, startLocation) > 10.0f;
-    });
-
-    while(it != minerals.end()) {
-        const Unit *mineral = *it;
+    SortExpansionMinerals(minerals, baseDistances, startLocation);
 
-        Units nearby = observation->GetUnits(Unit::Alliance::Self, [&mineral](const Unit &u) {
-            return u.unit_type == UNIT_TYPEID::ZERG_HATCHERY
-                   && Distance2D(u.pos, mineral->pos) < 10.0f;
-        });
+    const PointSet hatcheries(observation->GetUnits(Unit::Alliance::Self, [](const Unit &u) {
+        return u.unit_type == UNIT_TYPEID::ZERG_HATCHERY;
+    }));
 
-        if(nearby.empty()) {
+    for(const auto *mineral : minerals) {
+        if(FirstWithin(hatcheries, mineral->pos, 10.0f) == GEOMETRY_NONE) {
             Point2D location = FindHatcheryPlacement(mineral);
             if(location.x != 0 || location.y != 0) { return location; }
         }
-        ++it;
     }
 
     return Point2D(0, 0);
@@ -748,6 +1003,9 @@ Point2D OnPhone::FindHatcheryPlacement(const Unit *mineral_field) {
 /**
  * @brief Finds a suitable placement for a building near the main Hatchery.
  *
+ * Candidates whose 3x3 footprint is not placeable or not on creep are rejected
+ * with the map grids, so the server is only queried for plausible positions.
+ *
  * @param ability_type The ABILITY_ID of the building to be placed.
  * @return Point2D The coordinates where the building can be placed.
  *         Returns (0, 0) if no suitable location is found.
@@ -770,6 +1028,13 @@ Point2D OnPhone::FindPlacementForBuilding(ABILITY_ID ability_type) {
         current = Observation()->GetStartLocation();
     }
 
+    const auto &creep = Observation()->GetRawObservation()->raw_data().map_state().creep();
+    BitGrid buildable = BitGrid::decode(creep.data(), creep.size().x(), creep.size().y(),
+                                        creep.bits_per_pixel());
+    const bool prefilter = buildable.width > 0 && buildable.width == placementGrid.width
+                           && buildable.height == placementGrid.height;
+    if(prefilter) { buildable &= placementGrid; }
+
     for(int radius = 1; radius <= 15; ++radius) {
         for(int dir = 0; dir < 4; ++dir) {
             const int steps = radius;
@@ -777,7 +1042,12 @@ Point2D OnPhone::FindPlacementForBuilding(ABILITY_ID ability_type) {
             const float delta_y = dy[dir];
 
             for(int step = 0; step < steps; ++step) {
-                if(Query()->Placement(ability_type, current)) { return current; }
+                const int x = static_cast<int>(current.x - 1.5f);
+                const int y = static_cast<int>(current.y - 1.5f);
+                if((!prefilter || buildable.fits(x, y, 3, 3))
+                   && Query()->Placement(ability_type, current)) {
+                    return current;
+                }
                 current.x += delta_x;
                 current.y += delta_y;
             }
@@ -788,11 +1058,10 @@ Point2D OnPhone::FindPlacementForBuilding(ABILITY_ID ability_type) {
 }
 
 /**
- * @brief Gets the locations of enemy base if it is visible and sets enemyLoc.
+ * @brief Sets enemyLoc from the scouted enemy base or the enemy memory.
  *
- * This function retrieves the locations of all enemy units that are either
- * visible or in snapshot and then establishes the enemy base location based
- * on whether they are buildings.
+ * The enemy memory keeps a stable anchor structure, preferring the enemy main,
+ * so enemyLoc only changes when enemy structures are found or destroyed.
  *
  */
 void OnPhone::GetEnemyUnitLocations() {
@@ -800,21 +1069,10 @@ void OnPhone::GetEnemyUnitLocations() {
     if(scoutControllerEnemyLoc.x != 0 && scoutControllerEnemyLoc.y != 0) {
         enemyLoc = scoutControllerEnemyLoc;
     } else {
-        const ObservationInterface *observation = Observation();
-        std::vector<Point3D> enemy_unit_locations;
-
-        // Get all enemy units that are either visible or in snapshot
-        Units enemy_units = observation->GetUnits(Unit::Alliance::Enemy, [](const Unit &unit) {
-            return unit.unit_type.ToType() != UNIT_TYPEID::INVALID &&  // Valid unit
-                   (unit.display_type == Unit::DisplayType::Visible || // Visible or
-                    unit.display_type == Unit::DisplayType::Snapshot)
-                   && IsBuilding(unit);
-        });
-        if(!enemy_units.empty()) {
-            if(enemyLoc != enemy_units[0]->pos) {
-                enemyLoc = enemy_units[0]->pos;
-                std::cout << "Enemy found at (" << enemyLoc.x << ", " << enemyLoc.y << ")\n";
-            }
+        const EnemyRecord *anchor = enemyMemory.anchor();
+        if(anchor != nullptr && enemyLoc != anchor->pos) {
+            enemyLoc = anchor->pos;
+            LOG_INFO_LIMITED(2, "Enemy found at (%g, %g)", enemyLoc.x, enemyLoc.y);
         }
     }
 }
@@ -850,18 +1108,45 @@ int OnPhone::GetBuildingIndex(UNIT_TYPEID type) {
  * @brief Called when a game ends.
  *
  * Prints game statistics including total game loops, game duration in seconds,
- * and the match result (Win/Loss/Tie).
+ * and the match result (Win/Loss/Tie). The logger is flushed so the result lines
+ * reach stdout before the process exits. If ONPHONE_TELEMETRY_DIR is set, the
+ * sampled telemetry of the game is written to that directory.
  */
 void OnPhone::OnGameEnd() {
     const ObservationInterface *observation = Observation();
-    std::cout << "Game ended after: " << observation->GetGameLoop() << " loops " << std::endl;
-    std::cout << "Total game time: " << observation->GetGameLoop() / 22.4 << " seconds"
-              << std::endl;
+    LOG_RESULT("Game ended after: %u loops ", observation->GetGameLoop());
+    LOG_RESULT("Total game time: %g seconds", observation->GetGameLoop() / 22.4);
 
     const std::vector<PlayerResult> result = observation->GetResults();
-    std::cout << "Result: "
-              << (result[0].result == GameResult::Win    ? "Won"
-                  : result[0].result == GameResult::Loss ? "Lost"
-                                                         : "Tied")
-              << std::endl;
+    const char *outcome = result[0].result == GameResult::Win    ? "Won"
+                          : result[0].result == GameResult::Loss ? "Lost"
+                                                                 : "Tied";
+    LOG_RESULT("Result: %s", outcome);
+    game.result = result[0].result == GameResult::Win   ? 1
+                  : result[0].result == GameResult::Tie ? 2
+                                                        : 0;
+    game.gameLoops = observation->GetGameLoop();
+    if(!opponents.append(game)) { LOG_WARN("Could not record the game in the opponent history"); }
+    LOG_INFO("Frame arena peak: %zu of %zu bytes, %zu overflows", arena.peak, arena.capacity(),
+             arena.overflows);
+    LOG_INFO("Step budget: worst step %.2f ms, %llu of %llu steps over %g ms", budget.worst,
+             static_cast<unsigned long long>(budget.overruns),
+             static_cast<unsigned long long>(budget.steps), budget.ceiling);
+    for(const auto &task : budget.tasks) {
+        LOG_INFO("Step budget: %s ran %llu times, deferred %llu times, estimate %.3f ms",
+                 task.name, static_cast<unsigned long long>(task.ran),
+                 static_cast<unsigned long long>(task.deferred), task.estimate);
+    }
+#if ONPHONE_COUNT_ALLOCATIONS
+    LOG_INFO("Heap allocations: at most %llu per step, in %llu of %llu steps",
+             static_cast<unsigned long long>(arena.maxHeapCalls),
+             static_cast<unsigned long long>(arena.heapSteps),
+             static_cast<unsigned long long>(arena.steps));
+#endif
+    if(const char *directory = std::getenv("ONPHONE_TELEMETRY_DIR")) {
+        if(!telemetry.write(directory, observation, outcome)) {
+            LOG_WARN("Could not write telemetry to ONPHONE_TELEMETRY_DIR");
+        }
+    }
+    Logger::instance().flush();
 }
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include "OpponentStore.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(OpponentRecord) == 48, "OpponentRecord is written to disk as is");
+
+/**
+ * @brief Hashes an opponent id, so ids of any length fit into a record.
+ *
+ * @param opponent The opponent id passed by the ladder
+ * @return uint64_t The 64-bit FNV-1a hash of the id
+ */
+uint64_t OpponentStore::hash(const std::string &opponent) {
+    uint64_t value = 14695981039346656037ULL;
+    for(const unsigned char c : opponent) {
+        value ^= c;
+        value *= 1099511628211ULL;
+    }
+    return value;
+}
+
+/**
+ * @brief Computes the checksum of a record.
+ *
+ * @param record The record
+ * @return uint32_t The 32-bit FNV-1a hash of every byte before the checksum field
+ */
+uint32_t OpponentStore::checksum(const OpponentRecord &record) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&record);
+    uint32_t value = 2166136261u;
+    for(std::size_t i = 0; i < offsetof(OpponentRecord, checksum); ++i) {
+        value ^= bytes[i];
+        value *= 16777619u;
+    }
+    return value;
+}
+
+/**
+ * @brief Maps the opponent file of a data directory and sums up its records.
+ *
+ * The file is only read through the mapping and unmapped again, the summary
+ * per opponent and opening is kept. Records are read at multiples of the
+ * record size, so a record torn by a crash fails its checksum and is skipped
+ * along with any trailing partial record.
+ *
+ * @param directory The directory holding the opponent file
+ * @return true if the file was read or does not exist yet, false if it could not be read
+ */
+bool OpponentStore::open(const std::string &directory) {
+    path = directory + "/" + OPPONENT_FILE;
+    opponents.clear();
+    loaded = 0;
+    damaged = 0;
+    const unsigned char *data = nullptr;
+    std::size_t size = 0;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) { return GetLastError() == ERROR_FILE_NOT_FOUND; }
+    LARGE_INTEGER length;
+    HANDLE mapping = nullptr;
+    if(GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+        size = static_cast<std::size_t>(length.QuadPart);
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping != nullptr) {
+            data = static_cast<const unsigned char *>(
+              MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0) { return errno == ENOENT; }
+    struct stat info;
+    void *mapped = MAP_FAILED;
+    if(fstat(file, &info) == 0 && info.st_size > 0) {
+        size = static_cast<std::size_t>(info.st_size);
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if(mapped != MAP_FAILED) { data = static_cast<const unsigned char *>(mapped); }
+    }
+#endif
+    if(data != nullptr) {
+        for(std::size_t offset = 0; offset + sizeof(OpponentRecord) <= size;
+            offset += sizeof(OpponentRecord)) {
+            OpponentRecord record;
+            std::memcpy(&record, data + offset, sizeof(record));
+            if(record.magic != OPPONENT_MAGIC || record.version != OPPONENT_VERSION
+               || record.checksum != checksum(record)
+               || record.opening >= static_cast<uint8_t>(OPENING::COUNT)) {
+                ++damaged;
+                continue;
+            }
+            add(record);
+            ++loaded;
+        }
+    }
+#if defined(_WIN32)
+    if(data != nullptr) { UnmapViewOfFile(data); }
+    if(mapping != nullptr) { CloseHandle(mapping); }
+    CloseHandle(file);
+#else
+    if(mapped != MAP_FAILED) { munmap(mapped, size); }
+    ::close(file);
+#endif
+    return size == 0 || data != nullptr;
+}
+
+/**
+ * @brief Gets the summed up games against an opponent.
+ *
+ * @param opponent The hashed opponent id
+ * @return const Openings& The stats per opening, all zero for a new opponent
+ */
+const OpponentStore::Openings &OpponentStore::history(uint64_t opponent) const {
+    static const Openings none{};
+    auto it = opponents.find(opponent);
+    return it == opponents.end() ? none : it->second;
+}
+
+/**
+ * @brief Picks the opening to play against an opponent.
+ *
+ * Every opening is tried once in order, then UCB1 picks the opening with the
+ * highest win rate plus an exploration bonus that shrinks the more often it
+ * was played. Ties count as half a win.
+ *
+ * @param opponent The hashed opponent id
+ * @return OPENING The opening to play
+ */
+OPENING OpponentStore::choose(uint64_t opponent) const {
+    const Openings &openings = history(opponent);
+    uint32_t total = 0;
+    for(const auto &stats : openings) {
+        if(stats.games == 0) { return static_cast<OPENING>(&stats - openings.data()); }
+        total += stats.games;
+    }
+    const float logTotal = std::log(static_cast<float>(total));
+    std::size_t best = 0;
+    float bestScore = -std::numeric_limits<float>::max();
+    for(std::size_t i = 0; i < openings.size(); ++i) {
+        const float games = static_cast<float>(openings[i].games);
+        const float score
+          = openings[i].wins / games + OPPONENT_EXPLORATION * std::sqrt(logTotal / games);
+        if(score > bestScore) {
+            bestScore = score;
+            best = i;
+        }
+    }
+    return static_cast<OPENING>(best);
+}
+
+/**
+ * @brief Appends the record of a finished game to the opponent file.
+ *
+ * A partial record left by a crash is first padded to a whole record, so it
+ * is skipped on the next open and the new record starts on a record boundary.
+ *
+ * @param record The game, its checksum is filled in
+ * @return true if the record was written, false otherwise
+ */
+bool OpponentStore::append(OpponentRecord record) {
+    if(path.empty()) { return false; }
+    record.checksum = checksum(record);
+    std::FILE *file = std::fopen(path.c_str(), "ab");
+    if(file == nullptr) { return false; }
+    bool written = std::fseek(file, 0, SEEK_END) == 0;
+    const long size = written ? std::ftell(file) : -1;
+    written = size >= 0;
+    if(written && size % sizeof(OpponentRecord) != 0) {
+        const char zeros[sizeof(OpponentRecord)] = {};
+        const std::size_t pad = sizeof(OpponentRecord) - size % sizeof(OpponentRecord);
+        written = std::fwrite(zeros, 1, pad, file) == pad;
+    }
+    written = written && std::fwrite(&record, sizeof(record), 1, file) == 1;
+    written = std::fflush(file) == 0 && written;
+    std::fclose(file);
+    if(written) { add(record); }
+    return written;
+}
+
+/**
+ * @brief Adds a game to the summary of its opponent and opening.
+ *
+ * @param record The game
+ */
+void OpponentStore::add(const OpponentRecord &record) {
+    Stats &stats = opponents[record.opponent][record.opening];
+    ++stats.games;
+    stats.wins += record.result == 1 ? 1.0f : record.result == 2 ? 0.5f : 0.0f;
+    if(record.firstAttack != 0) {
+        ++stats.attacks;
+        stats.firstAttackSum += record.firstAttack;
+    }
+    stats.armySupplySum += record.armySupply;
+    if(record.airSupply > 0.0f) { ++stats.airGames; }
+}
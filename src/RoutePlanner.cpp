@@ -0,0 +1,324 @@
+#include "RoutePlanner.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace sc2;
+
+/**
+ * @brief Sets the stops to cover and their distances, dropping all routes.
+ *
+ * @param stops The positions every scout route is built from
+ * @param matrix The travel distances between the stops
+ */
+void RoutePlanner::initialize(const std::vector<Point2D> &stops, DistanceMatrix matrix) {
+    this->stops = stops;
+    this->matrix = std::move(matrix);
+    routes.clear();
+}
+
+/**
+ * @brief Checks if the stops were set.
+ *
+ * @return true if there are stops to route, false otherwise
+ */
+bool RoutePlanner::initialized() const { return !stops.empty(); }
+
+/**
+ * @brief Checks if a scout has a route.
+ *
+ * @param scout The tag of the scout
+ * @return true if the scout has a route, false otherwise
+ */
+bool RoutePlanner::has(Tag scout) const { return routes.count(scout) != 0; }
+
+/**
+ * @brief Gives a new scout a route.
+ *
+ * The first scout gets a tour over all stops, built by nearest insertion and
+ * improved with 2-opt. Later scouts take over stops from the longest routes
+ * for as long as that shortens the longest route, so the other routes are
+ * only trimmed rather than rebuilt.
+ *
+ * @param scout The tag of the scout
+ * @param pos The position of the scout, it starts at the closest stop of its route
+ */
+void RoutePlanner::addScout(Tag scout, const Point2D &pos) {
+    if(has(scout) || stops.empty()) { return; }
+    const bool first = routes.empty();
+    Route &route = routes[scout];
+    if(first) {
+        std::vector<std::size_t> all(stops.size());
+        for(std::size_t i = 0; i < all.size(); ++i) { all[i] = i; }
+        buildTour(route, all);
+    } else {
+        rebalance(scout);
+    }
+    float closest = std::numeric_limits<float>::max();
+    for(std::size_t i = 0; i < route.stops.size(); ++i) {
+        const float distance = DistanceSquared2D(pos, stops[route.stops[i]]);
+        if(distance < closest) {
+            closest = distance;
+            route.next = i;
+        }
+    }
+}
+
+/**
+ * @brief Removes the route of a scout that died or stopped scouting.
+ *
+ * Its stops are inserted one by one where they lengthen the remaining routes
+ * the least, and the routes that received stops are improved with 2-opt.
+ *
+ * @param scout The tag of the scout
+ */
+void RoutePlanner::removeScout(Tag scout) {
+    auto it = routes.find(scout);
+    if(it == routes.end()) { return; }
+    const std::vector<std::size_t> orphans = it->second.stops;
+    routes.erase(it);
+    if(routes.empty()) { return; }
+
+    std::vector<Route *> touched;
+    for(const auto stop : orphans) {
+        Route *best = nullptr;
+        float bestLength = std::numeric_limits<float>::max();
+        for(auto &entry : routes) {
+            std::size_t position;
+            const float length = entry.second.length
+                                 + insertionCost(entry.second.stops, stop, position);
+            if(length < bestLength) {
+                bestLength = length;
+                best = &entry.second;
+            }
+        }
+        insert(*best, stop);
+        if(std::find(touched.begin(), touched.end(), best) == touched.end()) {
+            touched.push_back(best);
+        }
+    }
+    for(auto *route : touched) { twoOpt(*route); }
+}
+
+/**
+ * @brief Gets the next stop of a scout and advances its route.
+ *
+ * @param scout The tag of the scout
+ * @param stop The position of the next stop
+ * @return true if the scout has a stop to go to, false otherwise
+ */
+bool RoutePlanner::next(Tag scout, Point2D &stop) {
+    auto it = routes.find(scout);
+    if(it == routes.end() || it->second.stops.empty()) { return false; }
+    Route &route = it->second;
+    route.next %= route.stops.size();
+    stop = stops[route.stops[route.next]];
+    route.next = (route.next + 1) % route.stops.size();
+    return true;
+}
+
+/**
+ * @brief Gets the number of stops on the route of a scout.
+ *
+ * @param scout The tag of the scout
+ * @return std::size_t The number of stops, 0 if the scout has no route
+ */
+std::size_t RoutePlanner::length(Tag scout) const {
+    auto it = routes.find(scout);
+    return it == routes.end() ? 0 : it->second.stops.size();
+}
+
+/**
+ * @brief Gets the length of the longest route, the time to cover every stop.
+ *
+ * @return float The length of the longest closed tour
+ */
+float RoutePlanner::longest() const {
+    float result = 0.0f;
+    for(const auto &entry : routes) { result = std::max(result, entry.second.length); }
+    return result;
+}
+
+/**
+ * @brief Computes the length of a closed tour.
+ *
+ * @param tour The stops of the tour in order
+ * @return float The length of the tour including the way back to its start
+ */
+float RoutePlanner::tourLength(const std::vector<std::size_t> &tour) const {
+    float length = 0.0f;
+    for(std::size_t i = 0; i + 1 < tour.size(); ++i) { length += matrix(tour[i], tour[i + 1]); }
+    if(tour.size() > 1) { length += matrix(tour.back(), tour.front()); }
+    return length;
+}
+
+/**
+ * @brief Finds the cheapest position to insert a stop into a closed tour.
+ *
+ * @param tour The stops of the tour in order
+ * @param stop The stop to insert
+ * @param position The index the stop should be inserted at
+ * @return float The increase in tour length
+ */
+float RoutePlanner::insertionCost(const std::vector<std::size_t> &tour, std::size_t stop,
+                                  std::size_t &position) const {
+    position = tour.size();
+    if(tour.empty()) { return 0.0f; }
+    if(tour.size() == 1) { return 2.0f * matrix(tour[0], stop); }
+    float best = std::numeric_limits<float>::max();
+    for(std::size_t i = 0; i < tour.size(); ++i) {
+        const std::size_t a = tour[i];
+        const std::size_t b = tour[(i + 1) % tour.size()];
+        const float cost = matrix(a, stop) + matrix(stop, b) - matrix(a, b);
+        if(cost < best) {
+            best = cost;
+            position = i + 1;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Computes how much shorter a closed tour gets without one of its stops.
+ *
+ * @param tour The stops of the tour in order
+ * @param position The index of the stop to remove
+ * @return float The decrease in tour length
+ */
+float RoutePlanner::removalGain(const std::vector<std::size_t> &tour, std::size_t position) const {
+    if(tour.size() < 2) { return 0.0f; }
+    if(tour.size() == 2) { return 2.0f * matrix(tour[0], tour[1]); }
+    const std::size_t stop = tour[position];
+    const std::size_t before = tour[(position + tour.size() - 1) % tour.size()];
+    const std::size_t after = tour[(position + 1) % tour.size()];
+    return matrix(before, stop) + matrix(stop, after) - matrix(before, after);
+}
+
+/**
+ * @brief Inserts a stop into a route at its cheapest position.
+ *
+ * @param route The route to extend
+ * @param stop The stop to insert
+ */
+void RoutePlanner::insert(Route &route, std::size_t stop) {
+    std::size_t position;
+    route.length += insertionCost(route.stops, stop, position);
+    route.stops.insert(route.stops.begin() + position, stop);
+    if(position < route.next) { ++route.next; }
+}
+
+/**
+ * @brief Builds a tour over a set of stops by nearest insertion, then improves it.
+ *
+ * The stop closest to the tour so far is always inserted next, at the position
+ * where it adds the least length.
+ *
+ * @param route The route to build
+ * @param candidates The stops to visit
+ */
+void RoutePlanner::buildTour(Route &route, const std::vector<std::size_t> &candidates) const {
+    route.stops.clear();
+    route.length = 0.0f;
+    if(candidates.empty()) { return; }
+    std::vector<std::size_t> pending(candidates.begin() + 1, candidates.end());
+    std::vector<float> nearest(pending.size());
+    route.stops.push_back(candidates.front());
+    for(std::size_t i = 0; i < pending.size(); ++i) {
+        nearest[i] = matrix(candidates.front(), pending[i]);
+    }
+    while(!pending.empty()) {
+        const std::size_t pick
+          = std::min_element(nearest.begin(), nearest.end()) - nearest.begin();
+        const std::size_t stop = pending[pick];
+        pending[pick] = pending.back();
+        pending.pop_back();
+        nearest[pick] = nearest.back();
+        nearest.pop_back();
+
+        std::size_t position;
+        route.length += insertionCost(route.stops, stop, position);
+        route.stops.insert(route.stops.begin() + position, stop);
+        for(std::size_t i = 0; i < pending.size(); ++i) {
+            nearest[i] = std::min(nearest[i], matrix(stop, pending[i]));
+        }
+    }
+    twoOpt(route);
+}
+
+/**
+ * @brief Improves a closed tour by reversing segments while that shortens it.
+ *
+ * @param route The route to improve
+ */
+void RoutePlanner::twoOpt(Route &route) const {
+    std::vector<std::size_t> &tour = route.stops;
+    const std::size_t n = tour.size();
+    bool improved = n >= 4;
+    while(improved) {
+        improved = false;
+        for(std::size_t i = 0; i + 2 < n; ++i) {
+            for(std::size_t j = i + 2; j < n; ++j) {
+                if(i == 0 && j == n - 1) { continue; }
+                const std::size_t a = tour[i];
+                const std::size_t b = tour[i + 1];
+                const std::size_t c = tour[j];
+                const std::size_t d = tour[(j + 1) % n];
+                const float delta = matrix(a, c) + matrix(b, d) - matrix(a, b) - matrix(c, d);
+                if(delta < -ROUTE_EPSILON) {
+                    std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+                    improved = true;
+                }
+            }
+        }
+    }
+    route.length = tourLength(tour);
+}
+
+/**
+ * @brief Moves stops from the longest routes to a new route.
+ *
+ * Each move takes the stop that keeps the longer of the two routes shortest,
+ * and moves continue while they shorten the longest route overall.
+ *
+ * @param scout The tag of the scout with the new route
+ */
+void RoutePlanner::rebalance(Tag scout) {
+    Route &target = routes[scout];
+    std::vector<Route *> touched;
+    while(true) {
+        Route *donor = nullptr;
+        for(auto &entry : routes) {
+            if(entry.second.stops.size() > 1
+               && (donor == nullptr || entry.second.length > donor->length)) {
+                donor = &entry.second;
+            }
+        }
+        if(donor == nullptr || donor == &target) { break; }
+
+        std::size_t bestIndex = 0;
+        float bestMax = std::numeric_limits<float>::max();
+        for(std::size_t i = 0; i < donor->stops.size(); ++i) {
+            std::size_t position;
+            const float donorLength = donor->length - removalGain(donor->stops, i);
+            const float targetLength
+              = target.length + insertionCost(target.stops, donor->stops[i], position);
+            const float longer = std::max(donorLength, targetLength);
+            if(longer < bestMax) {
+                bestMax = longer;
+                bestIndex = i;
+            }
+        }
+        if(bestMax >= donor->length - ROUTE_EPSILON) { break; }
+
+        const std::size_t stop = donor->stops[bestIndex];
+        donor->length -= removalGain(donor->stops, bestIndex);
+        donor->stops.erase(donor->stops.begin() + bestIndex);
+        if(bestIndex < donor->next) { --donor->next; }
+        insert(target, stop);
+        if(std::find(touched.begin(), touched.end(), donor) == touched.end()) {
+            touched.push_back(donor);
+        }
+    }
+    for(auto *route : touched) { twoOpt(*route); }
+    twoOpt(target);
+}
@@ -0,0 +1,316 @@
+#include "SaturationManager.h"
+#include "OnPhone.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace sc2;
+
+/**
+ * @brief Checks if a unit is a mineral field that still has minerals.
+ *
+ * @param unit The unit to check
+ * @return true if the unit can be mined, false otherwise
+ */
+static bool IsMineable(const Unit &unit) {
+    return (unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD
+            || unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750
+            || unit.unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD
+            || unit.unit_type == UNIT_TYPEID::NEUTRAL_RICHMINERALFIELD750)
+           && unit.mineral_contents != 0;
+}
+
+/**
+ * @brief Checks if a unit is a finished extractor that still has vespene.
+ *
+ * @param unit The unit to check
+ * @return true if the extractor can be harvested, false otherwise
+ */
+static bool IsHarvestable(const Unit &unit) {
+    return unit.unit_type == UNIT_TYPEID::ZERG_EXTRACTOR && unit.build_progress >= 1.0f
+           && unit.vespene_contents != 0;
+}
+
+/**
+ * @brief Checks if a worker is carrying resources back to a town hall.
+ *
+ * @param worker The worker to check
+ * @return true if the worker is returning cargo, false otherwise
+ */
+static bool IsReturning(const Unit &worker) {
+    return !worker.orders.empty() && worker.orders.front().ability_id == ABILITY_ID::HARVEST_RETURN;
+}
+
+SaturationManager::SaturationManager(OnPhone &bot) : bot(bot) {};
+
+/**
+ * @brief Requests a rebalance on the next update, e.g. when a base finished.
+ */
+void SaturationManager::markDirty() { dirty = true; }
+
+/**
+ * @brief Rebalances the workers over the bases when needed.
+ *
+ * Runs every SATURATION_INTERVAL game loops, or on the next step after a
+ * base or extractor finished or a resource was mined out.
+ */
+void SaturationManager::update() {
+    gameLoop = bot.Observation()->GetGameLoop();
+    if(!dirty && gameLoop < nextUpdate) { return; }
+    refreshBases();
+    balanceGas();
+    balanceMinerals();
+    nextUpdate = gameLoop + SATURATION_INTERVAL;
+    dirty = false;
+}
+
+/**
+ * @brief Picks the mineral field a worker should mine.
+ *
+ * Workers mine at their home base, the base they were last sent to or else
+ * the closest base by ground distance. The field with the fewest gatherers
+ * is picked, closest to the town hall first. If the base is mined out, the
+ * field closest to the start location is picked instead. The gatherers are
+ * counted once per step and the worker is counted on the picked field, so
+ * many workers woken in the same step spread over the fields.
+ *
+ * @param worker The worker to find a mineral field for
+ * @return const Unit* The mineral field to mine, nullptr if there is none
+ */
+const Unit *SaturationManager::mineralFor(const Unit *worker) {
+    refreshMinerals();
+    const Units &minerals = ledger.fields();
+    if(minerals.empty()) { return nullptr; }
+    const Base *base = homeOf(worker);
+    std::size_t pick = base == nullptr ? GEOMETRY_NONE : ledger.pick(worker, base->townHall->pos);
+    if(pick == GEOMETRY_NONE) {
+        const Point2D start = bot.startLoc;
+        pick = std::min_element(minerals.begin(), minerals.end(),
+                                [this, &start](const Unit *a, const Unit *b) {
+                                    return bot.baseDistances.closer(a->pos, b->pos, start);
+                                })
+               - minerals.begin();
+    }
+    ledger.assign(worker, pick);
+    return minerals[pick];
+}
+
+/**
+ * @brief Picks the extractor a worker should harvest from.
+ *
+ * @param worker The worker to find an extractor for
+ * @return const Unit* The closest extractor below its ideal count, nullptr if there is none
+ */
+const Unit *SaturationManager::extractorFor(const Unit *worker) const {
+    const Unit *closest = nullptr;
+    for(const auto *unit : bot.selfUnits) {
+        if(!IsHarvestable(*unit) || unit->assigned_harvesters >= unit->ideal_harvesters) {
+            continue;
+        }
+        if(closest == nullptr || bot.baseDistances.closer(unit->pos, closest->pos, worker->pos)) {
+            closest = unit;
+        }
+    }
+    return closest;
+}
+
+/**
+ * @brief Collects the finished town halls with their mineral occupancy.
+ *
+ * Drones still on their way to a base are counted as assigned there, so the
+ * same deficit is not filled twice while they travel.
+ */
+void SaturationManager::refreshBases() {
+    for(auto it = transfers.begin(); it != transfers.end();) {
+        it = it->second.arrives <= gameLoop ? transfers.erase(it) : std::next(it);
+    }
+    bases.clear();
+    for(const auto *hall : bot.selfUnits) {
+        if(!IsTownHall(hall->unit_type) || hall->build_progress < 1.0f) { continue; }
+        bases.push_back({hall, hall->assigned_harvesters + incoming(hall->tag),
+                         hall->ideal_harvesters});
+    }
+}
+
+/**
+ * @brief Counts the gatherers of the mineable fields, once per step.
+ */
+void SaturationManager::refreshMinerals() {
+    const ObservationInterface *observation = bot.Observation();
+    if(observation->GetGameLoop() == ledgerLoop) { return; }
+    ledgerLoop = observation->GetGameLoop();
+    minerals.clear();
+    for(const auto *unit : bot.neutralUnits) {
+        if(IsMineable(*unit)) { minerals.push_back(unit); }
+    }
+    drones.clear();
+    for(const auto *unit : bot.selfUnits) {
+        if(unit->unit_type == UNIT_TYPEID::ZERG_DRONE) { drones.push_back(unit); }
+    }
+    ledger.reset(minerals, drones);
+}
+
+/**
+ * @brief Keeps as many workers on gas as the finished extractors can take.
+ *
+ * Missing gas workers are pulled from the mineral workers closest to the
+ * extractor, and workers of mined out extractors go back to minerals.
+ */
+void SaturationManager::balanceGas() {
+    extractors.clear();
+    for(const auto *unit : bot.selfUnits) {
+        if(IsHarvestable(*unit)) { extractors.push_back(unit); }
+    }
+    int wanted = 0;
+    for(const auto *extractor : extractors) { wanted += extractor->ideal_harvesters; }
+    int current = 0;
+    for(const auto &worker : bot.Workers->units) {
+        if(worker.unitTask == TASK::EXTRACT) { ++current; }
+    }
+
+    for(auto &worker : bot.Workers->units) {
+        if(current <= wanted) { break; }
+        if(worker.unitTask != TASK::EXTRACT) { continue; }
+        worker.unitTask = TASK::MINE;
+        bot.events.wake(worker.unit->tag, EventDispatcher::TASK_CHANGED);
+        --current;
+    }
+
+    // Mining workers that can be sent, with their positions in the same order
+    std::vector<AllyUnit *> candidates;
+    PointSet positions;
+    for(auto &worker : bot.Workers->units) {
+        if(worker.unitTask != TASK::MINE || worker.unit == nullptr || IsReturning(*worker.unit)) {
+            continue;
+        }
+        candidates.push_back(&worker);
+        positions.push_back(worker.unit->pos);
+    }
+    for(const auto *extractor : extractors) {
+        int missing = std::min(extractor->ideal_harvesters - extractor->assigned_harvesters,
+                               wanted - current);
+        while(missing-- > 0) {
+            const std::size_t pick = Nearest(positions, extractor->pos);
+            if(pick == GEOMETRY_NONE) { return; }
+            AllyUnit *closest = candidates[pick];
+            candidates[pick] = candidates.back();
+            candidates.pop_back();
+            positions.erase(pick);
+            closest->unitTask = TASK::EXTRACT;
+            home.erase(closest->unit->tag);
+            transfers.erase(closest->unit->tag);
+            bot.Actions()->UnitCommand(closest->unit, ABILITY_ID::SMART, extractor);
+            bot.events.wake(closest->unit->tag, EventDispatcher::TASK_CHANGED);
+            ++current;
+        }
+    }
+}
+
+/**
+ * @brief Moves surplus mineral workers to bases below their ideal count.
+ *
+ * The closest pair of oversaturated and undersaturated bases by ground
+ * distance is balanced first, at most SATURATION_BATCH drones at a time, so
+ * drones spend as little time as possible walking instead of mining. Mined
+ * out bases have an ideal count of 0, so all their drones are surplus.
+ */
+void SaturationManager::balanceMinerals() {
+    while(true) {
+        Base *donor = nullptr;
+        Base *receiver = nullptr;
+        float shortest = std::numeric_limits<float>::max();
+        for(auto &from : bases) {
+            if(from.assigned <= from.ideal) { continue; }
+            for(auto &to : bases) {
+                if(to.assigned >= to.ideal) { continue; }
+                const float distance
+                  = bot.baseDistances.between(from.townHall->pos, to.townHall->pos);
+                if(distance < shortest) {
+                    shortest = distance;
+                    donor = &from;
+                    receiver = &to;
+                }
+            }
+        }
+        if(donor == nullptr) { return; }
+
+        const int batch = std::min(std::min(donor->assigned - donor->ideal,
+                                            receiver->ideal - receiver->assigned),
+                                   SATURATION_BATCH);
+        // Drones without cargo move first, so no minerals are carried away from the base
+        FrameVector<const Unit *> candidates{ArenaAllocator<const Unit *>(bot.arena)};
+        for(const auto &worker : bot.Workers->units) {
+            if(worker.unitTask == TASK::MINE && worker.unit != nullptr
+               && transfers.count(worker.unit->tag) == 0 && homeOf(worker.unit) == donor) {
+                candidates.push_back(worker.unit);
+            }
+        }
+        std::stable_partition(candidates.begin(), candidates.end(),
+                              [](const Unit *unit) { return !IsReturning(*unit); });
+        const int moved = std::min(batch, static_cast<int>(candidates.size()));
+        for(int i = 0; i < moved; ++i) { transfer(candidates[i]->tag, *receiver); }
+        // Workers the group does not know about cannot be moved, stop counting them as surplus
+        donor->assigned = moved < batch ? donor->ideal : donor->assigned - moved;
+        receiver->assigned += moved;
+    }
+}
+
+/**
+ * @brief Sends a drone to mine at another base.
+ *
+ * @param worker The tag of the drone to move
+ * @param to The base the drone mines at from now on
+ */
+void SaturationManager::transfer(Tag worker, const Base &to) {
+    const Unit *unit = bot.Observation()->GetUnit(worker);
+    if(unit == nullptr) { return; }
+    home[worker] = to.townHall->tag;
+    const float distance = std::max(bot.baseDistances.between(unit->pos, to.townHall->pos),
+                                    Distance2D(unit->pos, to.townHall->pos));
+    transfers[worker] = {to.townHall->tag,
+                         gameLoop + static_cast<uint32_t>(distance / DRONE_SPEED_PER_LOOP)};
+    const Unit *mineral = mineralFor(unit);
+    if(mineral != nullptr) { bot.Actions()->UnitCommand(unit, ABILITY_ID::SMART, mineral); }
+    bot.events.wake(worker, EventDispatcher::TASK_CHANGED);
+    LOG_INFO_LIMITED(5, "Moving drone to base at (%g, %g)", to.townHall->pos.x,
+                     to.townHall->pos.y);
+}
+
+/**
+ * @brief Gets the base a worker mines at.
+ *
+ * @param worker The worker to look up
+ * @return Base* The base the worker was sent to, else the closest base, nullptr without bases
+ */
+SaturationManager::Base *SaturationManager::homeOf(const Unit *worker) {
+    if(bases.empty()) { refreshBases(); }
+    auto it = home.find(worker->tag);
+    if(it != home.end()) {
+        for(auto &base : bases) {
+            if(base.townHall->tag == it->second) { return &base; }
+        }
+        home.erase(it);
+    }
+    Base *closest = nullptr;
+    for(auto &base : bases) {
+        if(closest == nullptr
+           || bot.baseDistances.closer(base.townHall->pos, closest->townHall->pos, worker->pos)) {
+            closest = &base;
+        }
+    }
+    return closest;
+}
+
+/**
+ * @brief Counts the drones on their way to a base.
+ *
+ * @param townHall The tag of the town hall of the base
+ * @return int The number of drones sent there that have not arrived yet
+ */
+int SaturationManager::incoming(Tag townHall) const {
+    int count = 0;
+    for(const auto &entry : transfers) {
+        if(entry.second.townHall == townHall) { ++count; }
+    }
+    return count;
+}
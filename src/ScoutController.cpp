@@ -1,6 +1,12 @@
 #include "OnPhone.h"
 
-ScoutController::ScoutController(OnPhone &bot) : UnitController(bot) {};
+#include <limits>
+
+ScoutController::ScoutController(OnPhone &bot)
+    : UnitController(bot, EventDispatcher::CREATED | EventDispatcher::IDLE
+                            | EventDispatcher::DAMAGED | EventDispatcher::TASK_CHANGED
+                            | EventDispatcher::ENEMY_SEEN | EventDispatcher::UPGRADED
+                            | EventDispatcher::ATTACK_STARTED) {};
 
 /**
  * @brief Steps the scout unit.
@@ -20,10 +26,13 @@ void ScoutController::step(AllyUnit &unit) {
 };
 
 /**
- * @brief Scouts the next base location.
+ * @brief Scouts the next base location on the route of the scout.
  *
- * This function moves the scout unit to the next base location in the list
- * of base locations.
+ * This function moves the scout unit to the next base location of its own
+ * route, so several scouts split the bases between them. Bases that were
+ * seen within the last ROUTE_REVISIT_LOOPS game loops are skipped, unless
+ * all of them were, then the scout goes to the stalest stop of its route.
+ * A scout whose route has no stops is sent anywhere on the map by the scheduler.
  *
  * @param unit The scout unit to move
  */
@@ -31,16 +40,42 @@ void ScoutController::scoutBase(AllyUnit &unit) {
     if(bot.controller.attack_controller.isAttacking && unit.unit != nullptr
        && unit.unit->orders.empty()) {
         if(base_locations.empty()) { initializeBaseLocations(); }
-        unit.group->index = (unit.group->index + 1) % base_locations.size();
-        bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, base_locations[unit.group->index]);
+        RoutePlanner &routes = unit.unit->is_flying ? airRoutes : groundRoutes;
+        if(!routes.has(unit.unit->tag)) { routes.addScout(unit.unit->tag, unit.unit->pos); }
+        // More scouts than bases leave some without a stop, they take the stalest waypoints
+        if(routes.length(unit.unit->tag) == 0) {
+            scoutAll(unit);
+            return;
+        }
+        const uint32_t gameLoop = bot.Observation()->GetGameLoop();
+        Point2D target;
+        Point2D stalest;
+        uint32_t stalestSeen = std::numeric_limits<uint32_t>::max();
+        bool found = false;
+        for(std::size_t i = 0; i < routes.length(unit.unit->tag) && !found; ++i) {
+            if(!routes.next(unit.unit->tag, target)) { break; }
+            const uint32_t seen
+              = scheduler.lastSeen(static_cast<int>(target.x), static_cast<int>(target.y));
+            found = seen == 0 || gameLoop - seen >= ROUTE_REVISIT_LOOPS;
+            if(seen < stalestSeen) {
+                stalestSeen = seen;
+                stalest = target;
+            }
+        }
+        // Every stop was seen recently, an idle scout is not woken again so it goes on anyway
+        if(!found && routes.length(unit.unit->tag) > 0) {
+            target = stalest;
+            found = true;
+        }
+        if(found) { bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, target); }
     }
 };
 
 /**
- * @brief Scouts all base locations.
+ * @brief Scouts the stalest location anywhere on the map.
  *
- * This function moves the scout unit to all base locations in the list
- * of base locations.
+ * This function moves the scout unit to the waypoint or base location the
+ * scheduler scores best for it.
  *
  * @param unit The scout unit to move
  */
@@ -48,8 +83,10 @@ void ScoutController::scoutAll(AllyUnit &unit) {
     if(all_locations.empty()) { initializeAllLocations(); }
     if(bot.controller.attack_controller.isAttacking && unit.unit != nullptr
        && unit.unit->orders.empty()) {
-        unit.group->index = (unit.group->index + 1) % all_locations.size();
-        bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, all_locations[unit.group->index]);
+        Point2D target;
+        if(scheduler.assign(unit.unit->tag, unit.unit->pos, ScoutScheduler::WAYPOINT, target)) {
+            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, target);
+        }
     }
 };
 
@@ -71,6 +108,7 @@ void ScoutController::scoutFast(AllyUnit &unit) {
                                        fast_locations[unit.group->index]);
         } else {
             unit.unitTask = TASK::SCOUT;
+            bot.events.wake(unit.unit->tag, EventDispatcher::TASK_CHANGED);
         }
     }
 };
@@ -84,24 +122,16 @@ void ScoutController::scoutFast(AllyUnit &unit) {
  * @param unit The scout unit under attack
  */
 void ScoutController::underAttack(AllyUnit &unit) {
-    Point2D priorPos = unit.priorPos;
-    float minDist = std::numeric_limits<float>::max();
+    Point2D priorPos = unit.unit != nullptr ? bot.frameDelta.priorPos(unit.unit->tag) : Point2D();
     Point2D closestPoint;
-    std::vector<Point2D> locations;
     if(unit.unitTask == TASK::FAST_SCOUT) {
         if(fast_locations.empty()) { initializeFastLocations(); }
-        locations = fast_locations;
-        for(const auto &location : locations) {
-            float dist = DistanceSquared2D(location, priorPos);
-            if(dist < minDist) {
-                minDist = dist;
-                closestPoint = location;
-            }
-        }
+        const std::size_t closest = Nearest(fast_positions, priorPos);
+        if(closest != GEOMETRY_NONE) { closestPoint = fast_locations[closest]; }
         if(this->foundEnemyLocation.x == 0 && this->foundEnemyLocation.y == 0) {
             this->foundEnemyLocation = closestPoint;
-            std::cout << "Enemy base found at (VIA BEING ATTACKED) (" << foundEnemyLocation.x
-                      << ", " << foundEnemyLocation.y << ")\n";
+            LOG_INFO("Enemy base found at (VIA BEING ATTACKED) (%g, %g)", foundEnemyLocation.x,
+                     foundEnemyLocation.y);
         }
     }
     if(all_locations.empty()) { initializeAllLocations(); }
@@ -119,6 +149,19 @@ void ScoutController::underAttack(AllyUnit &unit) {
  */
 void ScoutController::onDeath(AllyUnit &unit) {};
 
+/**
+ * @brief Releases the scheduler target and route of a scout that died.
+ *
+ * The remaining scouts of the same kind take over the stops of its route.
+ *
+ * @param tag The tag of the scout
+ */
+void ScoutController::release(Tag tag) {
+    scheduler.release(tag);
+    airRoutes.removeScout(tag);
+    groundRoutes.removeScout(tag);
+}
+
 /**
  * @brief Initializes the fast scout locations.
  *
@@ -127,10 +170,11 @@ void ScoutController::onDeath(AllyUnit &unit) {};
  */
 void ScoutController::initializeFastLocations() {
     const auto &gameInfo = bot.Observation()->GetGameInfo();
-    std::cout << "Enemy Base possible locations:\n";
+    LOG_INFO("Enemy Base possible locations:");
     for(const auto &location : gameInfo.enemy_start_locations) {
         fast_locations.push_back(location);
-        std::cout << "(" << location.x << ", " << location.y << ")\n";
+        fast_positions.push_back(location);
+        LOG_INFO("(%g, %g)", location.x, location.y);
     }
 }
 
@@ -138,7 +182,8 @@ void ScoutController::initializeFastLocations() {
  * @brief Initializes all possible locations for scouting.
  *
  * This function initializes all possible locations for scouting by
- * identifying the reachable waypoints on the map.
+ * identifying the reachable waypoints on the map, and adds them as
+ * scheduler targets.
  */
 void ScoutController::initializeAllLocations() {
     const GameInfo &game_info = bot.Observation()->GetGameInfo();
@@ -154,45 +199,38 @@ void ScoutController::initializeAllLocations() {
             }
         }
     }
+    for(const auto &location : all_locations) {
+        scheduler.addTarget(location, ScoutScheduler::WAYPOINT);
+    }
 };
 
 /**
  * @brief Initializes the base locations for scouting.
  *
  * This function initializes the base locations for scouting by
- * identifying the enemy base location and other possible base locations.
+ * identifying the enemy base location and other possible base locations,
+ * adds them as scheduler targets and computes the air and ground distances
+ * between them for the scout routes.
  */
 void ScoutController::initializeBaseLocations() {
     Point2D enemyLocation = bot.enemyLoc;
-    base_locations.push_back(enemyLocation);
-
-    const auto &units = bot.Observation()->GetUnits(Unit::Alliance::Neutral, [](const Unit &unit) {
-        return unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD
-               || unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750
-               || unit.unit_type == UNIT_TYPEID::NEUTRAL_VESPENEGEYSER;
-    });
-
-    std::map<unsigned int, unsigned int> clusterSize;
-
-    for(const auto *unit : units) {
-        bool added_to_cluster = false;
-
-        // Compare this resource to existing clusters
-        for(unsigned int i = 0; i < base_locations.size(); ++i) {
-            if(DistanceSquared2D(unit->pos, base_locations[i])
-               < CLUSTER_DISTANCE * CLUSTER_DISTANCE) { // Within range
-                base_locations[i]
-                  = (base_locations[i] * clusterSize[i] + unit->pos) / (++clusterSize[i]);
-                added_to_cluster = true;
-                break;
-            }
-        }
-
-        if(!added_to_cluster) { base_locations.push_back(unit->pos); }
-    }
+    const auto &units = bot.Observation()->GetUnits(
+      Unit::Alliance::Neutral, [](const Unit &unit) { return IsResource(unit); });
+    base_locations = FindResourceClusters(units, {enemyLocation});
 
     std::sort(base_locations.begin(), base_locations.end(),
-              [&enemyLocation](const Point2D &a, const Point2D &b) {
-                  return DistanceSquared2D(a, enemyLocation) < DistanceSquared2D(b, enemyLocation);
+              [this, &enemyLocation](const Point2D &a, const Point2D &b) {
+                  return bot.baseDistances.closer(a, b, enemyLocation);
               });
+
+    std::vector<Point2D> stops;
+    for(const auto &location : base_locations) {
+        if(location.x == 0 && location.y == 0) { continue; }
+        const bool enemyBase = location.x == enemyLocation.x && location.y == enemyLocation.y;
+        scheduler.addTarget(location,
+                            enemyBase ? ScoutScheduler::ENEMY_BASE : ScoutScheduler::BASE);
+        stops.push_back(location);
+    }
+    airRoutes.initialize(stops, DistanceMatrix::air(stops));
+    groundRoutes.initialize(stops, DistanceMatrix::ground(stops, bot.pathingGrid));
 }
\ No newline at end of file
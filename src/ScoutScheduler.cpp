@@ -0,0 +1,290 @@
+#include "ScoutScheduler.h"
+
+#include <limits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+using namespace sc2;
+
+static const std::size_t NONE = std::numeric_limits<std::size_t>::max();
+static const float TIER_WEIGHTS[ScoutScheduler::TIER_COUNT]
+  = {SCOUT_WAYPOINT_WEIGHT, SCOUT_BASE_WEIGHT, SCOUT_ENEMY_BASE_WEIGHT};
+
+/**
+ * @brief Gets the index of the lowest set bit of a non-zero word.
+ *
+ * @param word The word to scan
+ * @return int The index of the lowest set bit
+ */
+static inline int LowestBit(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+/**
+ * @brief Sets up the last seen grid for a map.
+ *
+ * @param width The width of the map
+ * @param height The height of the map
+ */
+void ScoutScheduler::initialize(int width, int height) {
+    this->width = width;
+    this->height = height;
+    seenAt.assign(static_cast<std::size_t>(width) * height, 0);
+    visible = BitGrid(width, height);
+    targetCells = BitGrid(width, height);
+}
+
+/**
+ * @brief Adds a scouting target.
+ *
+ * Targets outside the map or on a cell that already holds a target are ignored.
+ *
+ * @param pos The position to scout
+ * @param tier The strategic weight of the position
+ */
+void ScoutScheduler::addTarget(const Point2D &pos, TIER tier) {
+    const int x = static_cast<int>(pos.x);
+    const int y = static_cast<int>(pos.y);
+    if(x < 0 || y < 0 || x >= width || y >= height || targetCells.get(x, y)) { return; }
+    const std::size_t cell = static_cast<std::size_t>(y) * width + x;
+    targetCells.set(x, y);
+    targetAt[cell] = targets.size();
+    targets.push_back({pos, cell, tier, lastSeen(x, y), visible.get(x, y), NONE});
+    push(targets.size() - 1);
+}
+
+/**
+ * @brief Updates the last seen grid from the visibility map.
+ *
+ * Only the cells whose visibility changed since the last update are touched:
+ * cells that left vision are stamped with the current game loop and targets
+ * that entered or left vision are resifted in their heap.
+ *
+ * @param observation The current observation
+ */
+void ScoutScheduler::update(const ObservationInterface *observation) {
+    const auto &image = observation->GetRawObservation()->raw_data().map_state().visibility();
+    BitGrid current = BitGrid::decodeValue(image.data(), image.size().x(), image.size().y(), 2);
+    if(current.width != width || current.height != height) { return; }
+    gameLoop = observation->GetGameLoop();
+
+    for(int y = 0; y < height; ++y) {
+        const uint64_t *before = visible.row(y);
+        const uint64_t *after = current.row(y);
+        const uint64_t *marked = targetCells.row(y);
+        for(int i = 0; i < GRID_ROW_WORDS; ++i) {
+            const uint64_t changed = before[i] ^ after[i];
+            if(changed == 0) { continue; }
+            for(uint64_t left = changed & before[i]; left != 0; left &= left - 1) {
+                const int x = i * 64 + LowestBit(left);
+                seenAt[static_cast<std::size_t>(y) * width + x] = gameLoop;
+            }
+            for(uint64_t hits = changed & marked[i]; hits != 0; hits &= hits - 1) {
+                const int x = i * 64 + LowestBit(hits);
+                const std::size_t index = targetAt[static_cast<std::size_t>(y) * width + x];
+                targets[index].visible = ((after[i] >> (x & 63)) & 1) != 0;
+                targets[index].seen = gameLoop;
+                sift(index);
+            }
+        }
+    }
+    visible = std::move(current);
+}
+
+/**
+ * @brief Gives a scout the best unclaimed target for its position.
+ *
+ * The SCOUT_CANDIDATES stalest targets of every tier from minTier up are scored
+ * by staleness times strategic weight, reduced with distance to the scout.
+ * The chosen target is claimed until the scout asks again or is released.
+ *
+ * @param scout The tag of the scout
+ * @param from The position of the scout
+ * @param minTier The lowest tier of targets to consider
+ * @param target The position of the assigned target
+ * @return true if a target was assigned, false if every target is visible or claimed
+ */
+bool ScoutScheduler::assign(Tag scout, const Point2D &from, TIER minTier, Point2D &target) {
+    release(scout);
+    std::size_t best = NONE;
+    float bestScore = 0.0f;
+    for(int tier = minTier; tier < TIER_COUNT; ++tier) {
+        const std::vector<std::size_t> &heap = heaps[tier];
+        frontier.assign(heap.empty() ? 0 : 1, 0);
+        for(int n = 0; n < SCOUT_CANDIDATES && !frontier.empty(); ++n) {
+            // Walk the heap in key order, the next stalest target is always on the frontier
+            std::size_t pick = 0;
+            for(std::size_t f = 1; f < frontier.size(); ++f) {
+                if(key(heap[frontier[f]]) < key(heap[frontier[pick]])) { pick = f; }
+            }
+            const std::size_t index = frontier[pick];
+            frontier[pick] = frontier.back();
+            frontier.pop_back();
+            if(2 * index + 1 < heap.size()) { frontier.push_back(2 * index + 1); }
+            if(2 * index + 2 < heap.size()) { frontier.push_back(2 * index + 2); }
+
+            const Target &candidate = targets[heap[index]];
+            if(candidate.visible) { break; }
+            const float staleness = static_cast<float>(gameLoop - candidate.seen + 1);
+            const float distance = Distance2D(from, candidate.pos);
+            const float score
+              = TIER_WEIGHTS[tier] * staleness / (1.0f + distance / SCOUT_DISTANCE_SCALE);
+            if(score > bestScore) {
+                bestScore = score;
+                best = heap[index];
+            }
+        }
+    }
+    if(best == NONE) { return false; }
+    remove(best);
+    claims[scout] = best;
+    target = targets[best].pos;
+    return true;
+}
+
+/**
+ * @brief Releases the target claimed by a scout, e.g. when it died.
+ *
+ * @param scout The tag of the scout
+ */
+void ScoutScheduler::release(Tag scout) {
+    auto it = claims.find(scout);
+    if(it == claims.end()) { return; }
+    push(it->second);
+    claims.erase(it);
+}
+
+/**
+ * @brief Gets the game loop a cell was last seen on.
+ *
+ * @param x The column of the cell
+ * @param y The row of the cell
+ * @return uint32_t The current game loop if the cell is visible, 0 if it was never seen
+ */
+uint32_t ScoutScheduler::lastSeen(int x, int y) const {
+    if(x < 0 || y < 0 || x >= width || y >= height) { return 0; }
+    if(visible.get(x, y)) { return gameLoop; }
+    return seenAt[static_cast<std::size_t>(y) * width + x];
+}
+
+/**
+ * @brief Checks if any targets were added.
+ *
+ * @return true if there are no targets, false otherwise
+ */
+bool ScoutScheduler::empty() const { return targets.empty(); }
+
+/**
+ * @brief Gets the heap key of a target, visible targets sink to the bottom.
+ *
+ * @param target The index of the target
+ * @return uint32_t The key, smaller is staler
+ */
+uint32_t ScoutScheduler::key(std::size_t target) const {
+    return targets[target].visible ? std::numeric_limits<uint32_t>::max() : targets[target].seen;
+}
+
+/**
+ * @brief Inserts a target into the heap of its tier.
+ *
+ * @param target The index of the target
+ */
+void ScoutScheduler::push(std::size_t target) {
+    std::vector<std::size_t> &heap = heaps[targets[target].tier];
+    heap.push_back(target);
+    targets[target].heapIndex = heap.size() - 1;
+    siftUp(heap, heap.size() - 1);
+}
+
+/**
+ * @brief Removes a target from the heap of its tier.
+ *
+ * @param target The index of the target
+ */
+void ScoutScheduler::remove(std::size_t target) {
+    const std::size_t index = targets[target].heapIndex;
+    if(index == NONE) { return; }
+    std::vector<std::size_t> &heap = heaps[targets[target].tier];
+    const std::size_t last = heap.back();
+    heap.pop_back();
+    targets[target].heapIndex = NONE;
+    if(index < heap.size()) {
+        place(heap, index, last);
+        if(!siftUp(heap, index)) { siftDown(heap, index); }
+    }
+}
+
+/**
+ * @brief Restores the heap order after the key of a target changed.
+ *
+ * Claimed targets are not in a heap and are left alone.
+ *
+ * @param target The index of the target
+ */
+void ScoutScheduler::sift(std::size_t target) {
+    const std::size_t index = targets[target].heapIndex;
+    if(index == NONE) { return; }
+    std::vector<std::size_t> &heap = heaps[targets[target].tier];
+    if(!siftUp(heap, index)) { siftDown(heap, index); }
+}
+
+/**
+ * @brief Moves an entry up until its parent is not staler.
+ *
+ * @param heap The heap to restore
+ * @param index The position of the entry
+ * @return true if the entry moved, false otherwise
+ */
+bool ScoutScheduler::siftUp(std::vector<std::size_t> &heap, std::size_t index) {
+    const std::size_t target = heap[index];
+    const uint32_t value = key(target);
+    const std::size_t start = index;
+    while(index > 0) {
+        const std::size_t parent = (index - 1) / 2;
+        if(key(heap[parent]) <= value) { break; }
+        place(heap, index, heap[parent]);
+        index = parent;
+    }
+    place(heap, index, target);
+    return index != start;
+}
+
+/**
+ * @brief Moves an entry down until its children are not staler.
+ *
+ * @param heap The heap to restore
+ * @param index The position of the entry
+ */
+void ScoutScheduler::siftDown(std::vector<std::size_t> &heap, std::size_t index) {
+    const std::size_t target = heap[index];
+    const uint32_t value = key(target);
+    while(true) {
+        std::size_t child = 2 * index + 1;
+        if(child >= heap.size()) { break; }
+        if(child + 1 < heap.size() && key(heap[child + 1]) < key(heap[child])) { ++child; }
+        if(key(heap[child]) >= value) { break; }
+        place(heap, index, heap[child]);
+        index = child;
+    }
+    place(heap, index, target);
+}
+
+/**
+ * @brief Stores a target at a heap position and records the position.
+ *
+ * @param heap The heap to store into
+ * @param index The position in the heap
+ * @param target The index of the target
+ */
+void ScoutScheduler::place(std::vector<std::size_t> &heap, std::size_t index, std::size_t target) {
+    heap[index] = target;
+    targets[target].heapIndex = index;
+}
@@ -0,0 +1,288 @@
+#include "SquadClusterer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace sc2;
+
+static const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * @brief Sets up the cell grid for a map, cells are SQUAD_RADIUS wide.
+ *
+ * @param width The width of the map
+ * @param height The height of the map
+ */
+void SquadClusterer::initialize(int width, int height) {
+    cellsX = static_cast<int>(width / SQUAD_RADIUS) + 1;
+    cellsY = static_cast<int>(height / SQUAD_RADIUS) + 1;
+    cellStart.assign(static_cast<std::size_t>(cellsX) * cellsY + 1, 0);
+}
+
+/**
+ * @brief Splits the army into squads.
+ *
+ * Units with at least SQUAD_MIN_UNITS units within SQUAD_RADIUS are core
+ * units, core units within SQUAD_RADIUS of each other share a squad and the
+ * other units join the squad of their closest core unit in range. Units far
+ * from any core unit, e.g. a reinforcement on its way, are squads of their own.
+ * Units are bucketed into SQUAD_RADIUS wide cells, so only the 3x3 cells
+ * around a unit are searched and the clustering takes linear time for any
+ * army that does not stack on one spot.
+ *
+ * @param army The units to split, all alive
+ * @param unitData The unit type data of the game, for the squad strength
+ * @param arena The frame arena, for the scratch memory of this update
+ */
+void SquadClusterer::update(const Units &army, const UnitTypes &unitData, FrameArena &arena) {
+    previous.clear();
+    for(const auto &squad : squads) { previous.push_back(squad.id); }
+    if(cellsX != 0 && !army.empty()) {
+        bucket(army);
+        label(army);
+        identify(arena);
+        for(auto &squad : squads) { measure(squad, unitData); }
+    } else {
+        squads.clear();
+    }
+    memberOf.clear();
+    for(std::size_t i = 0; i < squads.size(); ++i) {
+        for(const auto *unit : squads[i].members) {
+            memberOf.push_back({unit->tag, static_cast<uint32_t>(i)});
+        }
+    }
+    std::sort(memberOf.begin(), memberOf.end());
+}
+
+/**
+ * @brief Gets the squad of a unit.
+ *
+ * @param tag The tag of the unit
+ * @return Squad* The squad, nullptr if the unit was not in the army at the last update
+ */
+Squad *SquadClusterer::of(Tag tag) {
+    auto it = std::lower_bound(memberOf.begin(), memberOf.end(), std::make_pair(tag, 0u));
+    return it == memberOf.end() || it->first != tag ? nullptr : &squads[it->second];
+}
+
+/**
+ * @brief Gets the squad with the highest strength, the one the others regroup with.
+ *
+ * @return const Squad* The strongest squad, nullptr if there are no squads
+ */
+const Squad *SquadClusterer::strongest() const {
+    const Squad *best = nullptr;
+    for(const auto &squad : squads) {
+        if(best == nullptr || squad.strength > best->strength) { best = &squad; }
+    }
+    return best;
+}
+
+/**
+ * @brief Finds the union-find root of a core unit, halving the path on the way.
+ *
+ * @param unit The index of the unit
+ * @return uint32_t The index of the root unit
+ */
+uint32_t SquadClusterer::root(uint32_t unit) {
+    while(parent[unit] != unit) {
+        parent[unit] = parent[parent[unit]];
+        unit = parent[unit];
+    }
+    return unit;
+}
+
+/**
+ * @brief Puts two core units into the same squad.
+ *
+ * @param a The index of the first unit
+ * @param b The index of the second unit
+ */
+void SquadClusterer::unite(uint32_t a, uint32_t b) {
+    a = root(a);
+    b = root(b);
+    if(a != b) { parent[std::max(a, b)] = std::min(a, b); }
+}
+
+/**
+ * @brief Sorts the units by grid cell with a counting sort.
+ *
+ * @param army The units to sort
+ */
+void SquadClusterer::bucket(const Units &army) {
+    const std::size_t cells = cellStart.size() - 1;
+    std::fill(cellStart.begin(), cellStart.end(), 0);
+    cellOf.resize(army.size());
+    for(std::size_t i = 0; i < army.size(); ++i) {
+        const int x = std::min(std::max(static_cast<int>(army[i]->pos.x / SQUAD_RADIUS), 0),
+                               cellsX - 1);
+        const int y = std::min(std::max(static_cast<int>(army[i]->pos.y / SQUAD_RADIUS), 0),
+                               cellsY - 1);
+        cellOf[i] = static_cast<uint32_t>(y * cellsX + x);
+        ++cellStart[cellOf[i] + 1];
+    }
+    for(std::size_t c = 0; c < cells; ++c) { cellStart[c + 1] += cellStart[c]; }
+    cellUnits.resize(army.size());
+    // Placing a unit advances the start of its cell, which leaves every start at the next cell
+    for(std::size_t i = 0; i < army.size(); ++i) {
+        cellUnits[cellStart[cellOf[i]]++] = static_cast<uint32_t>(i);
+    }
+    for(std::size_t c = cells; c > 0; --c) { cellStart[c] = cellStart[c - 1]; }
+    cellStart[0] = 0;
+}
+
+/**
+ * @brief Calls a function for every unit within SQUAD_RADIUS of a unit, itself included.
+ *
+ * @param army The bucketed units
+ * @param unit The index of the unit to search around
+ * @param visit Called with the index of each unit in range and its squared distance
+ */
+template <typename Visit>
+void SquadClusterer::neighbors(const Units &army, uint32_t unit, Visit visit) {
+    const int x = static_cast<int>(cellOf[unit] % cellsX);
+    const int y = static_cast<int>(cellOf[unit] / cellsX);
+    const Point2D pos = army[unit]->pos;
+    for(int cy = std::max(y - 1, 0); cy <= std::min(y + 1, cellsY - 1); ++cy) {
+        for(int cx = std::max(x - 1, 0); cx <= std::min(x + 1, cellsX - 1); ++cx) {
+            const std::size_t cell = static_cast<std::size_t>(cy) * cellsX + cx;
+            for(uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                const uint32_t other = cellUnits[k];
+                const float distance = DistanceSquared2D(pos, army[other]->pos);
+                if(distance <= SQUAD_RADIUS * SQUAD_RADIUS) { visit(other, distance); }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Groups the bucketed units into squads.
+ *
+ * The squads of the last update are refilled, so their member lists keep
+ * their capacity.
+ *
+ * @param army The bucketed units
+ */
+void SquadClusterer::label(const Units &army) {
+    const uint32_t n = static_cast<uint32_t>(army.size());
+    parent.resize(n);
+    core.assign(n, 0);
+    for(uint32_t i = 0; i < n; ++i) {
+        parent[i] = i;
+        int count = 0;
+        neighbors(army, i, [&count](uint32_t, float) { ++count; });
+        core[i] = count >= SQUAD_MIN_UNITS;
+    }
+    for(uint32_t i = 0; i < n; ++i) {
+        if(!core[i]) { continue; }
+        neighbors(army, i, [this, i](uint32_t other, float) {
+            if(other > i && core[other]) { unite(i, other); }
+        });
+    }
+
+    squadAt.assign(n, NONE);
+    uint32_t count = 0;
+    for(uint32_t i = 0; i < n; ++i) {
+        uint32_t owner = core[i] ? i : NONE;
+        float closest = std::numeric_limits<float>::max();
+        if(owner == NONE) {
+            neighbors(army, i, [this, &owner, &closest](uint32_t other, float distance) {
+                if(core[other] && distance < closest) {
+                    closest = distance;
+                    owner = other;
+                }
+            });
+        }
+        // Units without a core unit in range are indexed by themselves, they are never a root
+        const uint32_t key = owner == NONE ? i : root(owner);
+        if(squadAt[key] == NONE) {
+            squadAt[key] = count;
+            if(count == squads.size()) { squads.emplace_back(); }
+            squads[count].members.clear();
+            squads[count].task = TASK::UNSET;
+            ++count;
+        }
+        squads[squadAt[key]].members.push_back(army[i]);
+    }
+    squads.resize(count);
+}
+
+/**
+ * @brief Gives every new squad the id of the old squad most of its units came from.
+ *
+ * Larger squads pick first, so when a squad splits its larger part keeps the
+ * id, and when squads merge the new squad keeps the id of the larger share.
+ * Squads made of new units get a new id. The squads are ordered by id after.
+ *
+ * @param arena The frame arena, for the vote counts
+ */
+void SquadClusterer::identify(FrameArena &arena) {
+    FrameVector<uint32_t> order(squads.size(), 0, ArenaAllocator<uint32_t>(arena));
+    for(uint32_t i = 0; i < order.size(); ++i) { order[i] = i; }
+    // Ties by index, as a stable sort would take a heap buffer
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        const std::size_t sizeA = squads[a].members.size();
+        const std::size_t sizeB = squads[b].members.size();
+        return sizeA != sizeB ? sizeA > sizeB : a < b;
+    });
+    FrameVector<uint8_t> claimed(previous.size(), 0, ArenaAllocator<uint8_t>(arena));
+    // Votes per old squad, and the old squads voted for so only those are reset
+    FrameVector<uint32_t> votes(previous.size(), 0, ArenaAllocator<uint32_t>(arena));
+    FrameVector<uint32_t> voted{ArenaAllocator<uint32_t>(arena)};
+    for(const auto index : order) {
+        Squad &squad = squads[index];
+        for(const auto *unit : squad.members) {
+            auto it = std::lower_bound(memberOf.begin(), memberOf.end(),
+                                       std::make_pair(unit->tag, 0u));
+            if(it == memberOf.end() || it->first != unit->tag) { continue; }
+            if(votes[it->second]++ == 0) { voted.push_back(it->second); }
+        }
+        uint32_t best = NONE;
+        uint32_t most = 0;
+        for(const auto old : voted) {
+            if(!claimed[old] && (votes[old] > most || (votes[old] == most && old < best))) {
+                most = votes[old];
+                best = old;
+            }
+            votes[old] = 0;
+        }
+        voted.clear();
+        if(best != NONE) {
+            claimed[best] = 1;
+            squad.id = previous[best];
+        } else {
+            squad.id = nextId++;
+        }
+    }
+    std::sort(squads.begin(), squads.end(),
+              [](const Squad &a, const Squad &b) { return a.id < b.id; });
+}
+
+/**
+ * @brief Computes the centroid, strength and spread of a squad.
+ *
+ * @param squad The squad to measure
+ * @param unitData The unit type data of the game
+ */
+void SquadClusterer::measure(Squad &squad, const UnitTypes &unitData) const {
+    Point2D sum(0.0f, 0.0f);
+    squad.strength = 0.0f;
+    for(const auto *unit : squad.members) {
+        sum += unit->pos;
+        const uint32_t type = static_cast<uint32_t>(unit->unit_type.ToType());
+        if(type < unitData.size() && !unitData[type].weapons.empty()) {
+            // Weapon speed is the cooldown in seconds
+            const Weapon &weapon = unitData[type].weapons.front();
+            const float dps = weapon.speed > 0.0f ? weapon.damage_ * weapon.attacks / weapon.speed
+                                                  : 0.0f;
+            squad.strength += dps * (unit->health + unit->shield);
+        }
+    }
+    squad.centroid = sum / static_cast<float>(squad.members.size());
+    float spread = 0.0f;
+    for(const auto *unit : squad.members) {
+        spread += DistanceSquared2D(unit->pos, squad.centroid);
+    }
+    squad.spread = std::sqrt(spread / squad.members.size());
+}
@@ -0,0 +1,141 @@
+#include "StepBudget.h"
+
+#include <algorithm>
+
+static const float SHARES[] = {1.0f, 1.0f, STEP_BUDGET_NORMAL_SHARE, STEP_BUDGET_LOW_SHARE};
+
+/**
+ * @brief Registers a subsystem whose work the budget schedules.
+ *
+ * @param name The name of the subsystem, for the log
+ * @param priority How late in the budget its work may still start
+ * @param estimate The expected cost of its work in milliseconds, refined as it runs
+ * @return std::size_t The id to run the work with
+ */
+std::size_t StepBudget::add(const char *name, PRIORITY priority, float estimate) {
+    tasks.push_back({name, priority, estimate, 0, 0, 0});
+    return tasks.size() - 1;
+}
+
+/**
+ * @brief Starts the clock of a new step.
+ */
+void StepBudget::begin() { started = std::chrono::steady_clock::now(); }
+
+/**
+ * @brief Runs the work of a subsystem if the budget has room for it.
+ *
+ * Critical work always runs and high priority work runs unless the step is
+ * already over its ceiling. Other work runs if its estimated cost still fits
+ * into the share of the ceiling its priority may use, or if it was deferred
+ * STEP_BUDGET_MAX_WAIT steps in a row, so it is delayed but never starved.
+ *
+ * @param task The id of the subsystem
+ * @param work The work of the subsystem for this step
+ * @return true if the work ran, false if it was deferred
+ */
+bool StepBudget::run(std::size_t task, const std::function<void()> &work) {
+    Task &entry = tasks[task];
+    if(!admit(entry)) {
+        defer(entry);
+        return false;
+    }
+    const float before = elapsed();
+    work();
+    measure(entry, elapsed() - before);
+    entry.waited = 0;
+    ++entry.ran;
+    return true;
+}
+
+/**
+ * @brief Runs chunks of a resumable job for as long as the budget has room.
+ *
+ * Every chunk is admitted like the work in run, so a long analysis is spread
+ * over as many steps as it needs. A job deferred STEP_BUDGET_MAX_WAIT steps in
+ * a row gets one chunk.
+ *
+ * @param task The id of the subsystem
+ * @param chunk Does a bounded part of the job, returns true once the job is done
+ * @return true if the job is done, false if it continues on a later step
+ */
+bool StepBudget::slice(std::size_t task, const std::function<bool()> &chunk) {
+    Task &entry = tasks[task];
+    bool any = false;
+    while(admit(entry)) {
+        const float before = elapsed();
+        const bool done = chunk();
+        measure(entry, elapsed() - before);
+        entry.waited = 0;
+        ++entry.ran;
+        any = true;
+        if(done) { return true; }
+    }
+    if(!any) { defer(entry); }
+    return false;
+}
+
+/**
+ * @brief Records the time the step took.
+ */
+void StepBudget::end() {
+    const float total = elapsed();
+    ++steps;
+    if(total > ceiling) { ++overruns; }
+    worst = std::max(worst, total);
+}
+
+/**
+ * @brief Gets the time spent in the current step.
+ *
+ * @return float The milliseconds since begin
+ */
+float StepBudget::elapsed() const {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - started)
+      .count();
+}
+
+/**
+ * @brief Checks if the work of a subsystem may start now.
+ *
+ * @param task The subsystem
+ * @return true if it is critical, high priority within the ceiling, starving or fits
+ * into its share of the ceiling
+ */
+bool StepBudget::admit(const Task &task) const {
+    if(task.priority == CRITICAL || task.waited >= STEP_BUDGET_MAX_WAIT) { return true; }
+    if(task.priority == HIGH) { return elapsed() < ceiling; }
+    return elapsed() + task.estimate <= ceiling * SHARES[task.priority];
+}
+
+/**
+ * @brief Records that the work of a subsystem was deferred this step.
+ *
+ * The estimate decays while the work waits, so one expensive step does not
+ * keep it deferred until it starves.
+ *
+ * @param task The subsystem
+ */
+void StepBudget::defer(Task &task) {
+    ++task.waited;
+    ++task.deferred;
+    task.estimate -= task.estimate * STEP_BUDGET_DECAY;
+}
+
+/**
+ * @brief Updates the cost estimate of a subsystem with a measured cost.
+ *
+ * A higher cost replaces the estimate at once, so a fight that makes the army
+ * expensive is budgeted for on the next step, and lower costs pull it down
+ * slowly.
+ *
+ * @param task The subsystem
+ * @param cost The measured cost in milliseconds
+ */
+void StepBudget::measure(Task &task, float cost) {
+    if(cost > task.estimate) {
+        task.estimate = cost;
+    } else {
+        task.estimate += (cost - task.estimate) * STEP_BUDGET_DECAY;
+    }
+}
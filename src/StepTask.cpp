@@ -0,0 +1,205 @@
+#include "StepTask.h"
+#include "constants.h"
+
+#include <exception>
+#include <new>
+
+// Frames freed by finished tasks, one list per TASK_FRAME_CLASS bytes of frame size
+struct FreeFrame {
+    FreeFrame *next;
+};
+static FreeFrame *freeFrames[TASK_FRAME_CLASSES] = {};
+
+/**
+ * @brief Gets the free list a frame size is recycled through.
+ *
+ * @param size The size of the coroutine frame
+ * @return std::size_t The index of the free list, TASK_FRAME_CLASSES if the frame is too large
+ */
+static inline std::size_t FrameClass(std::size_t size) {
+    return size == 0 ? 0 : (size - 1) / TASK_FRAME_CLASS;
+}
+
+/**
+ * @brief Creates the task owning a new coroutine frame.
+ *
+ * @return StepTask The task, suspended before its first statement
+ */
+StepTask StepTask::promise_type::get_return_object() {
+    return StepTask(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+/**
+ * @brief Stops the bot on an exception escaping a task, as there is no caller to catch it.
+ */
+void StepTask::promise_type::unhandled_exception() { std::terminate(); }
+
+/**
+ * @brief Allocates a coroutine frame, reusing the frame of a finished task of the same size.
+ *
+ * Tasks are spawned every time a build or research is sent, so frames are
+ * recycled instead of going through the heap every time.
+ *
+ * @param size The size of the coroutine frame
+ * @return void* The frame memory
+ */
+void *StepTask::promise_type::operator new(std::size_t size) {
+    const std::size_t index = FrameClass(size);
+    if(index >= TASK_FRAME_CLASSES) { return ::operator new(size); }
+    if(FreeFrame *frame = freeFrames[index]) {
+        freeFrames[index] = frame->next;
+        return frame;
+    }
+    return ::operator new((index + 1) * TASK_FRAME_CLASS);
+}
+
+/**
+ * @brief Returns a coroutine frame to the free list of its size.
+ *
+ * @param frame The frame memory
+ * @param size The size of the coroutine frame
+ */
+void StepTask::promise_type::operator delete(void *frame, std::size_t size) {
+    const std::size_t index = FrameClass(size);
+    if(index >= TASK_FRAME_CLASSES) {
+        ::operator delete(frame);
+        return;
+    }
+    FreeFrame *free = static_cast<FreeFrame *>(frame);
+    free->next = freeFrames[index];
+    freeFrames[index] = free;
+}
+
+StepTask::StepTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+StepTask::StepTask(StepTask &&other) noexcept : handle(other.release()) {}
+
+StepTask &StepTask::operator=(StepTask &&other) noexcept {
+    if(this != &other) {
+        if(handle) { handle.destroy(); }
+        handle = other.release();
+    }
+    return *this;
+}
+
+/**
+ * @brief Destroys the coroutine if the task was never spawned.
+ */
+StepTask::~StepTask() {
+    if(handle) { handle.destroy(); }
+}
+
+/**
+ * @brief Hands the coroutine over, e.g. to a scheduler.
+ *
+ * @return std::coroutine_handle<StepTask::promise_type> The coroutine, empty if already released
+ */
+std::coroutine_handle<StepTask::promise_type> StepTask::release() {
+    std::coroutine_handle<promise_type> result = handle;
+    handle = nullptr;
+    return result;
+}
+
+/**
+ * @brief Checks if the game loop to sleep until was already reached.
+ *
+ * @return true if the task continues without suspending, false otherwise
+ */
+bool TaskScheduler::Sleep::await_ready() const { return loop <= scheduler.gameLoop; }
+
+/**
+ * @brief Queues the task for the game loop it sleeps until.
+ *
+ * @param task The suspended task
+ */
+void TaskScheduler::Sleep::await_suspend(std::coroutine_handle<> task) {
+    scheduler.push(loop, task, nullptr);
+}
+
+/**
+ * @brief Destroys the tasks still suspended, running the destructors of their locals.
+ */
+TaskScheduler::~TaskScheduler() { clear(); }
+
+/**
+ * @brief Starts a task, it runs up to its first suspension on the next resume.
+ *
+ * @param task The task to run
+ */
+void TaskScheduler::spawn(StepTask task) {
+    const std::coroutine_handle<> handle = task.release();
+    if(handle) { push(gameLoop, handle, nullptr); }
+}
+
+/**
+ * @brief Runs the tasks that are due, called once per step.
+ *
+ * Tasks sleeping until a later game loop stay in the heap untouched. Tasks
+ * waiting for a condition are resumed once it holds or their timeout passed,
+ * and queued for the next step otherwise. Finished tasks are destroyed.
+ *
+ * @param gameLoop The current game loop
+ */
+void TaskScheduler::resume(uint32_t gameLoop) {
+    this->gameLoop = gameLoop;
+    while(!queue.empty() && queue.top().loop <= gameLoop) {
+        const Entry entry = queue.top();
+        queue.pop();
+        if(entry.waiting != nullptr) {
+            entry.waiting->met = entry.waiting->check(entry.waiting->condition);
+            if(!entry.waiting->met && gameLoop < entry.waiting->deadline) {
+                push(gameLoop + 1, entry.task, entry.waiting);
+                continue;
+            }
+        }
+        entry.task.resume();
+        if(entry.task.done()) { entry.task.destroy(); }
+    }
+}
+
+/**
+ * @brief Destroys every task, e.g. when a new game starts.
+ */
+void TaskScheduler::clear() {
+    while(!queue.empty()) {
+        const std::coroutine_handle<> task = queue.top().task;
+        queue.pop();
+        task.destroy();
+    }
+}
+
+/**
+ * @brief Gets the number of tasks that did not finish yet.
+ *
+ * @return std::size_t The number of suspended tasks
+ */
+std::size_t TaskScheduler::size() const { return queue.size(); }
+
+/**
+ * @brief Suspends a task for a number of game loops.
+ *
+ * @param loops The game loops to wait, 0 continues right away
+ * @return TaskScheduler::Sleep The awaitable
+ */
+TaskScheduler::Sleep TaskScheduler::sleep(uint32_t loops) { return {*this, after(loops)}; }
+
+/**
+ * @brief Gets the game loop a number of loops from now.
+ *
+ * @param loops The number of game loops
+ * @return uint32_t The game loop, saturated at the largest loop
+ */
+uint32_t TaskScheduler::after(uint32_t loops) const {
+    return loops > UINT32_MAX - gameLoop ? UINT32_MAX : gameLoop + loops;
+}
+
+/**
+ * @brief Queues a suspended task for a game loop.
+ *
+ * @param loop The game loop to resume the task on
+ * @param task The suspended task
+ * @param waiting The condition the task waits for, nullptr if it only waits for the loop
+ */
+void TaskScheduler::push(uint32_t loop, std::coroutine_handle<> task, Waiting *waiting) {
+    queue.push({loop, suspensions++, task, waiting});
+}
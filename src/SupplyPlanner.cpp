@@ -0,0 +1,122 @@
+#include "SupplyPlanner.h"
+
+#include <algorithm>
+
+using namespace sc2;
+
+static const uint32_t SUPPLY_HORIZON = OVERLORD_BUILD_LOOPS + SUPPLY_LEAD_LOOPS;
+
+/**
+ * @brief Records an overlord that was ordered from a larva.
+ *
+ * @param gameLoop The game loop the overlord was ordered on
+ */
+void SupplyPlanner::ordered(uint32_t gameLoop) {
+    overlords.push_back(gameLoop + OVERLORD_BUILD_LOOPS);
+}
+
+/**
+ * @brief Records an overlord that hatched, its supply is now part of the cap.
+ *
+ * Eggs hatch in the order they were started, so the oldest one is dropped.
+ */
+void SupplyPlanner::overlordCreated() {
+    if(!overlords.empty()) { overlords.pop_front(); }
+}
+
+/**
+ * @brief Records a hatchery that started construction.
+ *
+ * Finished hatcheries, like the starting one, are already part of the cap and are ignored.
+ *
+ * @param hatchery The hatchery
+ * @param gameLoop The current game loop
+ */
+void SupplyPlanner::hatcheryStarted(const Unit *hatchery, uint32_t gameLoop) {
+    if(hatchery->build_progress >= 1.0f) { return; }
+    const float remaining = (1.0f - hatchery->build_progress) * HATCHERY_BUILD_LOOPS;
+    hatcheries[hatchery->tag] = gameLoop + static_cast<uint32_t>(remaining);
+}
+
+/**
+ * @brief Stops tracking a hatchery that finished or was destroyed.
+ *
+ * @param hatchery The tag of the hatchery
+ */
+void SupplyPlanner::hatcheryFinished(Tag hatchery) { hatcheries.erase(hatchery); }
+
+/**
+ * @brief Gets the supply that overlords and hatcheries in progress add within a horizon.
+ *
+ * @param horizon The number of game loops to look ahead
+ * @return int The supply added to the cap by then
+ */
+int SupplyPlanner::incoming(uint32_t horizon) const {
+    int supply = static_cast<int>(overlords.size()) * OVERLORD_SUPPLY;
+    for(const auto &entry : hatcheries) {
+        if(entry.second <= gameLoop + horizon) { supply += HATCHERY_SUPPLY; }
+    }
+    return supply;
+}
+
+/**
+ * @brief Projects the supply used one overlord build time ahead.
+ *
+ * The supply that can be added is bounded by the minerals banked and mined
+ * over the horizon and by the larva the hatcheries can have, the waiting
+ * larva plus the spawned and injected ones. Units in eggs are already in the
+ * used supply.
+ *
+ * @param foodUsed The supply used now
+ * @param hatcheries The number of finished hatcheries
+ * @param injected The number of hatcheries a queen injects
+ * @param income The income forecast
+ * @return int The expected supply used at the horizon
+ */
+int SupplyPlanner::projected(int foodUsed, int hatcheries, int injected,
+                             const IncomeModel &income) const {
+    const float mineralFood = std::max(0.0f, income.project(SUPPLY_HORIZON).minerals)
+                              / SUPPLY_MINERALS_PER_FOOD;
+    const float horizon = static_cast<float>(SUPPLY_HORIZON);
+    const float larvaFood = hatcheries * (LARVA_NATURAL_MAX + horizon / LARVA_SPAWN_LOOPS)
+                            + injected * INJECT_LARVA * horizon / INJECT_DURATION_LOOPS;
+    return foodUsed + static_cast<int>(std::min(mineralFood, larvaFood));
+}
+
+/**
+ * @brief Gets the number of overlords to order now to avoid a supply block.
+ *
+ * The supply used one overlord build time ahead is compared with the cap
+ * including the overlords and hatcheries that finish by then. Overlords are
+ * only asked for once an overlord ordered now would be just in time, so no
+ * minerals are tied up early.
+ *
+ * @param gameLoop The current game loop
+ * @param foodUsed The supply used now
+ * @param foodCap The supply cap now
+ * @param hatcheries The number of finished hatcheries
+ * @param injected The number of hatcheries a queen injects
+ * @param income The income forecast
+ * @return int The number of overlords to order, 0 if the cap covers the horizon
+ */
+int SupplyPlanner::needed(uint32_t gameLoop, int foodUsed, int foodCap, int hatcheries,
+                          int injected, const IncomeModel &income) {
+    expire(gameLoop);
+    const int cap = std::min(SUPPLY_MAX, foodCap + incoming(SUPPLY_HORIZON));
+    if(cap >= SUPPLY_MAX) { return 0; }
+    const int shortfall = projected(foodUsed, hatcheries, injected, income) - cap;
+    if(shortfall < 0) { return 0; }
+    return shortfall / OVERLORD_SUPPLY + 1;
+}
+
+/**
+ * @brief Drops overlord eggs that should have hatched long ago, they were killed.
+ *
+ * @param gameLoop The current game loop
+ */
+void SupplyPlanner::expire(uint32_t gameLoop) {
+    this->gameLoop = gameLoop;
+    while(!overlords.empty() && overlords.front() + SUPPLY_PENDING_SLACK < gameLoop) {
+        overlords.pop_front();
+    }
+}
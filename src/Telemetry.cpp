@@ -0,0 +1,150 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+
+using namespace sc2;
+
+/**
+ * @brief Preallocates every column so sampling never allocates during a game.
+ */
+Telemetry::Telemetry() {
+    for(auto *column : {&minerals, &vespene, &foodUsed, &foodCap, &idleLarva, &workers, &bases,
+                        &armySupply}) {
+        column->reserve(TELEMETRY_MAX_SAMPLES);
+    }
+    loop.reserve(TELEMETRY_MAX_SAMPLES);
+    actions.reserve(TELEMETRY_MAX_SAMPLES);
+    collectedMinerals.reserve(TELEMETRY_MAX_SAMPLES);
+    mineralForecast.reserve(TELEMETRY_MAX_SAMPLES);
+    blockedLoops.reserve(TELEMETRY_MAX_SAMPLES);
+}
+
+/**
+ * @brief Checks if a sample should be taken on this game loop.
+ *
+ * @param gameLoop The current game loop
+ * @return true if a sample is due and there is room for it, false otherwise
+ */
+bool Telemetry::due(uint32_t gameLoop) const {
+    return gameLoop >= nextSample && loop.size() < TELEMETRY_MAX_SAMPLES;
+}
+
+/**
+ * @brief Adds the number of commanded units to the current sample interval.
+ *
+ * @param actions The number of units that were sent commands
+ */
+void Telemetry::countActions(std::size_t actions) {
+    pendingActions += static_cast<uint32_t>(actions);
+}
+
+/**
+ * @brief Adds the game loops since the last step to the current sample interval if
+ * supply is blocked.
+ *
+ * Counted every step rather than sampled, so short blocks between samples are not missed.
+ *
+ * @param gameLoop The current game loop
+ * @param foodUsed The supply used
+ * @param foodCap The supply cap
+ */
+void Telemetry::countSupply(uint32_t gameLoop, int foodUsed, int foodCap) {
+    if(foodUsed >= foodCap && foodCap < SUPPLY_MAX) { pendingBlocked += gameLoop - lastLoop; }
+    lastLoop = gameLoop;
+}
+
+/**
+ * @brief Records one row of economic counters.
+ *
+ * @param observation The current observation
+ * @param bases The number of completed hatcheries
+ * @param mineralRate The forecast mineral income per game loop
+ */
+void Telemetry::sample(const ObservationInterface *observation, int bases, float mineralRate) {
+    const uint32_t gameLoop = observation->GetGameLoop();
+    loop.push_back(gameLoop);
+    minerals.push_back(observation->GetMinerals());
+    vespene.push_back(observation->GetVespene());
+    foodUsed.push_back(observation->GetFoodUsed());
+    foodCap.push_back(observation->GetFoodCap());
+    idleLarva.push_back(observation->GetLarvaCount());
+    workers.push_back(observation->GetFoodWorkers());
+    this->bases.push_back(bases);
+    armySupply.push_back(observation->GetFoodArmy());
+    actions.push_back(pendingActions);
+    collectedMinerals.push_back(observation->GetScore().score_details.collected_minerals);
+    mineralForecast.push_back(mineralRate * LOOPS_PER_SECOND * 60.0f);
+    blockedLoops.push_back(pendingBlocked);
+    pendingActions = 0;
+    pendingBlocked = 0;
+    nextSample = gameLoop + TELEMETRY_INTERVAL;
+}
+
+/**
+ * @brief Gets the number of recorded samples.
+ *
+ * @return std::size_t The number of rows in every column
+ */
+std::size_t Telemetry::size() const { return loop.size(); }
+
+/**
+ * @brief Gets a printable name of a race.
+ *
+ * @param race The race to name
+ * @return const char* The lower case race name
+ */
+static const char *RaceName(Race race) {
+    switch(race) {
+    case Race::Terran: return "terran";
+    case Race::Protoss: return "protoss";
+    case Race::Zerg: return "zerg";
+    default: return "random";
+    }
+}
+
+/**
+ * @brief Writes all samples of the game as a CSV file.
+ *
+ * The file is named after the map, the opponent race and the wall clock time, and
+ * starts with a comment line describing the game for scripts/telemetry-summary.sh.
+ *
+ * @param directory The directory to write the file to
+ * @param observation The final observation of the game
+ * @param result The result of the game (Won/Lost/Tied)
+ * @return true if the file was written, false otherwise
+ */
+bool Telemetry::write(const std::string &directory, const ObservationInterface *observation,
+                      const std::string &result) const {
+    const GameInfo &gameInfo = observation->GetGameInfo();
+    std::string map = gameInfo.map_name;
+    std::replace_if(map.begin(), map.end(), [](char c) { return !isalnum(c); }, '_');
+    const char *race = "random";
+    for(const auto &player : gameInfo.player_info) {
+        if(player.player_id != observation->GetPlayerID()) { race = RaceName(player.race_actual); }
+    }
+    const std::string path = directory + "/" + map + "-" + race + "-"
+                             + std::to_string(static_cast<long long>(std::time(nullptr))) + ".csv";
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if(file == nullptr) { return false; }
+
+    std::fprintf(file, "# map=%s race=%s result=%s loops=%u\n", map.c_str(), race, result.c_str(),
+                 observation->GetGameLoop());
+    std::fprintf(file, "loop,minerals,vespene,food_used,food_cap,idle_larva,workers,bases,"
+                       "workers_per_base,army_supply,actions,apm,collected_minerals,"
+                       "forecast_minerals_per_minute,supply_blocked_loops\n");
+    for(std::size_t i = 0; i < loop.size(); ++i) {
+        const uint32_t interval = i == 0 ? loop[i] : loop[i] - loop[i - 1];
+        const float minutes = interval / LOOPS_PER_SECOND / 60.0f;
+        const float apm = minutes > 0 ? actions[i] / minutes : 0.0f;
+        const float workersPerBase = bases[i] > 0 ? static_cast<float>(workers[i]) / bases[i] : 0;
+        std::fprintf(file, "%u,%d,%d,%d,%d,%d,%d,%d,%.2f,%d,%u,%.1f,%.0f,%.1f,%u\n", loop[i],
+                     minerals[i], vespene[i], foodUsed[i], foodCap[i], idleLarva[i], workers[i],
+                     bases[i], workersPerBase, armySupply[i], actions[i], apm,
+                     collectedMinerals[i], mineralForecast[i], blockedLoops[i]);
+    }
+    std::fclose(file);
+    return true;
+}
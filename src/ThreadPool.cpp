@@ -0,0 +1,133 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param threads The number of workers, at least one is started
+ */
+ThreadPool::ThreadPool(unsigned threads) {
+    threads = std::max(1u, threads);
+    for(unsigned i = 0; i < threads; ++i) { queues.emplace_back(new Queue()); }
+    for(unsigned i = 0; i < threads; ++i) { workers.emplace_back(&ThreadPool::work, this, i); }
+}
+
+/**
+ * @brief Stops and joins the worker threads.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for(auto &worker : workers) { worker.join(); }
+}
+
+/**
+ * @brief Runs a task for every index and waits until all of them are done.
+ *
+ * @param count The number of indices
+ * @param task The task to run for every index, called from the worker threads
+ */
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &task) {
+    parallelFor(count, 1, [&task](std::size_t i, unsigned) { task(i); });
+}
+
+/**
+ * @brief Runs a task for every index and waits until all of them are done.
+ *
+ * The indices are split into ranges that are dealt out to the worker queues.
+ * Workers run their own ranges newest first and steal the oldest ranges of
+ * other workers when they run out, so uneven task times balance out. Loops
+ * of at most grain indices are not worth waking the workers for and run on
+ * the calling thread as worker 0.
+ *
+ * @param count The number of indices
+ * @param grain The fewest indices per range
+ * @param task The task to run for every index and the worker running it
+ */
+void ThreadPool::parallelFor(std::size_t count, std::size_t grain,
+                             const std::function<void(std::size_t, unsigned)> &task) {
+    if(count == 0) { return; }
+    if(count <= grain) {
+        for(std::size_t i = 0; i < count; ++i) { task(i, 0); }
+        return;
+    }
+    const std::size_t chunk
+      = std::max<std::size_t>(grain, count / (queues.size() * POOL_RANGES_PER_WORKER));
+    std::unique_lock<std::mutex> lock(mutex);
+    remaining = count;
+    std::size_t queue = 0;
+    for(std::size_t begin = 0; begin < count; begin += chunk) {
+        std::lock_guard<std::mutex> queueLock(queues[queue]->mutex);
+        queues[queue]->ranges.push_back({begin, std::min(count, begin + chunk), &task});
+        queue = (queue + 1) % queues.size();
+    }
+    ++epoch;
+    wake.notify_all();
+    done.wait(lock, [this] { return remaining == 0; });
+}
+
+/**
+ * @brief Gets the number of worker threads.
+ *
+ * @return unsigned The number of workers
+ */
+unsigned ThreadPool::size() const { return static_cast<unsigned>(workers.size()); }
+
+/**
+ * @brief Runs ranges until the pool stops, sleeping while there is no work.
+ *
+ * @param self The index of the worker
+ */
+void ThreadPool::work(unsigned self) {
+    uint64_t seen = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return stopping || epoch != seen; });
+            if(stopping) { return; }
+            seen = epoch;
+        }
+        Range range;
+        while(pop(self, range)) {
+            for(std::size_t i = range.begin; i < range.end; ++i) { (*range.task)(i, self); }
+            const std::size_t ran = range.end - range.begin;
+            if(remaining.fetch_sub(ran) == ran) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Takes the next range, from the worker's own queue or stolen from another.
+ *
+ * @param self The index of the worker
+ * @param range The range to run
+ * @return true if a range was taken, false if every queue is empty
+ */
+bool ThreadPool::pop(unsigned self, Range &range) {
+    {
+        Queue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.ranges.empty()) {
+            range = own.ranges.back();
+            own.ranges.pop_back();
+            return true;
+        }
+    }
+    for(std::size_t i = 1; i < queues.size(); ++i) {
+        Queue &other = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if(!other.ranges.empty()) {
+            range = other.ranges.front();
+            other.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -1,6 +1,6 @@
 #include "OnPhone.h"
 
-UnitController::UnitController(OnPhone &bot) : bot(bot) {};
+UnitController::UnitController(OnPhone &bot, uint8_t wakeMask) : bot(bot), wakeMask(wakeMask) {};
 
 /**
  * @brief Handles an ally unit being under attack.
@@ -11,17 +11,31 @@ UnitController::UnitController(OnPhone &bot) : bot(bot) {};
  */
 void UnitController::underAttack(AllyUnit &unit) {};
 
+/**
+ * @brief Checks whether an ally unit needs to be stepped this step.
+ *
+ * Controllers without a wake mask step every unit, the others only step units
+ * that received one of their subscribed events from the EventDispatcher.
+ *
+ * @param unit The ally unit to check
+ * @return true if the unit should be stepped, false otherwise
+ */
+bool UnitController::awake(const AllyUnit &unit) const {
+    if(wakeMask == 0) { return true; }
+    return unit.unit != nullptr && (bot.events.reasons(unit.unit->tag) & wakeMask) != 0;
+}
+
 /**
  * @brief Executes the base step for an ally unit.
  *
  * This function executes the base step for an ally unit, which is common to all unit roles.
- * It calls the appropriate step function based on whether the unit is currently
- * under attack or not.
+ * It calls the appropriate step function based on whether the unit took damage
+ * in the last frame delta or not.
  *
  * @param unit The ally unit to step
  */
 void UnitController::base_step(AllyUnit &unit) {
-    if(unit.underAttack()) {
+    if(unit.unit != nullptr && bot.frameDelta.test(unit.unit->tag, FrameDelta::DAMAGED)) {
         underAttack(unit);
     } else {
         step(unit);
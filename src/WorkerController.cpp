@@ -1,18 +1,46 @@
 #include "OnPhone.h"
 
-WorkerController::WorkerController(OnPhone &bot) : UnitController(bot) {};
+WorkerController::WorkerController(OnPhone &bot)
+    : UnitController(bot, EventDispatcher::CREATED | EventDispatcher::IDLE
+                            | EventDispatcher::DAMAGED | EventDispatcher::TASK_CHANGED) {};
+
+/**
+ * @brief Checks whether a worker needs to be stepped this step.
+ *
+ * Workers are only stepped when they are woken, unless there is a threat near
+ * our base that they have to respond to.
+ *
+ * @param unit The worker unit to check
+ * @return true if the worker should be stepped, false otherwise
+ */
+bool WorkerController::awake(const AllyUnit &unit) const {
+    if(most_dangerous_all != nullptr) { return true; }
+    if(bot.controller.attack_controller.isAttacking && most_dangerous_ground != nullptr) {
+        return true;
+    }
+    return UnitController::awake(unit);
+}
 
 /**
  * @brief Steps the worker unit.
  *
  * This function steps the worker unit by executing the appropriate action
- * based on the unit's current task.
+ * based on the unit's current task. Queens on their way to inject and drones
+ * on their way to build are left alone.
  *
  * @param unit The worker unit to step
  */
 void WorkerController::step(AllyUnit &unit) {
+    // Builders are driven by the drone dispatcher, an attack order would drop their build
+    if(unit.unitTask == TASK::BUILD) { return; }
     if(unit.unit != nullptr) {
-        if(unit.unit->unit_type.ToType() == sc2::UNIT_TYPEID::ZERG_QUEEN && most_dangerous_all) {
+        const bool queen = unit.unit->unit_type.ToType() == sc2::UNIT_TYPEID::ZERG_QUEEN;
+        // Injects are timed by the inject scheduler, so a queen finishes hers before fighting
+        if(queen && !unit.unit->orders.empty()
+           && unit.unit->orders.front().ability_id == ABILITY_ID::EFFECT_INJECTLARVA) {
+            return;
+        }
+        if(queen && most_dangerous_all) {
             bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::ATTACK, most_dangerous_all);
         } else if(bot.controller.attack_controller.isAttacking && most_dangerous_ground) {
             bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::ATTACK, most_dangerous_ground);
@@ -29,8 +57,8 @@ void WorkerController::step(AllyUnit &unit) {
 /**
  * @brief Extracts resources from the nearest extractor.
  *
- * This function extracts resources from the nearest extractor by issuing
- * a smart command to the worker unit.
+ * This function extracts resources from the closest extractor that still
+ * needs workers by issuing a smart command to the worker unit.
  *
  * @param unit The worker unit to extract resources
  */
@@ -49,27 +77,19 @@ void WorkerController::extract(AllyUnit &unit) {
         }
     }
     if(!is_extracting) {
-        auto extractors = bot.Observation()->GetUnits(Unit::Alliance::Self, [](const Unit &unit) {
-            return unit.unit_type == UNIT_TYPEID::ZERG_EXTRACTOR
-                   && unit.assigned_harvesters < unit.ideal_harvesters;
-        });
-        if(!extractors.empty()) {
-            Point3D starting_base = bot.Observation()->GetStartLocation();
-            std::sort(extractors.begin(), extractors.end(),
-                      [&starting_base](const Unit *a, const Unit *b) {
-                          return DistanceSquared2D(a->pos, starting_base)
-                                 < DistanceSquared2D(b->pos, starting_base);
-                      });
-            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, extractors[0]);
+        const Unit *extractor = bot.saturation.extractorFor(unit.unit);
+        if(extractor != nullptr) {
+            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, extractor);
         }
     }
 };
 
 /**
- * @brief Mines resources from the nearest mineral field.
+ * @brief Mines resources from a mineral field of the worker's base.
  *
- * This function mines resources from the nearest mineral field by issuing
- * a smart command to the worker unit.
+ * This function mines resources from the least occupied mineral field of the
+ * base the saturation manager assigned the worker to by issuing a smart
+ * command to the worker unit.
  *
  * @param unit The worker unit to mine resources
  */
@@ -92,38 +112,9 @@ void WorkerController::mine(AllyUnit &unit) {
         }
     }
     if(!is_extracting) {
-        auto minerals = bot.Observation()->GetUnits(Unit::Alliance::Neutral, [](const Unit &unit) {
-            return (unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD
-                    || unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750)
-                   && unit.mineral_contents != 0;
-        });
-
-        if(!minerals.empty()) {
-            Point3D starting_base = bot.Observation()->GetStartLocation();
-
-            std::sort(minerals.begin(), minerals.end(),
-                      [&starting_base](const Unit *a, const Unit *b) {
-                          return DistanceSquared2D(a->pos, starting_base)
-                                 < DistanceSquared2D(b->pos, starting_base);
-                      });
-
-            for(const auto *mineral : minerals) {
-                const auto &workers
-                  = bot.Observation()->GetUnits(Unit::Alliance::Self, [](const Unit &unit) {
-                        return unit.unit_type == UNIT_TYPEID::ZERG_DRONE;
-                    });
-
-                for(const auto *worker : workers) {
-                    for(const auto &order : worker->orders) {
-                        if(order.ability_id == ABILITY_ID::HARVEST_GATHER
-                           && order.target_unit_tag == mineral->tag) {
-                            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, mineral);
-                            return;
-                        }
-                    }
-                }
-            }
-            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, minerals[0]);
+        const Unit *mineral = bot.saturation.mineralFor(unit.unit);
+        if(mineral != nullptr) {
+            bot.Actions()->UnitCommand(unit.unit, ABILITY_ID::SMART, mineral);
         }
     }
 };
@@ -146,40 +137,12 @@ void WorkerController::underAttack(AllyUnit &unit) {};
  */
 void WorkerController::onDeath(AllyUnit &unit) {};
 
-void WorkerController::getMostDangerous() {
-    most_dangerous_all = nullptr;
-    most_dangerous_ground = nullptr;
-    // currently attacks weakest enemy unit
-    Units enemy_units = bot.Observation()->GetUnits(Unit::Alliance::Enemy, [](const Unit &unit) {
-        return unit.unit_type.ToType() != UNIT_TYPEID::INVALID &&  // Valid unit
-               (unit.display_type == Unit::DisplayType::Visible || // Visible or
-                unit.display_type == Unit::DisplayType::Snapshot);
-    });
-    const UnitTypes unit_data = bot.Observation()->GetUnitTypeData();
-    float max_danger_all = std::numeric_limits<float>::lowest();
-    float max_danger_ground = std::numeric_limits<float>::lowest();
-    for(const auto &unit : enemy_units) {
-        UnitTypeData current_unit_data
-          = unit_data.at(static_cast<uint32_t>(unit->unit_type.ToType()));
-        float unit_health = unit->health + unit->shield;
-        float unit_DPS;
-        if(current_unit_data.weapons.data() != nullptr) {
-            unit_DPS = current_unit_data.weapons.data()->damage_
-                       * current_unit_data.weapons.data()->attacks
-                       * current_unit_data.weapons.data()->speed;
-        } else {
-            unit_DPS = 0;
-        }
-        float unit_danger = unit_DPS / (unit_health); // prevent division by 0
-        if(DistanceSquared2D(unit->pos, bot.startLoc) <= BASE_SIZE) {
-            if(unit_danger > max_danger_all) {
-                max_danger_all = unit_danger;
-                most_dangerous_all = unit;
-            }
-            if(!unit->is_flying && unit_danger > max_danger_ground) {
-                max_danger_ground = unit_danger;
-                most_dangerous_ground = unit;
-            }
-        }
-    }
+void WorkerController::getMostDangerous(ThreadPool &pool) {
+    // Enemies inside our main base
+    FindMostDangerous(bot.enemyUnits,
+                      bot.Observation()->GetUnitTypeData(),
+                      [this](const Unit &unit) {
+                          return DistanceSquared2D(unit.pos, bot.startLoc) <= BASE_SIZE;
+                      },
+                      most_dangerous_all, most_dangerous_ground, pool, bot.arena);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "sc2lib/sc2_lib.h"
 #include "sc2utils/sc2_arg_parser.h"
 #include "sc2utils/sc2_manage_process.h"
+#include <cstdlib>
 #include <iostream>
 
 #include "OnPhone.h"
@@ -10,6 +11,10 @@
 // LadderInterface allows the bot to be tested against the built-in AI or
 // played against other bots
 int main(int argc, char *argv[]) {
+    // Optionally keep a binary log, decode it with scripts/decode-log.py
+    if(const char *path = std::getenv("ONPHONE_LOG_BINARY")) {
+        Logger::instance().openBinary(path);
+    }
     RunBot(argc, argv, new OnPhone(), sc2::Race::Zerg);
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include "utilities.h"
 
+#include <algorithm>
+#include <limits>
+#include <unordered_set>
+
 using namespace sc2;
 
 namespace std {
@@ -36,4 +40,220 @@ bool IsBuilding(const Unit &unit) {
          UNIT_TYPEID::ZERG_LURKERDENMP,       UNIT_TYPEID::ZERG_NYDUSCANAL};
 
     return building_types.find(unit.unit_type) != building_types.end();
-}
\ No newline at end of file
+}
+
+/**
+ * Checks if a unit type is a town hall of any race.
+ * @param type The unit type to check
+ * @return true if the unit type is a town hall, false otherwise
+ */
+bool IsTownHall(UNIT_TYPEID type) {
+    switch(type) {
+    case UNIT_TYPEID::TERRAN_COMMANDCENTER:
+    case UNIT_TYPEID::TERRAN_COMMANDCENTERFLYING:
+    case UNIT_TYPEID::TERRAN_ORBITALCOMMAND:
+    case UNIT_TYPEID::TERRAN_ORBITALCOMMANDFLYING:
+    case UNIT_TYPEID::TERRAN_PLANETARYFORTRESS:
+    case UNIT_TYPEID::PROTOSS_NEXUS:
+    case UNIT_TYPEID::ZERG_HATCHERY:
+    case UNIT_TYPEID::ZERG_LAIR:
+    case UNIT_TYPEID::ZERG_HIVE: return true;
+    default: return false;
+    }
+}
+
+/**
+ * Checks if a unit type is a worker of any race.
+ * @param type The unit type to check
+ * @return true if the unit type is a worker, false otherwise
+ */
+bool IsWorker(UNIT_TYPEID type) {
+    switch(type) {
+    case UNIT_TYPEID::TERRAN_SCV:
+    case UNIT_TYPEID::TERRAN_MULE:
+    case UNIT_TYPEID::PROTOSS_PROBE:
+    case UNIT_TYPEID::ZERG_DRONE:
+    case UNIT_TYPEID::ZERG_DRONEBURROWED: return true;
+    default: return false;
+    }
+}
+
+/**
+ * Checks if a unit type can detect cloaked and burrowed units.
+ * @param type The unit type to check
+ * @return true if the unit type is a detector, false otherwise
+ */
+bool IsDetector(UNIT_TYPEID type) {
+    switch(type) {
+    case UNIT_TYPEID::TERRAN_MISSILETURRET:
+    case UNIT_TYPEID::TERRAN_RAVEN:
+    case UNIT_TYPEID::PROTOSS_PHOTONCANNON:
+    case UNIT_TYPEID::PROTOSS_OBSERVER:
+    case UNIT_TYPEID::PROTOSS_OBSERVERSIEGEMODE:
+    case UNIT_TYPEID::ZERG_OVERSEER:
+    case UNIT_TYPEID::ZERG_OVERSEERSIEGEMODE:
+    case UNIT_TYPEID::ZERG_SPORECRAWLER:
+    case UNIT_TYPEID::ZERG_SPORECRAWLERUPROOTED: return true;
+    default: return false;
+    }
+}
+
+/**
+ * Checks if a unit is a mineral field or a vespene geyser.
+ * @param unit The unit to check
+ * @return true if the unit is a resource, false otherwise
+ */
+bool IsResource(const Unit &unit) {
+    return unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD
+           || unit.unit_type == UNIT_TYPEID::NEUTRAL_MINERALFIELD750
+           || unit.unit_type == UNIT_TYPEID::NEUTRAL_VESPENEGEYSER;
+}
+
+/**
+ * Groups resources into clusters, one per base location.
+ * Every resource joins the first cluster within CLUSTER_DISTANCE and moves its
+ * center to the average position, otherwise it starts a new cluster.
+ * @param resources The mineral fields and geysers to group
+ * @param clusters Cluster centers to start from, e.g. a known base
+ * @return The centers of the clusters
+ */
+std::vector<Point2D> FindResourceClusters(const Units &resources, std::vector<Point2D> clusters) {
+    std::vector<unsigned int> clusterSize(clusters.size(), 0);
+    PointSet centers(clusters);
+    for(const auto *unit : resources) {
+        // Compare this resource to existing clusters
+        const std::size_t i = FirstWithin(centers, unit->pos, CLUSTER_DISTANCE);
+        if(i != GEOMETRY_NONE) {
+            clusters[i] = (clusters[i] * clusterSize[i] + unit->pos) / (++clusterSize[i]);
+            centers.set(i, clusters[i]);
+        } else {
+            clusters.push_back(unit->pos);
+            clusterSize.push_back(1);
+            centers.push_back(unit->pos);
+        }
+    }
+    return clusters;
+}
+
+/**
+ * Scans a range of enemies for the ones that deal the most damage per second for their health
+ * and shield, keeping the first on ties. The best units and dangers found so far are updated.
+ * @param first The first enemy to scan
+ * @param last One past the last enemy to scan
+ * @param unitData The unit type data of the game
+ * @param inRange Whether an enemy is close enough to matter
+ * @param all The most dangerous enemy in range so far
+ * @param ground The most dangerous ground enemy in range so far
+ * @param dangerAll The danger of all
+ * @param dangerGround The danger of ground
+ */
+static void ScanMostDangerous(const Unit *const *first, const Unit *const *last,
+                              const UnitTypes &unitData,
+                              const std::function<bool(const Unit &)> &inRange, const Unit *&all,
+                              const Unit *&ground, float &dangerAll, float &dangerGround) {
+    for(; first != last; ++first) {
+        const Unit *unit = *first;
+        if(unit->unit_type.ToType() == UNIT_TYPEID::INVALID
+           || (unit->display_type != Unit::DisplayType::Visible
+               && unit->display_type != Unit::DisplayType::Snapshot)) {
+            continue;
+        }
+        const UnitTypeData &type = unitData.at(static_cast<uint32_t>(unit->unit_type.ToType()));
+        const float unit_DPS = type.weapons.empty() ? 0.0f
+                                                    : type.weapons.front().damage_
+                                                        * type.weapons.front().attacks
+                                                        * type.weapons.front().speed;
+        const float unit_danger = unit_DPS / (unit->health + unit->shield);
+        if(!inRange(*unit)) { continue; }
+        if(unit_danger > dangerAll) {
+            dangerAll = unit_danger;
+            all = unit;
+        }
+        if(!unit->is_flying && unit_danger > dangerGround) {
+            dangerGround = unit_danger;
+            ground = unit;
+        }
+    }
+}
+
+/**
+ * Finds the enemies that deal the most damage per second for their health and shield.
+ * Only valid units that are visible or remembered as a snapshot are considered.
+ * @param enemies The enemy units
+ * @param unitData The unit type data of the game
+ * @param inRange Whether an enemy is close enough to matter
+ * @param all The most dangerous enemy in range, nullptr if there is none
+ * @param ground The most dangerous ground enemy in range, nullptr if there is none
+ */
+void FindMostDangerous(const Units &enemies, const UnitTypes &unitData,
+                       const std::function<bool(const Unit &)> &inRange, const Unit *&all,
+                       const Unit *&ground) {
+    all = nullptr;
+    ground = nullptr;
+    float max_danger_all = std::numeric_limits<float>::lowest();
+    float max_danger_ground = std::numeric_limits<float>::lowest();
+    ScanMostDangerous(enemies.data(), enemies.data() + enemies.size(), unitData, inRange, all,
+                      ground, max_danger_all, max_danger_ground);
+}
+
+/**
+ * Finds the most dangerous enemies like FindMostDangerous, scanning PARALLEL_TARGET_GRAIN
+ * enemies per pool task. The chunk results are merged in order with the same comparison as
+ * the scan, so the result is the same as a serial scan for any number of workers.
+ * @param enemies The enemy units
+ * @param unitData The unit type data of the game, already fetched from the observation
+ * @param inRange Whether an enemy is close enough to matter, called from the pool workers
+ * @param all The most dangerous enemy in range, nullptr if there is none
+ * @param ground The most dangerous ground enemy in range, nullptr if there is none
+ * @param pool The pool to scan on
+ * @param arena The frame arena, for the chunk results
+ */
+void FindMostDangerous(const Units &enemies, const UnitTypes &unitData,
+                       const std::function<bool(const Unit &)> &inRange, const Unit *&all,
+                       const Unit *&ground, ThreadPool &pool, FrameArena &arena) {
+    struct Best {
+        const Unit *all = nullptr;
+        const Unit *ground = nullptr;
+        float dangerAll = std::numeric_limits<float>::lowest();
+        float dangerGround = std::numeric_limits<float>::lowest();
+    };
+    FrameVector<Best> chunks((enemies.size() + PARALLEL_TARGET_GRAIN - 1) / PARALLEL_TARGET_GRAIN,
+                             Best(), ArenaAllocator<Best>(arena));
+    pool.parallelFor(chunks.size(), 1, [&](std::size_t chunk, unsigned) {
+        const std::size_t begin = chunk * PARALLEL_TARGET_GRAIN;
+        const std::size_t end = std::min(enemies.size(), begin + PARALLEL_TARGET_GRAIN);
+        Best &best = chunks[chunk];
+        ScanMostDangerous(enemies.data() + begin, enemies.data() + end, unitData, inRange,
+                          best.all, best.ground, best.dangerAll, best.dangerGround);
+    });
+    Best result;
+    for(const auto &best : chunks) {
+        if(best.all != nullptr && best.dangerAll > result.dangerAll) {
+            result.dangerAll = best.dangerAll;
+            result.all = best.all;
+        }
+        if(best.ground != nullptr && best.dangerGround > result.dangerGround) {
+            result.dangerGround = best.dangerGround;
+            result.ground = best.ground;
+        }
+    }
+    all = result.all;
+    ground = result.ground;
+}
+
+/**
+ * Orders the mineral fields a base could expand to, closest by ground distance first.
+ * The fields of the base itself, within 10 of it, are dropped from the front.
+ * @param minerals The mineral fields, sorted in place
+ * @param distances The ground distances between the key points of the map
+ * @param from The position of the base to expand from
+ */
+void SortExpansionMinerals(Units &minerals, const DistanceMatrix &distances, const Point2D &from) {
+    std::sort(minerals.begin(), minerals.end(), [&distances, &from](const Unit *a, const Unit *b) {
+        return distances.closer(a->pos, b->pos, from);
+    });
+    auto it = std::find_if(minerals.begin(), minerals.end(), [&from](const Unit *mineral) {
+        return Distance2D(mineral->pos, from) > 10.0f;
+    });
+    minerals.erase(minerals.begin(), it);
+}